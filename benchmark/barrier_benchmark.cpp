@@ -0,0 +1,54 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/thread_pool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+
+/**
+ * Measures average time of thread_pool::barrier for each barrier type.
+ * Usage: barrier_benchmark [barriers_count]
+ */
+static double measure_barrier (unsigned int threads_count, barrier_type type, unsigned int barriers_count)
+{
+  thread_pool threads (threads_count);
+  threads.set_barrier_type (type);
+
+  /// Warm up threads
+  threads.execute ([&] (unsigned int thread_id, unsigned int) { threads.barrier (thread_id); });
+
+  const auto begin = std::chrono::high_resolution_clock::now ();
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    for (unsigned int barrier = 0; barrier < barriers_count; barrier++)
+      threads.barrier (thread_id);
+  });
+  const auto end = std::chrono::high_resolution_clock::now ();
+
+  const std::chrono::duration<double, std::nano> duration = end - begin;
+  return duration.count () / barriers_count;
+}
+
+int main (int argc, char *argv[])
+{
+  const unsigned int barriers_count = argc > 1 ? std::stoul (argv[1]) : 100000;
+
+  std::cout << std::setw (8) << "threads"
+            << std::setw (20) << "centralized [ns]"
+            << std::setw (20) << "tree [ns]" << "\n";
+
+  for (unsigned int threads_count: { 8u, 32u, 128u })
+  {
+    const double centralized = measure_barrier (threads_count, barrier_type::centralized, barriers_count);
+    const double tree = measure_barrier (threads_count, barrier_type::combining_tree, barriers_count);
+
+    std::cout << std::setw (8) << threads_count
+              << std::setw (20) << centralized
+              << std::setw (20) << tree << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,47 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/thread_pool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Measures average latency of thread_pool::execute with a tiny capturing action,
+ * which is what small grids pay on every step and every render interval.
+ * Usage: dispatch_benchmark [executes_count]
+ */
+static double measure_dispatch (unsigned int threads_count, unsigned int executes_count)
+{
+  thread_pool threads (threads_count);
+  std::vector<unsigned int> hits (threads_count, 0);
+
+  /// Warm up threads
+  threads.execute ([&] (unsigned int thread_id, unsigned int) { hits[thread_id]++; });
+
+  const auto begin = std::chrono::high_resolution_clock::now ();
+  for (unsigned int execute = 0; execute < executes_count; execute++)
+    threads.execute ([&] (unsigned int thread_id, unsigned int) { hits[thread_id]++; });
+  const auto end = std::chrono::high_resolution_clock::now ();
+
+  const std::chrono::duration<double, std::nano> duration = end - begin;
+  return duration.count () / executes_count;
+}
+
+int main (int argc, char *argv[])
+{
+  const unsigned int executes_count = argc > 1 ? std::stoul (argv[1]) : 100000;
+
+  std::cout << std::setw (8) << "threads"
+            << std::setw (20) << "execute [ns]" << "\n";
+
+  for (unsigned int threads_count: { 1u, 2u, 4u, 8u, std::thread::hardware_concurrency () })
+    std::cout << std::setw (8) << threads_count
+              << std::setw (20) << measure_dispatch (threads_count, executes_count) << "\n";
+
+  return 0;
+}
@@ -0,0 +1,165 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/grid/grid.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Counts cache misses of the calling thread with perf events. Counter is invalid if the kernel
+ * doesn't allow perf events (perf_event_paranoid) or the CPU has no such counter.
+ */
+class cache_misses_counter
+{
+public:
+  cache_misses_counter ()
+  {
+    perf_event_attr attr;
+    std::memset (&attr, 0, sizeof (attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof (attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    fd = static_cast<int> (syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  ~cache_misses_counter ()
+  {
+    if (is_valid ())
+      close (fd);
+  }
+
+  bool is_valid () const { return fd >= 0; }
+
+  void start ()
+  {
+    if (!is_valid ())
+      return;
+
+    ioctl (fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl (fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  std::uint64_t stop ()
+  {
+    std::uint64_t count = 0;
+    if (!is_valid ())
+      return count;
+
+    ioctl (fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read (fd, &count, sizeof (count)) != sizeof (count))
+      return 0;
+    return count;
+  }
+
+private:
+  int fd = -1;
+};
+
+struct sweep_result
+{
+  double ns_per_cell = 0.0;
+  std::uint64_t cache_misses = 0;
+};
+
+/**
+ * Five-point stencil sweep over cells in storage order, which is how solvers traverse fields.
+ * Neighbours are taken from grid_topology, so only the cells order differs between layouts.
+ */
+static sweep_result measure_sweeps (const grid_topology &topology, unsigned int sweeps_count)
+{
+  const unsigned int cells_count = topology.get_cells_count ();
+  std::vector<float> in (cells_count, 1.0f);
+  std::vector<float> out (cells_count, 0.0f);
+  cache_misses_counter counter;
+
+  sweep_result result;
+  const auto begin = std::chrono::high_resolution_clock::now ();
+  counter.start ();
+
+  for (unsigned int sweep = 0; sweep < sweeps_count; sweep++)
+  {
+    for (unsigned int cell_id = 0; cell_id < cells_count; cell_id++)
+    {
+      float sum = in[cell_id];
+      for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
+        sum += in[topology.get_neighbor_id (cell_id, edge_id)];
+      out[cell_id] = 0.2f * sum;
+    }
+
+    std::swap (in, out);
+  }
+
+  result.cache_misses = counter.stop ();
+  const auto end = std::chrono::high_resolution_clock::now ();
+
+  const std::chrono::duration<double, std::nano> duration = end - begin;
+  result.ns_per_cell = duration.count () / (static_cast<double> (cells_count) * sweeps_count);
+
+  return result;
+}
+
+/**
+ * Compares cells layouts of grid_topology on a square periodic grid.
+ * Usage: layout_benchmark [nx] [sweeps_count] [tile_size]
+ */
+int main (int argc, char *argv[])
+{
+  const unsigned int nx = argc > 1 ? std::stoul (argv[1]) : 8192;
+  const unsigned int sweeps_count = argc > 2 ? std::stoul (argv[2]) : 3;
+  const unsigned int tile_size = argc > 3 ? std::stoul (argv[3]) : grid_cells_order::default_tile_size;
+
+  std::cout << std::setw (12) << "layout"
+            << std::setw (20) << "time/cell [ns]"
+            << std::setw (20) << "cache misses/cell" << "\n";
+
+  const std::pair<cells_layout, std::string> layouts[] = {
+    { cells_layout::row_major, "row_major" },
+    { cells_layout::tiled, "tiled" },
+    { cells_layout::morton, "morton" }
+  };
+
+  for (auto &layout: layouts)
+  {
+    grid_cells_order order;
+    order.initialize (nx, nx, layout.first, tile_size);
+
+    grid_topology topology;
+    topology.initialize_for_structured_uniform_grid (
+      nx, nx,
+      boundary_to_id (boundary_type::periodic),
+      boundary_to_id (boundary_type::periodic),
+      boundary_to_id (boundary_type::periodic),
+      boundary_to_id (boundary_type::periodic),
+      order);
+
+    const auto result = measure_sweeps (topology, sweeps_count);
+    const double cells_visited = static_cast<double> (topology.get_cells_count ()) * sweeps_count;
+
+    std::cout << std::setw (12) << layout.second
+              << std::setw (20) << result.ns_per_cell;
+
+    if (result.cache_misses)
+      std::cout << std::setw (20) << result.cache_misses / cells_visited << "\n";
+    else
+      std::cout << std::setw (20) << "n/a" << "\n";
+  }
+
+  return 0;
+}
@@ -8,19 +8,44 @@
 #include "core/common/common_defs.h"
 #include "core/grid/grid.h"
 
+/// Mirror boundaries make the cell its own neighbour, none boundaries leave it without one
+inline CPU_GPU bool is_boundary_neighbor (unsigned int cell_id, unsigned int neighbor_id)
+{
+  return neighbor_id == cell_id || !does_neighbor_exist (neighbor_id);
+}
+
+/**
+ * (field[neighbor_id] - field[cell_id]) / distance for boundary neighbours. Mirror reflects the
+ * cell, so the difference is zero. Behind sides without neighbours the field is zero.
+ */
+template <typename float_type>
+CPU_GPU static float_type get_boundary_difference (
+  unsigned int cell_id,
+  unsigned int neighbor_id,
+  float_type distance,
+  const float_type * __restrict__ field)
+{
+  return does_neighbor_exist (neighbor_id) ? float_type {} : -field[cell_id] / distance;
+}
+
 /**
- * Calculate curl of Ex with periodic boundary condition
+ * Calculate curl of Ex
  * @param i Column index
  * @param j Row index
  */
-template <typename float_type>
+template <typename float_type, typename topology_type>
 CPU_GPU static float_type update_curl_ex (
   unsigned int cell_id,
-  const grid_topology &topology,
+  const topology_type &topology,
   const grid_geometry &geometry,
   const float_type * __restrict__ ez)
 {
   const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, side_to_id (side_type::top));
+
+  if constexpr (topology_type::has_boundary_neighbors)
+    if (is_boundary_neighbor (cell_id, neighbor_id))
+      return get_boundary_difference (cell_id, neighbor_id, static_cast<float_type> (geometry.get_cell_height (cell_id)), ez);
+
   return (ez[neighbor_id] - ez[cell_id]) / geometry.get_distance_between_cells_y (neighbor_id, cell_id);
 }
 
@@ -28,29 +53,51 @@ CPU_GPU static float_type update_curl_ex (
  * @param i Column index
  * @param j Row index
  */
-template <typename float_type>
+template <typename float_type, typename topology_type>
 CPU_GPU static float_type update_curl_ey (
   unsigned int cell_id,
-  const grid_topology &topology,
+  const topology_type &topology,
   const grid_geometry &geometry,
   const float_type * __restrict__ ez)
 {
   const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, side_to_id (side_type::right));
+
+  if constexpr (topology_type::has_boundary_neighbors)
+    if (is_boundary_neighbor (cell_id, neighbor_id))
+      return -get_boundary_difference (cell_id, neighbor_id, static_cast<float_type> (geometry.get_cell_width (cell_id)), ez);
+
   return -(ez[neighbor_id] - ez[cell_id]) / geometry.get_distance_between_cells_x (neighbor_id, cell_id);
 }
 
-template <typename float_type>
+template <typename float_type, typename topology_type>
 CPU_GPU static float_type update_curl_h (
   unsigned int cell_id,
-  const grid_topology &topology,
+  const topology_type &topology,
   const grid_geometry &geometry,
   const float_type * __restrict__ hx,
   const float_type * __restrict__ hy)
 {
-  // TODO For now assume that only periodic boundary conditions exist
   const unsigned int left_neighbor_id = topology.get_neighbor_id (cell_id, side_to_id (side_type::left));
   const unsigned int bottom_neighbor_id = topology.get_neighbor_id (cell_id, side_to_id (side_type::bottom));
 
+  if constexpr (topology_type::has_boundary_neighbors)
+  {
+    const bool left_boundary = is_boundary_neighbor (cell_id, left_neighbor_id);
+    const bool bottom_boundary = is_boundary_neighbor (cell_id, bottom_neighbor_id);
+
+    if (left_boundary || bottom_boundary)
+    {
+      const float_type dhy_dx = left_boundary
+        ? -get_boundary_difference (cell_id, left_neighbor_id, static_cast<float_type> (geometry.get_cell_width (cell_id)), hy)
+        : (hy[cell_id] - hy[left_neighbor_id]) / geometry.get_distance_between_cells_x (cell_id, left_neighbor_id);
+      const float_type dhx_dy = bottom_boundary
+        ? -get_boundary_difference (cell_id, bottom_neighbor_id, static_cast<float_type> (geometry.get_cell_height (cell_id)), hx)
+        : (hx[cell_id] - hx[bottom_neighbor_id]) / geometry.get_distance_between_cells_y (cell_id, bottom_neighbor_id);
+
+      return dhy_dx - dhx_dy;
+    }
+  }
+
   return (hy[cell_id] - hy[left_neighbor_id]) / geometry.get_distance_between_cells_x (cell_id, left_neighbor_id)
        - (hx[cell_id] - hx[bottom_neighbor_id]) / geometry.get_distance_between_cells_y (cell_id, bottom_neighbor_id);
 }
@@ -9,6 +9,8 @@
 
 #include "common_defs.h"
 
+constexpr double C0 = 299792458; /// Speed of light [metres per second]
+
 template <class float_type>
 CPU_GPU float_type gaussian_pulse (float_type t, float_type t_0, float_type tau)
 {
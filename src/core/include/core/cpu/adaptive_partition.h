@@ -0,0 +1,84 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_ADAPTIVE_PARTITION_H
+#define ANYSIM_ADAPTIVE_PARTITION_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "core/cpu/thread_pool.h"
+#include "core/cpu/telemetry.h"
+
+/**
+ * Partition of one loop between threads of a team. With adaptive_split policy each thread
+ * times its chunk, and every window calls the team leader moves chunks boundaries so that
+ * every thread gets the same share of the measured cost. Boundaries are moved only if the
+ * slowest thread is more than hysteresis slower than the mean, so they don't oscillate
+ * because of noise. Chunks stay contiguous and ordered by thread, so neighbours_sync works
+ * with partitions whose min_chunk_size covers the halo. Other policies behave as
+ * thread_pool::for_each_chunk with the same grain.
+ */
+class adaptive_partition
+{
+public:
+  static constexpr unsigned int default_window = 8;
+  static constexpr double default_hysteresis = 0.05;
+
+  explicit adaptive_partition (
+    unsigned int max_threads_count_arg,
+    unsigned int window_arg = default_window,
+    double hysteresis_arg = default_hysteresis);
+
+  /// Forgets boundaries and costs. Should be called outside of execute after changes of grid or teams.
+  void reset (unsigned int min_chunk_size_arg = 1);
+
+  template <class action_type>
+  void for_each_chunk (thread_pool &threads, unsigned int thread_id, unsigned int work_size, const action_type &action, unsigned int grain = 0)
+  {
+    if (threads.get_scheduling_policy () != scheduling_policy::adaptive_split)
+    {
+      threads.for_each_chunk (thread_id, work_size, action, grain);
+      return;
+    }
+
+    auto &thread_cost = costs[thread_id];
+    if (thread_cost.calls == window)
+      rebalance (threads, thread_id, work_size);
+
+    const std::uint64_t begin = read_tsc ();
+    action (get_chunk (threads.get_team_thread_id (thread_id), threads.get_team_threads_count (thread_id), work_size));
+    thread_cost.ticks += read_tsc () - begin;
+    thread_cost.calls++;
+  }
+
+  /// Chunk of the team thread in the last for_each_chunk call
+  work_range get_chunk (unsigned int team_thread_id, unsigned int team_threads_count, unsigned int work_size) const;
+
+private:
+  void rebalance (thread_pool &threads, unsigned int thread_id, unsigned int work_size);
+  void balance_boundaries (unsigned int first_thread, unsigned int team_threads_count, unsigned int work_size);
+
+private:
+  struct cache_padded_chunk_cost
+  {
+    alignas (get_level1_dcache_linesize ()) std::uint64_t ticks;
+    unsigned int calls;
+  };
+
+  const unsigned int max_threads_count;
+  const unsigned int window;
+  const double hysteresis;
+  unsigned int min_chunk_size = 1;
+
+  /// Boundaries are valid only for the work size and team size they were built for
+  unsigned int boundaries_work_size = 0;
+  unsigned int boundaries_threads_count = 0;
+  std::vector<unsigned int> boundaries;
+
+  std::unique_ptr<cache_padded_chunk_cost[]> costs;
+};
+
+#endif  // ANYSIM_ADAPTIVE_PARTITION_H
@@ -0,0 +1,153 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_BARRIER_H
+#define ANYSIM_BARRIER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "core/cpu/cache_line.h"
+#include "core/cpu/idle_policy.h"
+
+enum class barrier_type
+{
+  centralized, combining_tree
+};
+
+/**
+ * Barriers accept a callback that is called once per episode for each group of threads
+ * that has arrived: on_group_arrival (target, sources_begin, sources_end). Sources are
+ * the threads of the group (including target) and the callback is executed by the last
+ * of them, so it can fold values of sources into the value of target. Target of the
+ * whole barrier is returned by get_root_thread.
+ */
+struct empty_arrival_callback
+{
+  void operator () (unsigned int, const unsigned int *, const unsigned int *) const { }
+};
+
+/**
+ * All threads increment one counter and wait on one epoch. Cheap for a few threads,
+ * but the counter cache line bounces between every core on every barrier.
+ */
+class centralized_barrier
+{
+public:
+  explicit centralized_barrier (unsigned int threads_count);
+
+  template <class callback_type>
+  void wait (unsigned int thread_id, const callback_type &on_group_arrival)
+  {
+    const unsigned int thread_epoch = barrier_epoch.load ();
+
+    if (threads_in_barrier.fetch_add (1u) == total_threads - 1)
+    {
+      on_group_arrival (get_root_thread (), threads_ids.data (), threads_ids.data () + total_threads);
+      threads_in_barrier.store (0);
+      barrier_epoch.advance ();
+    }
+    else
+    {
+      waiters[thread_id].wait (barrier_epoch, thread_epoch);
+    }
+  }
+
+  void wait (unsigned int thread_id) { wait (thread_id, empty_arrival_callback {}); }
+
+  void set_idle_policy (const idle_policy &policy);
+
+  unsigned int get_root_thread () const { return 0; }
+
+private:
+  const unsigned int total_threads;
+  parking_epoch barrier_epoch;
+  std::atomic<unsigned int> threads_in_barrier;
+  std::vector<unsigned int> threads_ids;
+  std::unique_ptr<idle_waiter[]> waiters;
+};
+
+/**
+ * Threads arrive at leaf nodes of fan_in threads. The last thread to arrive at a node
+ * proceeds to its parent, others wait on the node they stopped at. The thread that
+ * completes the root releases the nodes it completed from top to bottom, and so does
+ * every released winner. Leaves and subtrees are built from threads of one NUMA node,
+ * so most of arrival and release traffic stays within a socket.
+ *
+ * Each node is represented by the first thread of its subtree. Arrival callback of a
+ * node gets representatives of the node children as sources.
+ */
+class combining_tree_barrier
+{
+public:
+  static constexpr unsigned int default_fan_in = 4;
+
+  combining_tree_barrier (const std::vector<unsigned int> &threads_numa_nodes, unsigned int fan_in);
+
+  template <class callback_type>
+  void wait (unsigned int thread_id, const callback_type &on_group_arrival)
+  {
+    unsigned int completed_nodes[max_depth];
+    unsigned int depth = 0;
+    unsigned int node_id = threads_leaves[thread_id];
+
+    while (true)
+    {
+      tree_node &node = nodes[node_id];
+      const unsigned int node_epoch = node.epoch.load ();
+
+      if (node.arrived.fetch_add (1u, std::memory_order_acq_rel) + 1 < node.children_count)
+      {
+        waiters[thread_id].wait (node.epoch, node_epoch);
+        break;
+      }
+
+      /// Nobody can arrive at the node until it's released
+      node.arrived.store (0, std::memory_order_relaxed);
+      completed_nodes[depth++] = node_id;
+
+      const unsigned int *sources = nodes_sources.data () + node.sources_offset;
+      on_group_arrival (node.representative, sources, sources + node.children_count);
+
+      if (node_id == root)
+        break;
+
+      node_id = node.parent;
+    }
+
+    /// Parents are released before children, so a node is never reached by the next barrier before release
+    while (depth > 0)
+      nodes[completed_nodes[--depth]].epoch.advance ();
+  }
+
+  void wait (unsigned int thread_id) { wait (thread_id, empty_arrival_callback {}); }
+
+  void set_idle_policy (const idle_policy &policy);
+
+  unsigned int get_root_thread () const { return nodes[root].representative; }
+
+private:
+  static constexpr unsigned int max_depth = 32;
+
+  struct tree_node
+  {
+    std::atomic<unsigned int> arrived;
+    parking_epoch epoch;
+    unsigned int children_count;
+    unsigned int parent;
+    unsigned int representative;
+    unsigned int sources_offset;
+    std::byte padding[get_level1_dcache_linesize () - sizeof (std::atomic<unsigned int>) - sizeof (parking_epoch) - 4 * sizeof (unsigned int)];
+  };
+
+  unsigned int root = 0;
+  std::vector<unsigned int> threads_leaves;
+  std::vector<unsigned int> nodes_sources;
+  std::unique_ptr<tree_node[]> nodes;
+  std::unique_ptr<idle_waiter[]> waiters;
+};
+
+#endif  // ANYSIM_BARRIER_H
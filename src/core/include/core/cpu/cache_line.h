@@ -0,0 +1,13 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_CACHE_LINE_H
+#define ANYSIM_CACHE_LINE_H
+
+constexpr inline unsigned int get_level1_dcache_linesize ()
+{
+  return 64;
+}
+
+#endif  // ANYSIM_CACHE_LINE_H
@@ -9,12 +9,15 @@
 #include <cuda_runtime.h>
 #endif
 
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <memory>
 #include <vector>
 #include <string>
 #include <chrono>
 #include <cmath>
+#include <type_traits>
 
 #include "core/grid/grid.h"
 #include "core/gpu/euler_2d.cuh"
@@ -22,6 +25,9 @@
 #include "core/config/configuration.h"
 #include "core/solver/workspace.h"
 #include "core/cpu/thread_pool.h"
+#include "core/cpu/adaptive_partition.h"
+#include "core/cpu/euler_2d_face_sweep.h"
+#include "core/cpu/euler_2d_muscl.h"
 #include "core/solver/solver.h"
 #include "cpp/common_funcs.h"
 
@@ -37,13 +43,48 @@ class euler_2d : public solver
   float_type cfl = 0.1;
   float_type gamma = 1.4;
 
+  /// Two-layer fields of the state, primitive u, v and p are derived by update_results for conservative variables
+  euler_2d_variables variables = euler_2d_variables::primitive;
+  const char *state_names[4] = { "rho", "u", "v", "p" };
+
+  /// Initial values are written in primitive variables, conservative ones are computed on the next step
+  bool is_conservative_state_outdated = false;
+
+  /// In fused mode update sweep finds dt of the next step, zero until the first step computes it
+  bool use_fused_dt = false;
+  std::vector<float_type> threads_next_dt;
+
   const grid *solver_grid = nullptr;
 
+  adaptive_partition cells_partition;
+
+  using solve_cpu_type = void (euler_2d::*) (
+    unsigned int, float_type, const grid_topology &, const grid_geometry &,
+    const float_type *, float_type *, const float_type *, float_type *,
+    const float_type *, float_type *, const float_type *, float_type *,
+    float_type *);
+
+  /// solve_cpu instantiation for boundary conditions of the grid
+  solve_cpu_type solve_cpu_function = nullptr;
+
+  /// Row-major structured grids are updated face by face, other grids cell by cell
+  bool use_face_sweep = false;
+  euler_2d_face_sweep<float_type> face_sweep;
+
+  /// Face sweep of uniform grids uses vector kernels of the widest supported instruction set unless they're off
+  bool use_simd = true;
+
+  /// Reconstruction and time integration of higher orders, only for row-major structured grids
+  euler_2d_slope_limiter limiter = euler_2d_slope_limiter::none;
+  euler_2d_time_integration time_integration = euler_2d_time_integration::euler;
+  euler_2d_muscl<float_type> muscl;
+
 public:
   euler_2d (
       thread_pool &threads_arg,
       workspace &solver_workspace_arg)
     : solver (threads_arg, solver_workspace_arg)
+    , cells_partition (threads_arg.get_threads_count ())
   { }
 
   ~euler_2d () override = default;
@@ -52,6 +93,25 @@ public:
   {
     config.create_node (config_id, "cfl", 0.1);
     config.create_node (config_id, "gamma", 1.4);
+
+    /// Optional, primitive or conservative
+    const auto state_id = config.create_group (config_id, "state");
+    config.create_node (state_id, "variables", std::string ("primitive"));
+
+    /// Optional, dt of the next step is computed by the update sweep instead of a separate pass
+    const auto time_step_id = config.create_group (config_id, "time_step");
+    config.create_node (time_step_id, "fused", false);
+
+    /// Optional, reconstruction is constant or muscl, limiter is minmod, van_leer or mc,
+    /// time integration is euler, ssp_rk2 or ssp_rk3
+    const auto scheme_id = config.create_group (config_id, "scheme");
+    config.create_node (scheme_id, "reconstruction", std::string ("constant"));
+    config.create_node (scheme_id, "limiter", std::string ("minmod"));
+    config.create_node (scheme_id, "time_integration", std::string ("euler"));
+
+    /// Optional, kernels are auto or off, off keeps scalar kernels on any CPU
+    const auto simd_id = config.create_group (config_id, "simd");
+    config.create_node (simd_id, "kernels", std::string ("auto"));
   }
 
   bool is_gpu_supported () const final
@@ -59,6 +119,11 @@ public:
     return true;
   }
 
+  bool is_unstructured_mesh_supported () const final
+  {
+    return true;
+  }
+
   void apply_configuration (const configuration &config, std::size_t solver_id, grid *solver_grid_arg, int gpu_num) final
   {
     cpp_unreferenced (gpu_num);
@@ -67,10 +132,87 @@ public:
 
     auto cfl_id = solver_children[0];
     auto gamma_id = solver_children[1];
+    auto state_id = solver_children[2];
+    auto time_step_id = solver_children[3];
+    auto scheme_id = solver_children[4];
+    auto simd_id = solver_children[5];
     cfl = config.get_node_value (cfl_id);
     gamma = config.get_node_value (gamma_id);
 
+    const std::string variables_name = config.get_node_value (config.children_for (state_id).at (0));
+    variables = variables_name == "conservative" ? euler_2d_variables::conservative : euler_2d_variables::primitive;
+    if (variables_name != "conservative" && variables_name != "primitive")
+      std::cerr << "Unknown state variables " << variables_name << ", primitive ones are used" << std::endl;
+
+    use_fused_dt = static_cast<bool> (config.get_node_value (config.children_for (time_step_id).at (0)));
+    threads_next_dt.assign (threads.get_threads_count (), float_type (0.0));
+
+    read_scheme (config, scheme_id);
+
+    const std::string simd_kernels_name = config.get_node_value (config.children_for (simd_id).at (0));
+    use_simd = simd_kernels_name != "off";
+    if (simd_kernels_name != "auto" && simd_kernels_name != "off")
+      std::cerr << "Unknown simd kernels " << simd_kernels_name << ", auto is used" << std::endl;
+
+#ifdef GPU_BUILD
+    if (gpu_num >= 0 && variables == euler_2d_variables::conservative)
+    {
+      std::cerr << "Conservative variables aren't supported on GPU, primitive ones are used" << std::endl;
+      variables = euler_2d_variables::primitive;
+    }
+
+    /// GPU kernel computes dt in a separate pass
+    if (gpu_num >= 0)
+      use_fused_dt = false;
+
+    if (gpu_num >= 0 && is_high_order ())
+    {
+      std::cerr << "Only first order scheme is supported on GPU" << std::endl;
+      limiter = euler_2d_slope_limiter::none;
+      time_integration = euler_2d_time_integration::euler;
+    }
+#endif
+
+    const bool is_conservative = variables == euler_2d_variables::conservative;
+    state_names[1] = is_conservative ? "rho_u" : "u";
+    state_names[2] = is_conservative ? "rho_v" : "v";
+    state_names[3] = is_conservative ? "rho_e" : "p";
+    is_conservative_state_outdated = is_conservative;
+
     solver_grid = solver_grid_arg;
+    cells_partition.reset ();
+
+    const auto topology = solver_grid->gen_topology_wrapper ();
+    use_face_sweep = euler_2d_face_sweep<float_type>::is_supported (topology);
+
+    if (is_high_order () && !euler_2d_muscl<float_type>::is_supported (topology))
+    {
+      std::cerr << "Only first order scheme is supported on unstructured meshes" << std::endl;
+      limiter = euler_2d_slope_limiter::none;
+      time_integration = euler_2d_time_integration::euler;
+    }
+
+    if (use_face_sweep)
+    {
+      const bool is_uniform = !solver_grid->is_rectilinear ();
+      face_sweep.initialize (threads.get_threads_count (), topology, is_uniform, use_simd);
+    }
+
+    /// Boundary conditions don't change until the next configuration, so the kernel is chosen once
+    dispatch_boundary_conditions (topology, [this, is_conservative] (const auto &boundary_topology) {
+      using boundary_topology_type = std::decay_t<decltype (boundary_topology)>;
+      solve_cpu_function = is_conservative
+                         ? &euler_2d::solve_cpu<euler_2d_variables::conservative, boundary_topology_type>
+                         : &euler_2d::solve_cpu<euler_2d_variables::primitive, boundary_topology_type>;
+    });
+
+    if (is_high_order ())
+    {
+      muscl.initialize (threads.get_threads_count (), topology, limiter, time_integration);
+      solve_cpu_function = is_conservative
+                         ? get_solve_cpu_muscl_function<euler_2d_variables::conservative> ()
+                         : get_solve_cpu_muscl_function<euler_2d_variables::primitive> ();
+    }
 
 #ifdef GPU_BUILD
     use_gpu = gpu_num >= 0;
@@ -85,14 +227,32 @@ public:
       }
 #endif
 
+    /// Primitive fields are results and initial values in both cases, conservative ones are internal
+    const unsigned int primitive_layers = is_conservative ? 1 : 2;
     solver_grid_arg->create_field<float_type> ("rho", memory_holder_type::host, 2);
-    solver_grid_arg->create_field<float_type> ("u",   memory_holder_type::host, 2);
-    solver_grid_arg->create_field<float_type> ("v",   memory_holder_type::host, 2);
-    solver_grid_arg->create_field<float_type> ("p",   memory_holder_type::host, 2);
+    solver_grid_arg->create_field<float_type> ("u",   memory_holder_type::host, primitive_layers);
+    solver_grid_arg->create_field<float_type> ("v",   memory_holder_type::host, primitive_layers);
+    solver_grid_arg->create_field<float_type> ("p",   memory_holder_type::host, primitive_layers);
+
+    const unsigned int cells_count = solver_grid->get_cells_number ();
+    if (is_conservative)
+      for (unsigned int field = 1; field < 4; field++)
+        solver_workspace.allocate (state_names[field], memory_holder_type::host, cells_count * sizeof (float_type), 2);
+
+    /// Place pages before grid initializer writes initial values from the main thread
+    for (auto &field: state_names)
+      for (unsigned int layer = 0; layer < 2; layer++)
+        threads.fill (reinterpret_cast<float_type *> (solver_workspace.get (field, layer)), cells_count, float_type (0.0), cells_partition);
+    if (is_conservative)
+      for (auto &field: { "u", "v", "p" })
+        threads.fill (reinterpret_cast<float_type *> (solver_workspace.get (field)), cells_count, float_type (0.0), cells_partition);
   }
 
   void handle_grid_change () final
   {
+    is_conservative_state_outdated = variables == euler_2d_variables::conservative;
+    std::fill (threads_next_dt.begin (), threads_next_dt.end (), float_type (0.0));
+
 #ifdef GPU_BUILD
     if (use_gpu)
     {
@@ -119,9 +279,16 @@ public:
 #endif
   }
 
+  float_type calculate_dt_of_max_wave_speed (const grid_geometry &geometry, float_type max_wave_speed) const
+  {
+    const float_type min_len = geometry.get_min_spacing ();
+    return cfl * min_len / max_wave_speed;
+  }
+
+  /// Layers of conservative variables are passed in place of p_u, p_v and p_p
+  template <euler_2d_variables state_variables>
   float_type calculate_dt_cpu (
     unsigned int thread_id,
-    unsigned int total_threads,
 
     const grid_topology &topology,
     const grid_geometry &geometry,
@@ -132,37 +299,20 @@ public:
     const float_type *p_p) const
   {
     float_type max_speed = std::numeric_limits<float_type>::min ();
-    float_type min_len = std::numeric_limits<float_type>::max ();
-
-    auto yr = work_range::split (solver_grid->get_cells_number (), thread_id, total_threads);
-
-    for (unsigned int cell_id = yr.chunk_begin; cell_id < yr.chunk_end; cell_id++)
-    {
-      const float_type rho = p_rho[cell_id];
-      const float_type p = p_p[cell_id];
-      const float_type a = speed_of_sound_in_gas (gamma, p, rho);
-      const float_type u = p_u[cell_id];
-      const float_type v = p_v[cell_id];
 
-      max_speed = std::max (max_speed, std::max (std::fabs (u + a), std::fabs (u - a)));
-      max_speed = std::max (max_speed, std::max (std::fabs (v + a), std::fabs (v - a)));
+    threads.for_each_chunk (thread_id, topology.get_cells_count (), [&] (const work_range &yr) {
+      for (unsigned int cell_id = yr.chunk_begin; cell_id < yr.chunk_end; cell_id++)
+        max_speed = std::max (max_speed, euler_2d_calculate_max_wave_speed<state_variables> (
+            cell_id, gamma, p_rho, p_u, p_v, p_p));
+    });
 
-      for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
-      {
-        const float_type edge_len = geometry.get_edge_area (cell_id, edge_id);
-        if (edge_len < min_len)
-          min_len = edge_len;
-      }
-    }
-
-    float_type new_dt = cfl * min_len / max_speed;
+    float_type new_dt = calculate_dt_of_max_wave_speed (geometry, max_speed);
     threads.reduce_min (thread_id, new_dt);
     return new_dt;
   }
 
   float_type calculate_dt (
     unsigned int thread_id,
-    unsigned int total_threads,
 
     const grid_topology &topology,
     const grid_geometry &geometry,
@@ -192,13 +342,20 @@ public:
     else
 #endif
     {
-      return calculate_dt_cpu (thread_id, total_threads, topology, geometry, p_rho, p_u, p_v, p_p);
+      if (variables == euler_2d_variables::conservative)
+        return calculate_dt_cpu<euler_2d_variables::conservative> (thread_id, topology, geometry, p_rho, p_u, p_v, p_p);
+      return calculate_dt_cpu<euler_2d_variables::primitive> (thread_id, topology, geometry, p_rho, p_u, p_v, p_p);
     }
   }
 
+  /**
+   * Boundary strips are computed with boundary_topology_type, which is grid_topology for unstructured meshes.
+   * Layers of conservative variables are passed in place of u, v and p.
+   * @param max_wave_speed Optional, raised to the maximum wave speed of the next values of the cells
+   */
+  template <euler_2d_variables state_variables, class boundary_topology_type>
   void solve_cpu (
       unsigned int thread_id,
-      unsigned int total_threads,
       float_type dt,
 
       const grid_topology &topology,
@@ -211,35 +368,203 @@ public:
       const float_type *p_v,
       float_type *p_v_next,
       const float_type *p_p,
-      float_type *p_p_next)
+      float_type *p_p_next,
+
+      float_type *max_wave_speed)
   {
-    auto yr = work_range::split (solver_grid->get_cells_number (), thread_id, total_threads);
+    const boundary_topology_type boundary_topology (topology);
 
-    for (unsigned int cell_id = yr.chunk_begin; cell_id < yr.chunk_end; cell_id++)
-      euler_2d_calculate_next_cell_values (
-          cell_id, dt, gamma, topology, geometry,
-          p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next);
+    if (use_face_sweep)
+    {
+      cells_partition.for_each_chunk (threads, thread_id, solver_grid->get_cells_number (), [&] (const work_range &yr) {
+        face_sweep.template calculate_next_cells_values<state_variables> (
+            thread_id, yr.chunk_begin, yr.chunk_end, dt, gamma,
+            topology, boundary_topology, geometry,
+            p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+      });
+      return;
+    }
+
+    cells_partition.for_each_chunk (threads, thread_id, solver_grid->get_cells_number (), [&] (const work_range &yr) {
+      topology.for_each_cells_strip (yr.chunk_begin, yr.chunk_end, boundary_topology, [&] (unsigned int begin, unsigned int end, const auto &strip_topology) {
+        for (unsigned int cell_id = begin; cell_id < end; cell_id++)
+          euler_2d_calculate_next_cell_values<state_variables> (
+              cell_id, dt, gamma, strip_topology, geometry,
+              p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next);
+
+        if (max_wave_speed)
+          for (unsigned int cell_id = begin; cell_id < end; cell_id++)
+            *max_wave_speed = std::max (*max_wave_speed, euler_2d_calculate_max_wave_speed<state_variables> (
+                cell_id, gamma, p_rho_next, p_u_next, p_v_next, p_p_next));
+      });
+    });
   }
 
-  double solve (unsigned int step, unsigned int thread_id, unsigned int total_threads) final
+  /// Tiles are updated with all stages of the time step, see euler_2d_muscl
+  template <euler_2d_variables state_variables, euler_2d_slope_limiter slope_limiter>
+  void solve_cpu_muscl (
+      unsigned int thread_id,
+      float_type dt,
+
+      const grid_topology &topology,
+      const grid_geometry &geometry,
+
+      const float_type *p_rho,
+      float_type *p_rho_next,
+      const float_type *p_u,
+      float_type *p_u_next,
+      const float_type *p_v,
+      float_type *p_v_next,
+      const float_type *p_p,
+      float_type *p_p_next,
+
+      float_type *max_wave_speed)
+  {
+    /// MUSCL tiles hold thousands of cells, so each of them is a work stealing tile
+    cells_partition.for_each_chunk (threads, thread_id, muscl.get_tiles_count (), [&] (const work_range &yr) {
+      muscl.template calculate_next_cells_values<state_variables, slope_limiter> (
+          thread_id, yr.chunk_begin, yr.chunk_end, dt, gamma, topology, geometry,
+          p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+    }, 1);
+  }
+
+  template <euler_2d_variables state_variables>
+  solve_cpu_type get_solve_cpu_muscl_function () const
+  {
+    switch (limiter)
+    {
+      case euler_2d_slope_limiter::none:                return &euler_2d::solve_cpu_muscl<state_variables, euler_2d_slope_limiter::none>;
+      case euler_2d_slope_limiter::minmod:              return &euler_2d::solve_cpu_muscl<state_variables, euler_2d_slope_limiter::minmod>;
+      case euler_2d_slope_limiter::van_leer:            return &euler_2d::solve_cpu_muscl<state_variables, euler_2d_slope_limiter::van_leer>;
+      case euler_2d_slope_limiter::monotonized_central: return &euler_2d::solve_cpu_muscl<state_variables, euler_2d_slope_limiter::monotonized_central>;
+    }
+
+    return nullptr;
+  }
+
+  bool is_high_order () const
+  {
+    return limiter != euler_2d_slope_limiter::none || time_integration != euler_2d_time_integration::euler;
+  }
+
+  void read_scheme (const configuration &config, std::size_t scheme_id)
+  {
+    const auto scheme_children = config.children_for (scheme_id);
+    const std::string reconstruction_name = config.get_node_value (scheme_children.at (0));
+    const std::string limiter_name = config.get_node_value (scheme_children.at (1));
+    const std::string time_integration_name = config.get_node_value (scheme_children.at (2));
+
+    limiter = euler_2d_slope_limiter::none;
+    if (reconstruction_name == "muscl")
+    {
+      if (limiter_name == "van_leer")
+        limiter = euler_2d_slope_limiter::van_leer;
+      else if (limiter_name == "mc")
+        limiter = euler_2d_slope_limiter::monotonized_central;
+      else
+        limiter = euler_2d_slope_limiter::minmod;
+
+      if (limiter_name != "minmod" && limiter_name != "van_leer" && limiter_name != "mc")
+        std::cerr << "Unknown limiter " << limiter_name << ", minmod is used" << std::endl;
+    }
+    else if (reconstruction_name != "constant")
+    {
+      std::cerr << "Unknown reconstruction " << reconstruction_name << ", constant one is used" << std::endl;
+    }
+
+    if (time_integration_name == "ssp_rk2")
+      time_integration = euler_2d_time_integration::ssp_rk2;
+    else if (time_integration_name == "ssp_rk3")
+      time_integration = euler_2d_time_integration::ssp_rk3;
+    else
+      time_integration = euler_2d_time_integration::euler;
+
+    if (time_integration_name != "euler" && time_integration_name != "ssp_rk2" && time_integration_name != "ssp_rk3")
+      std::cerr << "Unknown time integration " << time_integration_name << ", euler is used" << std::endl;
+  }
+
+  /// Conserved variables of the layer from primitive fields u, v and p
+  void calculate_conservative_variables (
+    unsigned int thread_id,
+
+    const float_type *p_rho,
+    float_type *p_rho_u,
+    float_type *p_rho_v,
+    float_type *p_rho_e) const
+  {
+    auto p_u = reinterpret_cast<const float_type *> (solver_workspace.get ("u"));
+    auto p_v = reinterpret_cast<const float_type *> (solver_workspace.get ("v"));
+    auto p_p = reinterpret_cast<const float_type *> (solver_workspace.get ("p"));
+
+    threads.for_each_chunk (thread_id, solver_grid->get_cells_number (), [&] (const work_range &yr) {
+      for (unsigned int cell_id = yr.chunk_begin; cell_id < yr.chunk_end; cell_id++)
+      {
+        float_type q[4];
+        fill_state_vector (cell_id, gamma, p_rho, p_u, p_v, p_p, q);
+
+        p_rho_u[cell_id] = q[1];
+        p_rho_v[cell_id] = q[2];
+        p_rho_e[cell_id] = q[3];
+      }
+    });
+  }
+
+  /// Primitive fields of conservative variables are derived only when results are extracted
+  void update_results (unsigned int thread_id, unsigned int threads_count) final
+  {
+    /// Until the first step primitive fields keep initial values
+    if (variables != euler_2d_variables::conservative || is_conservative_state_outdated)
+      return;
+
+    auto p_rho   = reinterpret_cast<const float_type *> (solver_workspace.get ("rho"));
+    auto p_rho_u = reinterpret_cast<const float_type *> (solver_workspace.get ("rho_u"));
+    auto p_rho_v = reinterpret_cast<const float_type *> (solver_workspace.get ("rho_v"));
+    auto p_rho_e = reinterpret_cast<const float_type *> (solver_workspace.get ("rho_e"));
+    auto p_u = reinterpret_cast<float_type *> (solver_workspace.get ("u"));
+    auto p_v = reinterpret_cast<float_type *> (solver_workspace.get ("v"));
+    auto p_p = reinterpret_cast<float_type *> (solver_workspace.get ("p"));
+
+    const auto range = work_range::split (solver_grid->get_cells_number (), thread_id, threads_count);
+    for (unsigned int cell_id = range.chunk_begin; cell_id < range.chunk_end; cell_id++)
+      euler_2d_calculate_primitive_variables (
+          cell_id, gamma, p_rho, p_rho_u, p_rho_v, p_rho_e,
+          p_u[cell_id], p_v[cell_id], p_p[cell_id]);
+  }
+
+  double solve (unsigned int step, unsigned int thread_id, unsigned int /* total_threads */) final
   {
     const std::string prefix = use_gpu ? "gpu_" : "";
 
     auto domain = cpp_itt::create_domain ("euler.2d.solve");
 
-    auto p_rho      = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "rho", (step + 0) % 2));
-    auto p_rho_next = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "rho", (step + 1) % 2));
-    auto p_u        = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "u",   (step + 0) % 2));
-    auto p_u_next   = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "u",   (step + 1) % 2));
-    auto p_v        = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "v",   (step + 0) % 2));
-    auto p_v_next   = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "v",   (step + 1) % 2));
-    auto p_p        = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "p",   (step + 0) % 2));
-    auto p_p_next   = reinterpret_cast<float_type *> (solver_workspace.get (prefix + "p",   (step + 1) % 2));
+    /// State layers, which are rho * u, rho * v and rho * E in place of u, v and p for conservative variables
+    auto p_rho      = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[0], (step + 0) % 2));
+    auto p_rho_next = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[0], (step + 1) % 2));
+    auto p_u        = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[1], (step + 0) % 2));
+    auto p_u_next   = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[1], (step + 1) % 2));
+    auto p_v        = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[2], (step + 0) % 2));
+    auto p_v_next   = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[2], (step + 1) % 2));
+    auto p_p        = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[3], (step + 0) % 2));
+    auto p_p_next   = reinterpret_cast<float_type *> (solver_workspace.get (prefix + state_names[3], (step + 1) % 2));
 
     const auto topology = solver_grid->gen_topology_wrapper ();
     const auto geometry = solver_grid->gen_geometry_wrapper ();
 
-    const float_type dt = calculate_dt (thread_id, total_threads, topology, geometry, p_rho, p_u, p_v, p_p, domain);
+    if (is_conservative_state_outdated)
+    {
+      calculate_conservative_variables (thread_id, p_rho, p_u, p_v, p_p);
+      threads.barrier (thread_id);
+
+      if (is_main_thread (thread_id))
+        is_conservative_state_outdated = false;
+    }
+
+    /// The first step after configuration or grid change has no dt of the previous one
+    const bool is_dt_known = use_fused_dt && threads_next_dt[thread_id] > float_type (0.0);
+    const float_type dt = is_dt_known
+                        ? threads_next_dt[thread_id]
+                        : calculate_dt (thread_id, topology, geometry, p_rho, p_u, p_v, p_p, domain);
+    float_type max_wave_speed = std::numeric_limits<float_type>::min ();
 
 #ifdef GPU_BUILD
     if (use_gpu)
@@ -255,14 +580,26 @@ public:
     {
       auto next_cell_calculation_task = domain.create_task ("update_cells_values");
 
-      solve_cpu (
-          thread_id, total_threads, dt,
+      (this->*solve_cpu_function) (
+          thread_id, dt,
           topology, geometry,
           p_rho, p_rho_next, p_u, p_u_next, p_v,
-          p_v_next, p_p, p_p_next);
+          p_v_next, p_p, p_p_next,
+          use_fused_dt ? &max_wave_speed : nullptr);
+    }
+
+    if (use_fused_dt)
+    {
+      /// Reduction waits for all threads, so it replaces the barrier of the step
+      float_type next_dt = calculate_dt_of_max_wave_speed (geometry, max_wave_speed);
+      threads.reduce_min (thread_id, next_dt);
+      threads_next_dt[thread_id] = next_dt;
+    }
+    else
+    {
+      threads.barrier (thread_id);
     }
 
-    threads.barrier ();
     return dt;
   }
 };
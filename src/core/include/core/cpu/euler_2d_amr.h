@@ -0,0 +1,804 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_EULER_2D_AMR_H
+#define ANYSIM_EULER_2D_AMR_H
+
+#include "core/config/configuration.h"
+#include "core/cpu/thread_pool.h"
+#include "core/gpu/euler_2d.cuh"
+#include "core/grid/amr_hierarchy.h"
+#include "core/solver/solver.h"
+#include "core/grid/grid.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+/**
+ * Euler solver on block-structured AMR. Grid resolution is the resolution of the finest level, the
+ * base level is 2^max_level times coarser. Leaves of amr_hierarchy are patch_size x patch_size
+ * patches with one layer of ghost cells, so the interior of a patch is updated with the kernel of
+ * euler_2d and the boundary-free topology. Ghosts are copied from leaves of the same level,
+ * injected from coarser leaves (prolongation) or averaged from finer ones (restriction). At
+ * coarse-fine interfaces the coarse cell flux is replaced by the sum of fine faces fluxes after
+ * the step, so the scheme stays conservative. Patches are refined when the relative density jump
+ * inside of them exceeds refine_threshold and coarsened when it drops below a quarter of it.
+ *
+ * All levels advance with the same time step, limited by the finest cells. Leaves are independent
+ * tasks of thread_pool inside of each phase of the step. Output fields are filled from leaves
+ * only in update_results, so steps between extractions don't touch the finest resolution arrays.
+ */
+template <class float_type>
+class euler_2d_amr : public solver
+{
+  static constexpr unsigned int variables_count = 4;
+
+  /// Leaves are whole patches, so each of them is a work stealing tile of for_each_chunk
+  static constexpr unsigned int leaves_grain = 1;
+
+  enum regrid_mark : char
+  {
+    keep, refine, coarsen
+  };
+
+  struct patch_state
+  {
+    /// Primitive variables rho, u, v, p of the patch with ghost cells, one array per time layer
+    std::vector<float_type> values[2];
+
+    /// Flux out of boundary cells integrated over their faces (side, cell along the side, component)
+    std::vector<float_type> boundary_fluxes;
+  };
+
+  float_type cfl = 0.1;
+  float_type gamma = 1.4;
+  float_type refine_threshold = 0.1;
+
+  unsigned int patch_size = 16;
+  unsigned int padded_size = 18;
+  unsigned int regrid_interval = 4;
+
+  /// Cells sizes of the base level
+  float_type base_dx = 1.0;
+  float_type base_dy = 1.0;
+
+  grid *solver_grid = nullptr;
+
+  float_type *rho = nullptr;
+  float_type *u = nullptr;
+  float_type *v = nullptr;
+  float_type *p = nullptr;
+
+  bool configured = false;
+  bool hierarchy_outdated = true;
+
+  /// Time layer of leaves values computed by the last step
+  unsigned int results_layer = 0;
+
+  amr_hierarchy hierarchy;
+  std::vector<patch_state> states;
+  std::vector<regrid_mark> regrid_marks;
+
+public:
+  euler_2d_amr () = delete;
+  euler_2d_amr (
+    thread_pool &threads_arg,
+    workspace &solver_workspace_arg)
+  : solver (threads_arg, solver_workspace_arg)
+  { }
+
+  void fill_configuration_scheme (configuration &config, std::size_t config_id) final
+  {
+    config.create_node (config_id, "cfl", 0.1);
+    config.create_node (config_id, "gamma", 1.4);
+    config.create_node (config_id, "patch_size", 16);
+    config.create_node (config_id, "max_level", 2);
+    config.create_node (config_id, "refine_threshold", 0.1);
+    config.create_node (config_id, "regrid_interval", 4);
+  }
+
+  bool is_gpu_supported () const final
+  {
+    return false;
+  }
+
+  bool is_unstructured_mesh_supported () const final
+  {
+    return false;
+  }
+
+  void apply_configuration (const configuration &config, std::size_t solver_id, grid *solver_grid_arg, int /* gpu_num */) final
+  {
+    solver_grid = solver_grid_arg;
+    configured = false;
+    hierarchy_outdated = true;
+    results_layer = 0;
+
+    const auto solver_children = config.children_for (solver_id);
+    cfl = config.get_node_value (solver_children[0]);
+    gamma = config.get_node_value (solver_children[1]);
+    const int patch_size_arg = config.get_node_value (solver_children[2]);
+    const int max_level = config.get_node_value (solver_children[3]);
+    refine_threshold = config.get_node_value (solver_children[4]);
+    const int regrid_interval_arg = config.get_node_value (solver_children[5]);
+
+    for (auto &field: { "rho", "u", "v", "p" })
+      solver_grid->create_field<float_type> (field, memory_holder_type::host, 1);
+
+    rho = reinterpret_cast<float_type *> (solver_workspace.get ("rho"));
+    u   = reinterpret_cast<float_type *> (solver_workspace.get ("u"));
+    v   = reinterpret_cast<float_type *> (solver_workspace.get ("v"));
+    p   = reinterpret_cast<float_type *> (solver_workspace.get ("p"));
+
+    const unsigned int cells_count = solver_grid->get_cells_number ();
+    for (auto field: { rho, u, v, p })
+      threads.fill (field, cells_count, float_type (0.0));
+
+    const auto topology = solver_grid->gen_topology_wrapper ();
+    const auto geometry = solver_grid->gen_geometry_wrapper ();
+
+    /// Base patches cover 2^max_level x 2^max_level patches of the finest level
+    const unsigned int base_patch_cells = max_level >= 0 && max_level < 16 ? patch_size_arg << max_level : 0;
+
+    if (solver_grid->is_unstructured () || solver_grid->is_rectilinear ()
+     || patch_size_arg < 2 || patch_size_arg % 2 || regrid_interval_arg <= 0 || !base_patch_cells
+     || topology.get_nx () % base_patch_cells || topology.get_ny () % base_patch_cells)
+    {
+      std::cerr << "Error! euler_2d_amr needs uniform structured grid with sides divisible by patch_size * 2^max_level "
+                << "and even patch_size" << std::endl;
+      return;
+    }
+
+    patch_size = patch_size_arg;
+    padded_size = patch_size + 2;
+    regrid_interval = regrid_interval_arg;
+    base_dx = geometry.get_cell_width (0) * static_cast<float_type> (1u << max_level);
+    base_dy = geometry.get_cell_height (0) * static_cast<float_type> (1u << max_level);
+
+    hierarchy.initialize (topology.get_nx () / base_patch_cells, topology.get_ny () / base_patch_cells, max_level);
+    states.clear ();
+    regrid_marks.clear ();
+
+    configured = true;
+  }
+
+  void handle_grid_change () final
+  {
+    hierarchy_outdated = true;
+  }
+
+  void update_results (unsigned int thread_id, unsigned int threads_count) final
+  {
+    /// Until the first step output fields keep initial values
+    if (!configured || hierarchy_outdated)
+      return;
+
+    const auto topology = solver_grid->gen_topology_wrapper ();
+    const std::vector<unsigned int> &leaves = hierarchy.get_leaves ();
+
+    const auto range = work_range::split (leaves.size (), thread_id, threads_count);
+    for (unsigned int leaf = range.chunk_begin; leaf < range.chunk_end; leaf++)
+      write_patch (leaves[leaf], results_layer, topology);
+  }
+
+  double solve (unsigned int step, unsigned int thread_id, unsigned int /* total_threads */) final
+  {
+    /// Rejected configuration leaves no leaves to update, so the calculation is stopped
+    if (!configured)
+    {
+      if (threads.is_team_leader (thread_id))
+        std::cerr << "Error! euler_2d_amr isn't configured, calculation is stopped" << std::endl;
+      return std::numeric_limits<double>::infinity ();
+    }
+
+    const unsigned int layer = step % 2;
+    const unsigned int next_layer = (step + 1) % 2;
+    const auto topology = solver_grid->gen_topology_wrapper ();
+
+    /// Initial values are written into output fields after configuration, so leaves are built by the first step
+    if (hierarchy_outdated)
+    {
+      threads.barrier (thread_id);
+      if (is_main_thread (thread_id))
+      {
+        build_hierarchy (layer, topology);
+        hierarchy_outdated = false;
+      }
+      threads.barrier (thread_id);
+    }
+    else if (step % regrid_interval == 0)
+    {
+      const std::vector<unsigned int> &leaves = hierarchy.get_leaves ();
+      threads.for_each_chunk (thread_id, leaves.size (), [&] (const work_range &range) {
+        for (unsigned int leaf = range.chunk_begin; leaf < range.chunk_end; leaf++)
+          mark_patch (leaves[leaf], layer);
+      }, leaves_grain);
+
+      threads.barrier (thread_id);
+      if (is_main_thread (thread_id))
+        regrid (layer);
+      threads.barrier (thread_id);
+    }
+
+    const std::vector<unsigned int> &leaves = hierarchy.get_leaves ();
+
+    float_type step_dt = std::numeric_limits<float_type>::max ();
+    threads.for_each_chunk (thread_id, leaves.size (), [&] (const work_range &range) {
+      for (unsigned int leaf = range.chunk_begin; leaf < range.chunk_end; leaf++)
+      {
+        fill_ghosts (leaves[leaf], layer, topology);
+        step_dt = std::min (step_dt, calculate_patch_dt (leaves[leaf], layer));
+      }
+    }, leaves_grain);
+    threads.reduce_min (thread_id, step_dt);
+
+    threads.for_each_chunk (thread_id, leaves.size (), [&] (const work_range &range) {
+      for (unsigned int leaf = range.chunk_begin; leaf < range.chunk_end; leaf++)
+        update_patch (leaves[leaf], layer, step_dt);
+    }, leaves_grain);
+    threads.barrier (thread_id);
+
+    /// Fluxes of all leaves are ready, so coarse cells at interfaces can take fluxes of finer neighbours
+    threads.for_each_chunk (thread_id, leaves.size (), [&] (const work_range &range) {
+      for (unsigned int leaf = range.chunk_begin; leaf < range.chunk_end; leaf++)
+        correct_fluxes (leaves[leaf], next_layer, step_dt, topology);
+    }, leaves_grain);
+
+    if (is_main_thread (thread_id))
+      results_layer = next_layer;
+    threads.barrier (thread_id);
+
+    return step_dt;
+  }
+
+  /// Cells of leaves, which is the count of cells updated by a step
+  unsigned int get_leaves_cells_count () const
+  {
+    return hierarchy.get_leaves ().size () * patch_size * patch_size;
+  }
+
+private:
+  unsigned int get_padded_id (int x, int y) const
+  {
+    return (y + 1) * padded_size + (x + 1);
+  }
+
+  float_type *get_values (unsigned int patch_id, unsigned int layer, unsigned int variable)
+  {
+    return states[patch_id].values[layer].data () + variable * padded_size * padded_size;
+  }
+
+  float_type get_level_dx (unsigned int level) const { return base_dx / static_cast<float_type> (1u << level); }
+  float_type get_level_dy (unsigned int level) const { return base_dy / static_cast<float_type> (1u << level); }
+
+  void fill_conservative (unsigned int patch_id, unsigned int layer, unsigned int cell_id, float_type *q)
+  {
+    fill_state_vector (
+      cell_id, gamma,
+      get_values (patch_id, layer, 0), get_values (patch_id, layer, 1),
+      get_values (patch_id, layer, 2), get_values (patch_id, layer, 3), q);
+  }
+
+  void store_conservative (unsigned int patch_id, unsigned int layer, unsigned int cell_id, const float_type *q)
+  {
+    const float_type cell_rho = q[0];
+    const float_type cell_u = q[1] / cell_rho;
+    const float_type cell_v = q[2] / cell_rho;
+
+    get_values (patch_id, layer, 0)[cell_id] = cell_rho;
+    get_values (patch_id, layer, 1)[cell_id] = cell_u;
+    get_values (patch_id, layer, 2)[cell_id] = cell_v;
+    get_values (patch_id, layer, 3)[cell_id] = calculate_p (gamma, q[3] / cell_rho, cell_u, cell_v, cell_rho);
+  }
+
+  void copy_values (unsigned int source_patch, unsigned int source_cell, unsigned int target_patch, unsigned int target_cell, unsigned int layer)
+  {
+    for (unsigned int variable = 0; variable < variables_count; variable++)
+      get_values (target_patch, layer, variable)[target_cell] = get_values (source_patch, layer, variable)[source_cell];
+  }
+
+  void allocate_patch (unsigned int patch_id)
+  {
+    if (states.size () < hierarchy.get_patches_count ())
+    {
+      states.resize (hierarchy.get_patches_count ());
+      regrid_marks.resize (hierarchy.get_patches_count (), keep);
+    }
+
+    for (auto &values: states[patch_id].values)
+      values.assign (variables_count * padded_size * padded_size, float_type (0.0));
+    states[patch_id].boundary_fluxes.assign (4 * patch_size * variables_count, float_type (0.0));
+    regrid_marks[patch_id] = keep;
+  }
+
+  void release_patch (unsigned int patch_id)
+  {
+    states[patch_id] = patch_state {};
+  }
+
+  /// Averages conservative variables of output fields over the patch cells
+  void load_patch (unsigned int patch_id, unsigned int layer, const grid_topology &topology)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const unsigned int scale = 1u << (hierarchy.get_max_level () - patch.level);
+    const float_type fine_cells = scale * scale;
+
+    for (unsigned int y = 0; y < patch_size; y++)
+    {
+      for (unsigned int x = 0; x < patch_size; x++)
+      {
+        float_type q[variables_count] = { 0.0, 0.0, 0.0, 0.0 };
+        float_type fine_q[variables_count];
+
+        for (unsigned int fy = 0; fy < scale; fy++)
+        {
+          for (unsigned int fx = 0; fx < scale; fx++)
+          {
+            const unsigned int cell_id = topology.get_cell_id ((patch.x * patch_size + x) * scale + fx, (patch.y * patch_size + y) * scale + fy);
+            fill_state_vector (cell_id, gamma, rho, u, v, p, fine_q);
+
+            for (unsigned int c = 0; c < variables_count; c++)
+              q[c] += fine_q[c];
+          }
+        }
+
+        for (auto &component: q)
+          component /= fine_cells;
+        store_conservative (patch_id, layer, get_padded_id (x, y), q);
+      }
+    }
+  }
+
+  void write_patch (unsigned int patch_id, unsigned int layer, const grid_topology &topology)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const unsigned int scale = 1u << (hierarchy.get_max_level () - patch.level);
+    const float_type *values[variables_count] = {
+      get_values (patch_id, layer, 0), get_values (patch_id, layer, 1),
+      get_values (patch_id, layer, 2), get_values (patch_id, layer, 3) };
+
+    for (unsigned int y = 0; y < patch_size; y++)
+    {
+      for (unsigned int x = 0; x < patch_size; x++)
+      {
+        const unsigned int padded_id = get_padded_id (x, y);
+
+        for (unsigned int fy = 0; fy < scale; fy++)
+        {
+          for (unsigned int fx = 0; fx < scale; fx++)
+          {
+            const unsigned int cell_id = topology.get_cell_id ((patch.x * patch_size + x) * scale + fx, (patch.y * patch_size + y) * scale + fy);
+            rho[cell_id] = values[0][padded_id];
+            u[cell_id] = values[1][padded_id];
+            v[cell_id] = values[2][padded_id];
+            p[cell_id] = values[3][padded_id];
+          }
+        }
+      }
+    }
+  }
+
+  /// Prolongation by injection, children cells are volume averages, so injection keeps conservation
+  void prolongate_patch (unsigned int patch_id, unsigned int layer)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const unsigned int half = patch_size / 2;
+
+    for (unsigned int child = 0; child < 4; child++)
+    {
+      const unsigned int child_id = patch.first_child + child;
+      allocate_patch (child_id);
+
+      for (unsigned int y = 0; y < patch_size; y++)
+        for (unsigned int x = 0; x < patch_size; x++)
+          copy_values (
+            patch_id, get_padded_id ((child % 2) * half + x / 2, (child / 2) * half + y / 2),
+            child_id, get_padded_id (x, y), layer);
+    }
+  }
+
+  /// Restriction by averaging of conservative variables of children
+  void restrict_patch (unsigned int patch_id, unsigned int layer)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const unsigned int half = patch_size / 2;
+    allocate_patch (patch_id);
+
+    for (unsigned int y = 0; y < patch_size; y++)
+    {
+      for (unsigned int x = 0; x < patch_size; x++)
+      {
+        const unsigned int child_id = patch.first_child + x / half + 2 * (y / half);
+        float_type q[variables_count] = { 0.0, 0.0, 0.0, 0.0 };
+        float_type fine_q[variables_count];
+
+        for (unsigned int fy = 0; fy < 2; fy++)
+        {
+          for (unsigned int fx = 0; fx < 2; fx++)
+          {
+            fill_conservative (child_id, layer, get_padded_id (2 * (x % half) + fx, 2 * (y % half) + fy), fine_q);
+            for (unsigned int c = 0; c < variables_count; c++)
+              q[c] += fine_q[c];
+          }
+        }
+
+        for (auto &component: q)
+          component /= 4.0;
+        store_conservative (patch_id, layer, get_padded_id (x, y), q);
+      }
+    }
+  }
+
+  float_type calculate_refinement_indicator (unsigned int patch_id, unsigned int layer)
+  {
+    const float_type *patch_rho = get_values (patch_id, layer, 0);
+    float_type indicator = 0.0;
+
+    for (unsigned int y = 0; y < patch_size; y++)
+    {
+      for (unsigned int x = 0; x < patch_size; x++)
+      {
+        const float_type rho_c = patch_rho[get_padded_id (x, y)];
+
+        if (x + 1 < patch_size)
+        {
+          const float_type rho_n = patch_rho[get_padded_id (x + 1, y)];
+          indicator = std::max (indicator, std::fabs (rho_n - rho_c) / std::min (rho_n, rho_c));
+        }
+
+        if (y + 1 < patch_size)
+        {
+          const float_type rho_n = patch_rho[get_padded_id (x, y + 1)];
+          indicator = std::max (indicator, std::fabs (rho_n - rho_c) / std::min (rho_n, rho_c));
+        }
+      }
+    }
+
+    return indicator;
+  }
+
+  void mark_patch (unsigned int patch_id, unsigned int layer)
+  {
+    const float_type indicator = calculate_refinement_indicator (patch_id, layer);
+
+    if (indicator > refine_threshold)
+      regrid_marks[patch_id] = refine;
+    else if (indicator < refine_threshold / 4)
+      regrid_marks[patch_id] = coarsen;
+    else
+      regrid_marks[patch_id] = keep;
+  }
+
+  void refine_patch (unsigned int patch_id, unsigned int layer)
+  {
+    std::vector<unsigned int> refined;
+    if (hierarchy.refine (patch_id, refined))
+      return;
+
+    /// Balance refinements of coarser neighbours come first, their children border the patch children
+    for (auto &refined_patch: refined)
+    {
+      prolongate_patch (refined_patch, layer);
+      release_patch (refined_patch);
+    }
+  }
+
+  void build_hierarchy (unsigned int layer, const grid_topology &topology)
+  {
+    hierarchy.initialize (
+      hierarchy.get_level_nx (0), hierarchy.get_level_ny (0), hierarchy.get_max_level ());
+    states.clear ();
+    regrid_marks.clear ();
+
+    for (auto &leaf: hierarchy.get_leaves ())
+    {
+      allocate_patch (leaf);
+      load_patch (leaf, layer, topology);
+    }
+
+    /// Refined patches are loaded from output fields instead of prolongation, so fine features are kept
+    for (unsigned int level = 0; level < hierarchy.get_max_level (); level++)
+    {
+      const std::vector<unsigned int> leaves = hierarchy.get_leaves ();
+
+      for (auto &leaf: leaves)
+      {
+        const auto &patch = hierarchy.get_patch (leaf);
+        if (patch.level != level || !patch.is_leaf () || calculate_refinement_indicator (leaf, layer) <= refine_threshold)
+          continue;
+
+        std::vector<unsigned int> refined;
+        hierarchy.refine (leaf, refined);
+
+        for (auto &refined_patch: refined)
+        {
+          release_patch (refined_patch);
+
+          for (unsigned int child = 0; child < 4; child++)
+          {
+            const unsigned int child_id = hierarchy.get_patch (refined_patch).first_child + child;
+            allocate_patch (child_id);
+            load_patch (child_id, layer, topology);
+          }
+        }
+      }
+    }
+  }
+
+  void regrid (unsigned int layer)
+  {
+    const std::vector<unsigned int> leaves = hierarchy.get_leaves ();
+
+    for (auto &leaf: leaves)
+      if (regrid_marks[leaf] == refine && hierarchy.get_patch (leaf).is_leaf ())
+        refine_patch (leaf, layer);
+
+    /// Parent is coarsened from its first child if all children are leaves that don't need resolution
+    for (auto &leaf: leaves)
+    {
+      const auto &patch = hierarchy.get_patch (leaf);
+      if (patch.parent == amr_hierarchy::no_patch || !patch.is_leaf () || hierarchy.get_patch (patch.parent).first_child != leaf)
+        continue;
+
+      const unsigned int parent_id = patch.parent;
+      bool children_coarsen = true;
+      for (unsigned int child = 0; child < 4; child++)
+        children_coarsen &= regrid_marks[leaf + child] == coarsen;
+
+      if (!children_coarsen || !hierarchy.can_coarsen (parent_id))
+        continue;
+
+      restrict_patch (parent_id, layer);
+      for (unsigned int child = 0; child < 4; child++)
+        release_patch (leaf + child);
+      hierarchy.coarsen (parent_id);
+    }
+  }
+
+  /**
+   * Fills the ghost cell (x, y) of the patch. Coordinates are in cells of the patch level and may be
+   * outside of the domain on periodic sides.
+   */
+  void fill_ghost (unsigned int patch_id, unsigned int ghost_id, unsigned int level, int x, int y, unsigned int layer)
+  {
+    const int level_nx = hierarchy.get_level_nx (level) * patch_size;
+    const int level_ny = hierarchy.get_level_ny (level) * patch_size;
+    const unsigned int cell_x = (x + level_nx) % level_nx;
+    const unsigned int cell_y = (y + level_ny) % level_ny;
+
+    const unsigned int source_id = hierarchy.find_patch (level, cell_x / patch_size, cell_y / patch_size);
+    const auto &source = hierarchy.get_patch (source_id);
+
+    if (source.is_leaf ())
+    {
+      const unsigned int shift = level - source.level;
+      copy_values (
+        source_id, get_padded_id ((cell_x >> shift) - source.x * patch_size, (cell_y >> shift) - source.y * patch_size),
+        patch_id, ghost_id, layer);
+      return;
+    }
+
+    /// Finer neighbour, 2:1 balance keeps it one level finer
+    const unsigned int fine_x = 2 * cell_x;
+    const unsigned int fine_y = 2 * cell_y;
+    const unsigned int fine_id = hierarchy.find_patch (level + 1, fine_x / patch_size, fine_y / patch_size);
+    const auto &fine = hierarchy.get_patch (fine_id);
+
+    float_type q[variables_count] = { 0.0, 0.0, 0.0, 0.0 };
+    float_type fine_q[variables_count];
+
+    for (unsigned int fy = 0; fy < 2; fy++)
+    {
+      for (unsigned int fx = 0; fx < 2; fx++)
+      {
+        fill_conservative (fine_id, layer, get_padded_id (fine_x + fx - fine.x * patch_size, fine_y + fy - fine.y * patch_size), fine_q);
+        for (unsigned int c = 0; c < variables_count; c++)
+          q[c] += fine_q[c];
+      }
+    }
+
+    for (auto &component: q)
+      component /= 4.0;
+    store_conservative (patch_id, layer, ghost_id, q);
+  }
+
+  /// Cell of the patch next to the boundary on the side and its ghost cell
+  void get_side_cells (unsigned int side, unsigned int along, int &x, int &y, int &ghost_x, int &ghost_y) const
+  {
+    const int last = patch_size - 1;
+    const int offsets[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+
+    x = is_edge_left (side) ? 0 : is_edge_right (side) ? last : static_cast<int> (along);
+    y = is_edge_bottom (side) ? 0 : is_edge_top (side) ? last : static_cast<int> (along);
+    ghost_x = x + offsets[side][0];
+    ghost_y = y + offsets[side][1];
+  }
+
+  bool is_domain_boundary (const amr_hierarchy::patch &patch, unsigned int side, const grid_topology &topology) const
+  {
+    const bool on_boundary =
+         (is_edge_left (side) && patch.x == 0)
+      || (is_edge_bottom (side) && patch.y == 0)
+      || (is_edge_right (side) && patch.x + 1 == hierarchy.get_level_nx (patch.level))
+      || (is_edge_top (side) && patch.y + 1 == hierarchy.get_level_ny (patch.level));
+
+    return on_boundary && topology.get_boundary_condition (static_cast<side_type> (side)) != boundary_to_id (boundary_type::periodic);
+  }
+
+  void fill_ghosts (unsigned int patch_id, unsigned int layer, const grid_topology &topology)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+
+    for (unsigned int side = 0; side < 4; side++)
+    {
+      /// Non-periodic domain boundaries reflect the boundary cell, as grid_topology does for mirror boundaries
+      const bool mirror = is_domain_boundary (patch, side, topology);
+
+      for (unsigned int along = 0; along < patch_size; along++)
+      {
+        int x {}, y {}, ghost_x {}, ghost_y {};
+        get_side_cells (side, along, x, y, ghost_x, ghost_y);
+
+        if (mirror)
+          copy_values (patch_id, get_padded_id (x, y), patch_id, get_padded_id (ghost_x, ghost_y), layer);
+        else
+          fill_ghost (
+            patch_id, get_padded_id (ghost_x, ghost_y), patch.level,
+            patch.x * patch_size + ghost_x, patch.y * patch_size + ghost_y, layer);
+      }
+    }
+  }
+
+  float_type calculate_patch_dt (unsigned int patch_id, unsigned int layer)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const float_type *patch_rho = get_values (patch_id, layer, 0);
+    const float_type *patch_u = get_values (patch_id, layer, 1);
+    const float_type *patch_v = get_values (patch_id, layer, 2);
+    const float_type *patch_p = get_values (patch_id, layer, 3);
+
+    float_type max_speed = std::numeric_limits<float_type>::min ();
+
+    for (unsigned int y = 0; y < patch_size; y++)
+    {
+      for (unsigned int x = 0; x < patch_size; x++)
+      {
+        const unsigned int cell_id = get_padded_id (x, y);
+        const float_type a = speed_of_sound_in_gas (gamma, patch_p[cell_id], patch_rho[cell_id]);
+        const float_type cell_u = patch_u[cell_id];
+        const float_type cell_v = patch_v[cell_id];
+
+        max_speed = std::max (max_speed, std::max (std::fabs (cell_u + a), std::fabs (cell_u - a)));
+        max_speed = std::max (max_speed, std::max (std::fabs (cell_v + a), std::fabs (cell_v - a)));
+      }
+    }
+
+    return cfl * std::min (get_level_dx (patch.level), get_level_dy (patch.level)) / max_speed;
+  }
+
+  void update_patch (unsigned int patch_id, unsigned int layer, float_type step_dt)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const unsigned int next_layer = (layer + 1) % 2;
+    const float_type dx = get_level_dx (patch.level);
+    const float_type dy = get_level_dy (patch.level);
+
+    grid_cells_order order;
+    order.initialize (padded_size, padded_size, cells_layout::row_major, 0);
+
+    grid_geometry geometry;
+    geometry.initialize_for_structured_uniform_grid (padded_size, padded_size, dx, dy, order);
+
+    grid_interior_topology topology;
+    topology.initialize_for_structured_uniform_grid (padded_size, padded_size * padded_size);
+
+    const float_type *values[variables_count] = {
+      get_values (patch_id, layer, 0), get_values (patch_id, layer, 1),
+      get_values (patch_id, layer, 2), get_values (patch_id, layer, 3) };
+
+    float_type *next_values[variables_count] = {
+      get_values (patch_id, next_layer, 0), get_values (patch_id, next_layer, 1),
+      get_values (patch_id, next_layer, 2), get_values (patch_id, next_layer, 3) };
+
+    for (unsigned int y = 0; y < patch_size; y++)
+      for (unsigned int x = 0; x < patch_size; x++)
+        euler_2d_calculate_next_cell_values (
+          get_padded_id (x, y), step_dt, gamma, topology, geometry,
+          values[0], next_values[0], values[1], next_values[1],
+          values[2], next_values[2], values[3], next_values[3]);
+
+    /// Boundary fluxes are computed again, the kernel doesn't return them
+    float_type *fluxes = states[patch_id].boundary_fluxes.data ();
+
+    for (unsigned int side = 0; side < 4; side++)
+    {
+      const float_type normal_x = geometry.get_normal_x (0, side);
+      const float_type normal_y = geometry.get_normal_y (0, side);
+      const float_type area = geometry.get_edge_area (0, side);
+
+      for (unsigned int along = 0; along < patch_size; along++)
+      {
+        int x {}, y {}, ghost_x {}, ghost_y {};
+        get_side_cells (side, along, x, y, ghost_x, ghost_y);
+
+        const unsigned int cell_id = get_padded_id (x, y);
+        const unsigned int ghost_id = get_padded_id (ghost_x, ghost_y);
+
+        float_type q_c[variables_count];
+        float_type q_n[variables_count];
+        float_type f_sigma[variables_count];
+
+        fill_state_vector (cell_id, gamma, values[0], values[1], values[2], values[3], q_c);
+        fill_state_vector (ghost_id, gamma, values[0], values[1], values[2], values[3], q_n);
+
+        euler_2d_calculate_edge_flux (
+          gamma, normal_x, normal_y, q_c, q_n,
+          values[3][cell_id], values[3][ghost_id],
+          values[0][cell_id], values[0][ghost_id],
+          f_sigma);
+
+        for (unsigned int c = 0; c < variables_count; c++)
+          fluxes[(side * patch_size + along) * variables_count + c] = area * f_sigma[c];
+      }
+    }
+  }
+
+  /// Replaces fluxes of coarse faces that border finer leaves by sums of fine faces fluxes
+  void correct_fluxes (unsigned int patch_id, unsigned int next_layer, float_type step_dt, const grid_topology &topology)
+  {
+    const auto &patch = hierarchy.get_patch (patch_id);
+    const int offsets[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+    const unsigned int half = patch_size / 2;
+    const float_type volume = get_level_dx (patch.level) * get_level_dy (patch.level);
+    const float_type *coarse_fluxes = states[patch_id].boundary_fluxes.data ();
+
+    for (unsigned int side = 0; side < 4; side++)
+    {
+      if (is_domain_boundary (patch, side, topology))
+        continue;
+
+      const unsigned int neighbour_id = hierarchy.find_patch (patch.level, patch.x + offsets[side][0], patch.y + offsets[side][1]);
+      const auto &neighbour = hierarchy.get_patch (neighbour_id);
+      if (neighbour.level != patch.level || neighbour.is_leaf ())
+        continue;
+
+      const unsigned int opposite_side = (side + 2) % 4;
+      const bool vertical_side = is_edge_left (side) || is_edge_right (side);
+
+      for (unsigned int along = 0; along < patch_size; along++)
+      {
+        /// Children of the neighbour that touch the patch are on the opposite side of it
+        const unsigned int child_along = along / half;
+        const unsigned int child_across = offsets[side][0] + offsets[side][1] < 0 ? 1 : 0;
+        const unsigned int child = vertical_side ? child_across + 2 * child_along : child_along + 2 * child_across;
+        const float_type *fine_fluxes = states[neighbour.first_child + child].boundary_fluxes.data ();
+        const unsigned int fine_along = 2 * (along % half);
+
+        int x {}, y {}, ghost_x {}, ghost_y {};
+        get_side_cells (side, along, x, y, ghost_x, ghost_y);
+        const unsigned int cell_id = get_padded_id (x, y);
+
+        float_type q[variables_count];
+        fill_conservative (patch_id, next_layer, cell_id, q);
+
+        for (unsigned int c = 0; c < variables_count; c++)
+        {
+          const float_type coarse_flux = coarse_fluxes[(side * patch_size + along) * variables_count + c];
+          const float_type fine_flux =
+              fine_fluxes[(opposite_side * patch_size + fine_along + 0) * variables_count + c]
+            + fine_fluxes[(opposite_side * patch_size + fine_along + 1) * variables_count + c];
+
+          /// Fine fluxes leave the neighbour, so they enter the patch with the opposite sign
+          q[c] += (step_dt / volume) * (coarse_flux + fine_flux);
+        }
+
+        store_conservative (patch_id, next_layer, cell_id, q);
+      }
+    }
+  }
+};
+
+#endif  // ANYSIM_EULER_2D_AMR_H
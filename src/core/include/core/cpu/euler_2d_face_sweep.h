@@ -0,0 +1,324 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_EULER_2D_FACE_SWEEP_H
+#define ANYSIM_EULER_2D_FACE_SWEEP_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "core/grid/grid.h"
+#include "core/gpu/euler_2d.cuh"
+#include "cpp/common_funcs.h"
+
+#ifdef SIMD_BUILD
+#include "core/cpu/euler_2d_simd.h"
+#endif
+
+/**
+ * Face-centric version of euler_2d_calculate_next_cell_values for row-major structured grids.
+ * Cell-centric kernel computes flux of each interior face twice, once for each of its cells.
+ * Here cells of a range are processed row by row: fluxes of x-faces of the row and of y-faces
+ * above it are computed once and accumulated into both adjacent cells. Top fluxes of a row are
+ * bottom fluxes of the next one.
+ *
+ * Each thread owns the cells of its range and writes only them, fluxes live in buffers of the
+ * thread. Faces on the borders of ranges are computed by both threads, which is a row of faces
+ * per range.
+ *
+ * Flux from the neighbour equals the negated flux of the cell: rotations, flux vectors and wave
+ * speeds change their signs exactly. Fluxes are accumulated in the order of the cell-centric
+ * kernel, so both kernels give the same results.
+ */
+template <class float_type>
+class euler_2d_face_sweep
+{
+  /// Fluxes of a row, component c of face x is at [c * stride + x]
+  struct row_fluxes
+  {
+    std::vector<float_type> x;      /// Through the left face of cell x, face nx is the right face of the row
+    std::vector<float_type> bottom; /// Through the bottom face of cell x
+    std::vector<float_type> top;    /// Through the top face of cell x
+  };
+
+  unsigned int stride = 0;
+  std::vector<row_fluxes> threads_fluxes;
+
+#ifdef SIMD_BUILD
+  /// Null if the grid isn't uniform one
+  const euler_2d_simd_kernels<float_type> *simd_kernels = nullptr;
+#endif
+
+public:
+  static bool is_supported (const grid_topology &topology)
+  {
+    return !topology.is_complex () && topology.get_cells_order ().get_layout () == cells_layout::row_major;
+  }
+
+  /**
+   * @param is_uniform Edges areas and volumes of all cells are the same, which vector kernels rely on
+   * @param use_simd False keeps scalar kernels even on uniform grids
+   */
+  void initialize (unsigned int threads_count, const grid_topology &topology, bool is_uniform, bool use_simd = true)
+  {
+    stride = topology.get_nx () + 1;
+    threads_fluxes.resize (threads_count);
+
+    for (auto &fluxes: threads_fluxes)
+    {
+      fluxes.x.assign (4 * stride, 0.0);
+      fluxes.bottom.assign (4 * stride, 0.0);
+      fluxes.top.assign (4 * stride, 0.0);
+    }
+
+#ifdef SIMD_BUILD
+    simd_kernels = is_uniform && use_simd ? &get_euler_2d_simd_kernels<float_type> () : nullptr;
+#else
+    cpp_unreferenced (is_uniform, use_simd);
+#endif
+  }
+
+  /**
+   * Values of the next time step of cells [begin, end), boundary faces are computed with boundary_topology.
+   * Layers of conservative variables are passed in place of u, v and p, see euler_2d_load_state.
+   * @param max_wave_speed Optional, raised to euler_2d_calculate_max_wave_speed of the next values of the cells
+   */
+  template <euler_2d_variables variables, class boundary_topology_type>
+  void calculate_next_cells_values (
+      unsigned int thread_id,
+      unsigned int begin,
+      unsigned int end,
+
+      float_type dt,
+      float_type gamma,
+
+      const grid_topology &topology,
+      const boundary_topology_type &boundary_topology,
+      const grid_geometry &geometry,
+
+      const float_type *p_rho,
+      float_type *p_rho_next,
+      const float_type *p_u,
+      float_type *p_u_next,
+      const float_type *p_v,
+      float_type *p_v_next,
+      const float_type *p_p,
+      float_type *p_p_next,
+
+      float_type *max_wave_speed = nullptr)
+  {
+    if (begin >= end)
+      return;
+
+    const unsigned int nx = topology.get_nx ();
+    const unsigned int ny = topology.get_ny ();
+
+    row_fluxes &fluxes = threads_fluxes[thread_id];
+    float_type *x_fluxes = fluxes.x.data ();
+    float_type *bottom_fluxes = fluxes.bottom.data ();
+    float_type *top_fluxes = fluxes.top.data ();
+
+    /// Flux of the edge of the cell, negated one if the edge looks against the axis
+    auto calculate_boundary_face_flux = [&] (unsigned int cell_id, unsigned int edge_id, float_type *face_fluxes) {
+      float_type f_sigma[4];
+
+      euler_2d_calculate_face_flux<variables> (
+          cell_id, euler_2d_get_neighbor_id (cell_id, edge_id, boundary_topology), gamma,
+          static_cast<float_type> (geometry.get_normal_x (cell_id, edge_id)),
+          static_cast<float_type> (geometry.get_normal_y (cell_id, edge_id)),
+          p_rho, p_u, p_v, p_p, f_sigma);
+
+      for (unsigned int c = 0; c < 4; c++)
+        face_fluxes[c * stride] = edge_id < 2 ? -f_sigma[c] : f_sigma[c];
+    };
+
+    /// Columns of the previous row whose top fluxes are in bottom_fluxes
+    unsigned int previous_begin = 0;
+    unsigned int previous_end = 0;
+
+    for (unsigned int row_begin = topology.get_cell_id (0, topology.get_cell_y (begin)); row_begin < end; row_begin += nx)
+    {
+      const unsigned int y = topology.get_cell_y (row_begin);
+      const unsigned int x_begin = std::max (begin, row_begin) - row_begin;
+      const unsigned int x_end = std::min (end, row_begin + nx) - row_begin;
+
+      /// x-faces, faces between cells of the row are computed from the left cell
+      const unsigned int interior_faces_begin = std::max (x_begin, 1u);
+      const unsigned int interior_faces_end = std::min (x_end, nx - 1) + 1;
+
+      if (x_begin == 0)
+        calculate_boundary_face_flux (row_begin, 0, x_fluxes);
+      calculate_faces_fluxes<variables> (
+          row_begin + interior_faces_begin - 1, row_begin + interior_faces_end - 1, 1, 2,
+          gamma, geometry, p_rho, p_u, p_v, p_p, x_fluxes + interior_faces_begin);
+      if (x_end == nx)
+        calculate_boundary_face_flux (row_begin + nx - 1, 2, x_fluxes + nx);
+
+      /// Bottom faces that weren't computed as top faces of the previous row
+      auto calculate_bottom_fluxes = [&] (unsigned int from, unsigned int to) {
+        if (from >= to)
+          return;
+
+        if (y > 0)
+          calculate_faces_fluxes<variables> (
+              row_begin - nx + from, row_begin - nx + to, nx, 3,
+              gamma, geometry, p_rho, p_u, p_v, p_p, bottom_fluxes + from);
+        else
+          for (unsigned int x = from; x < to; x++)
+            calculate_boundary_face_flux (row_begin + x, 1, bottom_fluxes + x);
+      };
+
+      calculate_bottom_fluxes (x_begin, std::min (x_end, previous_begin));
+      calculate_bottom_fluxes (std::max (x_begin, previous_end), x_end);
+
+      /// Top faces
+      if (y + 1 < ny)
+        calculate_faces_fluxes<variables> (
+            row_begin + x_begin, row_begin + x_end, nx, 3,
+            gamma, geometry, p_rho, p_u, p_v, p_p, top_fluxes + x_begin);
+      else
+        for (unsigned int x = x_begin; x < x_end; x++)
+          calculate_boundary_face_flux (row_begin + x, 3, top_fluxes + x);
+
+      update_cells_values<variables> (
+          row_begin + x_begin, row_begin + x_end, dt, gamma, geometry,
+          x_fluxes + x_begin, bottom_fluxes + x_begin, top_fluxes + x_begin,
+          p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+
+      std::swap (bottom_fluxes, top_fluxes);
+      previous_begin = x_begin;
+      previous_end = x_end;
+    }
+  }
+
+private:
+  /// Fluxes from cells [begin, end) to cells [begin + neighbor_offset, end + neighbor_offset) through edge_id
+  template <euler_2d_variables variables>
+  void calculate_faces_fluxes (
+      unsigned int begin,
+      unsigned int end,
+      unsigned int neighbor_offset,
+      unsigned int edge_id,
+
+      float_type gamma,
+      const grid_geometry &geometry,
+
+      const float_type *p_rho,
+      const float_type *p_u,
+      const float_type *p_v,
+      const float_type *p_p,
+
+      float_type *fluxes) const
+  {
+    if (begin >= end)
+      return;
+
+    /// Faces of one direction of structured grid share the normal
+    const auto normal_x = static_cast<float_type> (geometry.get_normal_x (begin, edge_id));
+    const auto normal_y = static_cast<float_type> (geometry.get_normal_y (begin, edge_id));
+
+    unsigned int cell_id = begin;
+
+#ifdef SIMD_BUILD
+    if (simd_kernels)
+    {
+      auto kernel = variables == euler_2d_variables::primitive
+                  ? simd_kernels->calculate_faces_fluxes
+                  : simd_kernels->calculate_conservative_faces_fluxes;
+
+      cell_id += kernel (
+          begin, end, neighbor_offset, gamma, normal_x, normal_y,
+          p_rho, p_u, p_v, p_p, fluxes, stride);
+    }
+#endif
+
+    for (; cell_id < end; cell_id++)
+    {
+      float_type f_sigma[4];
+
+      euler_2d_calculate_face_flux<variables> (
+          cell_id, cell_id + neighbor_offset, gamma, normal_x, normal_y,
+          p_rho, p_u, p_v, p_p, f_sigma);
+
+      for (unsigned int c = 0; c < 4; c++)
+        fluxes[c * stride + cell_id - begin] = f_sigma[c];
+    }
+  }
+
+  /// Cells [begin, end) of one row, fluxes are indexed from begin
+  template <euler_2d_variables variables>
+  void update_cells_values (
+      unsigned int begin,
+      unsigned int end,
+
+      float_type dt,
+      float_type gamma,
+      const grid_geometry &geometry,
+
+      const float_type *x_fluxes,
+      const float_type *bottom_fluxes,
+      const float_type *top_fluxes,
+
+      const float_type *p_rho,
+      float_type *p_rho_next,
+      const float_type *p_u,
+      float_type *p_u_next,
+      const float_type *p_v,
+      float_type *p_v_next,
+      const float_type *p_p,
+      float_type *p_p_next,
+
+      float_type *max_wave_speed) const
+  {
+    unsigned int cell_id = begin;
+
+#ifdef SIMD_BUILD
+    if (simd_kernels)
+    {
+      euler_2d_simd_stencil stencil {};
+      for (unsigned int edge_id = 0; edge_id < 4; edge_id++)
+        stencil.edges_areas[edge_id] = geometry.get_edge_area (begin, edge_id);
+      stencil.cell_volume = geometry.get_cell_volume (begin);
+
+      auto kernel = variables == euler_2d_variables::primitive
+                  ? simd_kernels->update_cells_values
+                  : simd_kernels->update_conservative_cells_values;
+
+      cell_id += kernel (
+          begin, end, dt, gamma, stencil,
+          x_fluxes, bottom_fluxes, top_fluxes, stride,
+          p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+    }
+#endif
+
+    for (; cell_id < end; cell_id++)
+    {
+      const unsigned int i = cell_id - begin;
+
+      float_type q_c[4], rho_c, pressure_c;
+      euler_2d_load_state<variables> (cell_id, gamma, p_rho, p_u, p_v, p_p, q_c, rho_c, pressure_c);
+
+      /// Left and bottom fluxes are directed into the cell, edges go in the order of the cell-centric kernel
+      float_type flux[4] = {0.0, 0.0, 0.0, 0.0};
+      for (int c = 0; c < 4; c++)
+      {
+        flux[c] += geometry.get_edge_area (cell_id, 0) * -x_fluxes[c * stride + i];
+        flux[c] += geometry.get_edge_area (cell_id, 1) * -bottom_fluxes[c * stride + i];
+        flux[c] += geometry.get_edge_area (cell_id, 2) * x_fluxes[c * stride + i + 1];
+        flux[c] += geometry.get_edge_area (cell_id, 3) * top_fluxes[c * stride + i];
+      }
+
+      euler_2d_update_cell_values<variables> (
+          cell_id, dt, gamma, geometry.get_cell_volume (cell_id),
+          q_c, flux, p_rho_next, p_u_next, p_v_next, p_p_next);
+
+      if (max_wave_speed)
+        *max_wave_speed = std::max (*max_wave_speed, euler_2d_calculate_max_wave_speed<variables> (
+            cell_id, gamma, p_rho_next, p_u_next, p_v_next, p_p_next));
+    }
+  }
+};
+
+#endif  // ANYSIM_EULER_2D_FACE_SWEEP_H
@@ -0,0 +1,506 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_EULER_2D_MUSCL_H
+#define ANYSIM_EULER_2D_MUSCL_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "core/grid/grid.h"
+#include "core/gpu/euler_2d.cuh"
+
+enum class euler_2d_slope_limiter
+{
+  none,               /// Piecewise constant reconstruction, first order in space
+  minmod,
+  van_leer,
+  monotonized_central
+};
+
+enum class euler_2d_time_integration
+{
+  euler,   /// Forward Euler
+  ssp_rk2, /// Two-stage strong stability preserving Runge-Kutta method
+  ssp_rk3  /// Three-stage strong stability preserving Runge-Kutta method
+};
+
+/// Slope of the cell from its differences with the left and the right neighbours, zero at extrema
+template <euler_2d_slope_limiter limiter, class float_type>
+float_type euler_2d_limit_slope (float_type left_difference, float_type right_difference)
+{
+  if constexpr (limiter == euler_2d_slope_limiter::none)
+    return 0.0f;
+
+  if (left_difference * right_difference <= 0.0f)
+    return 0.0f;
+
+  const float_type left_abs = std::fabs (left_difference);
+  const float_type right_abs = std::fabs (right_difference);
+
+  if constexpr (limiter == euler_2d_slope_limiter::minmod)
+  {
+    return left_abs < right_abs ? left_difference : right_difference;
+  }
+  else if constexpr (limiter == euler_2d_slope_limiter::van_leer)
+  {
+    return 2.0f * left_difference * right_difference / (left_difference + right_difference);
+  }
+  else
+  {
+    const float_type slope_abs = std::min (std::min (2.0f * left_abs, 2.0f * right_abs), std::fabs (left_difference + right_difference) / 2.0f);
+    return left_difference > 0.0f ? slope_abs : -slope_abs;
+  }
+}
+
+/**
+ * Second order in space and time version of the Rusanov scheme for row-major structured grids:
+ * MUSCL reconstruction of primitive variables with a slope limiter and strong stability
+ * preserving Runge-Kutta stages (S. Gottlieb, C.-W. Shu, Total variation diminishing Runge-Kutta
+ * schemes, 1998).
+ *
+ * Stages are fused tile by tile. A thread copies the tile with a halo into its buffers and
+ * computes all stages there, so intermediate states stay in cache instead of workspace layers.
+ * Every stage reads reconstruction_radius more cells on each side than the next one needs, so
+ * the halo is reconstruction_radius cells per stage and halo cells are computed by every tile
+ * that covers them. Periodic sides wrap the halo around the grid. Halo cells behind other sides
+ * are copies of boundary cells, as missing neighbours of euler_2d_get_neighbor_id, and they
+ * are copied again after each stage.
+ *
+ * Slopes are computed in index space, so on rectilinear grids the reconstruction is second
+ * order only where spacing changes smoothly. With limiter none and forward Euler the results
+ * match euler_2d_calculate_next_cell_values.
+ */
+template <class float_type>
+class euler_2d_muscl
+{
+  /// Component c of padded tile cell (i, j) is at [c * tile_area + j * pitch + i]
+  struct tile_buffers
+  {
+    std::vector<float_type> initial;      /// Conserved variables of the time step
+    std::vector<float_type> stage;        /// Conserved variables of the last stage
+    std::vector<float_type> primitive[2]; /// Primitive variables of the last stage and of the next one
+
+    /// Fluxes of a row, component c of face i is at [c * pitch + i], see euler_2d_face_sweep
+    std::vector<float_type> x_fluxes;
+    std::vector<float_type> bottom_fluxes;
+    std::vector<float_type> top_fluxes;
+
+    /// Grid coordinates of padded columns and rows
+    std::vector<unsigned int> columns;
+    std::vector<unsigned int> rows;
+  };
+
+  unsigned int tile_nx = 0;
+  unsigned int tile_ny = 0;
+  unsigned int tiles_x = 0;
+  unsigned int tiles_count = 0;
+
+  unsigned int reconstruction_radius = 0;
+  unsigned int halo = 0;
+  unsigned int pitch = 0;
+  unsigned int tile_area = 0;
+
+  /// Stage s is initial_weights[s] * U^n + (1 - initial_weights[s]) * (U^(s) + dt * L (U^(s)))
+  unsigned int stages_count = 0;
+  float_type initial_weights[3] = {};
+
+  std::vector<tile_buffers> threads_buffers;
+
+public:
+  static constexpr unsigned int default_tile_nx = 128;
+  static constexpr unsigned int default_tile_ny = 32;
+
+  static bool is_supported (const grid_topology &topology)
+  {
+    return !topology.is_complex () && topology.get_cells_order ().get_layout () == cells_layout::row_major;
+  }
+
+  void initialize (
+      unsigned int threads_count,
+      const grid_topology &topology,
+      euler_2d_slope_limiter limiter,
+      euler_2d_time_integration time_integration,
+      unsigned int tile_nx_arg = default_tile_nx,
+      unsigned int tile_ny_arg = default_tile_ny)
+  {
+    tile_nx = std::min (tile_nx_arg, topology.get_nx ());
+    tile_ny = std::min (tile_ny_arg, topology.get_ny ());
+    tiles_x = (topology.get_nx () + tile_nx - 1) / tile_nx;
+    tiles_count = tiles_x * ((topology.get_ny () + tile_ny - 1) / tile_ny);
+
+    switch (time_integration)
+    {
+      case euler_2d_time_integration::euler:
+        stages_count = 1;
+        break;
+      case euler_2d_time_integration::ssp_rk2:
+        stages_count = 2;
+        initial_weights[1] = 0.5;
+        break;
+      case euler_2d_time_integration::ssp_rk3:
+        stages_count = 3;
+        initial_weights[1] = 0.75;
+        initial_weights[2] = float_type (1.0) / float_type (3.0);
+        break;
+    }
+
+    /// Face state of the reconstruction depends on two cells of each side
+    reconstruction_radius = limiter == euler_2d_slope_limiter::none ? 1 : 2;
+    halo = reconstruction_radius * stages_count;
+    pitch = tile_nx + 2 * halo;
+    tile_area = pitch * (tile_ny + 2 * halo);
+
+    threads_buffers.resize (threads_count);
+    for (auto &buffers: threads_buffers)
+    {
+      buffers.initial.assign (4 * tile_area, 0.0);
+      buffers.stage.assign (4 * tile_area, 0.0);
+      buffers.primitive[0].assign (4 * tile_area, 0.0);
+      buffers.primitive[1].assign (4 * tile_area, 0.0);
+      buffers.x_fluxes.assign (4 * pitch, 0.0);
+      buffers.bottom_fluxes.assign (4 * pitch, 0.0);
+      buffers.top_fluxes.assign (4 * pitch, 0.0);
+      buffers.columns.assign (pitch, 0);
+      buffers.rows.assign (tile_ny + 2 * halo, 0);
+    }
+  }
+
+  /// Tiles go in row-major order, tiles of the last column and row may be smaller
+  unsigned int get_tiles_count () const { return tiles_count; }
+
+  /**
+   * Values of the next time step of cells of tiles [tiles_begin, tiles_end).
+   * Layers of conservative variables are passed in place of u, v and p, see euler_2d_load_state.
+   * @param max_wave_speed Optional, raised to euler_2d_calculate_max_wave_speed of the next values of the cells
+   */
+  template <euler_2d_variables variables, euler_2d_slope_limiter limiter>
+  void calculate_next_cells_values (
+      unsigned int thread_id,
+      unsigned int tiles_begin,
+      unsigned int tiles_end,
+
+      float_type dt,
+      float_type gamma,
+
+      const grid_topology &topology,
+      const grid_geometry &geometry,
+
+      const float_type *p_rho,
+      float_type *p_rho_next,
+      const float_type *p_u,
+      float_type *p_u_next,
+      const float_type *p_v,
+      float_type *p_v_next,
+      const float_type *p_p,
+      float_type *p_p_next,
+
+      float_type *max_wave_speed = nullptr)
+  {
+    tile_buffers &buffers = threads_buffers[thread_id];
+
+    for (unsigned int tile_id = tiles_begin; tile_id < tiles_end; tile_id++)
+    {
+      const unsigned int x_begin = (tile_id % tiles_x) * tile_nx;
+      const unsigned int y_begin = (tile_id / tiles_x) * tile_ny;
+      const unsigned int width = std::min (tile_nx, topology.get_nx () - x_begin) + 2 * halo;
+      const unsigned int height = std::min (tile_ny, topology.get_ny () - y_begin) + 2 * halo;
+
+      const bool is_left_periodic = topology.get_boundary_condition (side_type::left) == boundary_to_id (boundary_type::periodic);
+      const bool is_bottom_periodic = topology.get_boundary_condition (side_type::bottom) == boundary_to_id (boundary_type::periodic);
+      const bool is_right_periodic = topology.get_boundary_condition (side_type::right) == boundary_to_id (boundary_type::periodic);
+      const bool is_top_periodic = topology.get_boundary_condition (side_type::top) == boundary_to_id (boundary_type::periodic);
+
+      /// Padded cells that are copies of boundary cells
+      const unsigned int ghost_columns_begin = !is_left_periodic && x_begin < halo ? halo - x_begin : 0;
+      const unsigned int ghost_rows_begin = !is_bottom_periodic && y_begin < halo ? halo - y_begin : 0;
+      const unsigned int ghost_columns_end = !is_right_periodic && x_begin + width - halo > topology.get_nx ()
+                                           ? topology.get_nx () + halo - x_begin : width;
+      const unsigned int ghost_rows_end = !is_top_periodic && y_begin + height - halo > topology.get_ny ()
+                                        ? topology.get_ny () + halo - y_begin : height;
+
+      for (unsigned int i = 0; i < width; i++)
+        buffers.columns[i] = get_source_coordinate (
+            static_cast<int> (x_begin + i) - static_cast<int> (halo), topology.get_nx (), is_left_periodic, is_right_periodic);
+      for (unsigned int j = 0; j < height; j++)
+        buffers.rows[j] = get_source_coordinate (
+            static_cast<int> (y_begin + j) - static_cast<int> (halo), topology.get_ny (), is_bottom_periodic, is_top_periodic);
+
+      load_tile<variables> (buffers, width, height, gamma, topology, p_rho, p_u, p_v, p_p);
+
+      for (unsigned int stage_id = 0; stage_id < stages_count; stage_id++)
+      {
+        const unsigned int border = reconstruction_radius * (stage_id + 1);
+        const bool is_last_stage = stage_id + 1 == stages_count;
+
+        calculate_stage<variables, limiter> (
+            buffers, stage_id, border, width - border, border, height - border,
+            dt, gamma, topology, geometry, is_last_stage,
+            p_rho_next, p_u_next, p_v_next, p_p_next, max_wave_speed);
+
+        if (!is_last_stage)
+          copy_ghost_cells (
+              buffers.primitive[(stage_id + 1) % 2].data (), buffers.stage.data (),
+              border, width - border, border, height - border,
+              ghost_columns_begin, ghost_columns_end, ghost_rows_begin, ghost_rows_end);
+      }
+    }
+  }
+
+private:
+  /// Grid coordinate of the cell that padded coordinate refers to, other sides than periodic ones clamp it
+  static unsigned int get_source_coordinate (int coordinate, unsigned int n, bool is_low_periodic, bool is_high_periodic)
+  {
+    const int count = static_cast<int> (n);
+
+    if (coordinate < 0)
+      return is_low_periodic ? static_cast<unsigned int> (((coordinate % count) + count) % count) : 0;
+    if (coordinate >= count)
+      return is_high_periodic ? static_cast<unsigned int> (coordinate % count) : n - 1;
+    return static_cast<unsigned int> (coordinate);
+  }
+
+  template <euler_2d_variables variables>
+  void load_tile (
+      tile_buffers &buffers,
+      unsigned int width,
+      unsigned int height,
+      float_type gamma,
+      const grid_topology &topology,
+      const float_type *p_rho,
+      const float_type *p_u,
+      const float_type *p_v,
+      const float_type *p_p) const
+  {
+    float_type *initial = buffers.initial.data ();
+    float_type *primitive = buffers.primitive[0].data ();
+
+    for (unsigned int j = 0; j < height; j++)
+    {
+      for (unsigned int i = 0; i < width; i++)
+      {
+        const unsigned int cell_id = topology.get_cell_id (buffers.columns[i], buffers.rows[j]);
+        const unsigned int tile_cell_id = j * pitch + i;
+
+        float_type q[4], rho, p;
+        euler_2d_load_state<variables> (cell_id, gamma, p_rho, p_u, p_v, p_p, q, rho, p);
+
+        for (unsigned int c = 0; c < 4; c++)
+          initial[c * tile_area + tile_cell_id] = q[c];
+
+        primitive[tile_cell_id] = rho;
+        primitive[3 * tile_area + tile_cell_id] = p;
+
+        if constexpr (variables == euler_2d_variables::primitive)
+        {
+          primitive[tile_area + tile_cell_id] = p_u[cell_id];
+          primitive[2 * tile_area + tile_cell_id] = p_v[cell_id];
+        }
+        else
+        {
+          primitive[tile_area + tile_cell_id] = q[1] / q[0];
+          primitive[2 * tile_area + tile_cell_id] = q[2] / q[0];
+        }
+      }
+    }
+  }
+
+  /**
+   * Rusanov flux through the face between tile cells left_id and right_id = left_id + step.
+   * Face states are reconstructed from two cells of each side.
+   */
+  template <euler_2d_slope_limiter limiter>
+  void calculate_face_flux (
+      const float_type *primitive,
+      unsigned int left_id,
+      unsigned int step,
+      float_type gamma,
+      float_type normal_x,
+      float_type normal_y,
+      float_type *f_sigma) const
+  {
+    const unsigned int right_id = left_id + step;
+
+    float_type w_l[4], w_r[4];
+    for (unsigned int c = 0; c < 4; c++)
+    {
+      const float_type *w = primitive + c * tile_area;
+
+      if constexpr (limiter == euler_2d_slope_limiter::none)
+      {
+        w_l[c] = w[left_id];
+        w_r[c] = w[right_id];
+      }
+      else
+      {
+        const float_type difference = w[right_id] - w[left_id];
+        w_l[c] = w[left_id] + euler_2d_limit_slope<limiter> (w[left_id] - w[left_id - step], difference) / 2.0f;
+        w_r[c] = w[right_id] - euler_2d_limit_slope<limiter> (difference, w[right_id + step] - w[right_id]) / 2.0f;
+      }
+    }
+
+    float_type q_l[4], q_r[4];
+    fill_state_vector (0, gamma, w_l, w_l + 1, w_l + 2, w_l + 3, q_l);
+    fill_state_vector (0, gamma, w_r, w_r + 1, w_r + 2, w_r + 3, q_r);
+
+    euler_2d_calculate_edge_flux (gamma, normal_x, normal_y, q_l, q_r, w_l[3], w_r[3], w_l[0], w_r[0], f_sigma);
+  }
+
+  /// Stage of tile cells [i_begin, i_end) x [j_begin, j_end), the last one is written to the grid
+  template <euler_2d_variables variables, euler_2d_slope_limiter limiter>
+  void calculate_stage (
+      tile_buffers &buffers,
+      unsigned int stage_id,
+      unsigned int i_begin,
+      unsigned int i_end,
+      unsigned int j_begin,
+      unsigned int j_end,
+
+      float_type dt,
+      float_type gamma,
+      const grid_topology &topology,
+      const grid_geometry &geometry,
+      bool is_last_stage,
+
+      float_type *p_rho_next,
+      float_type *p_u_next,
+      float_type *p_v_next,
+      float_type *p_p_next,
+      float_type *max_wave_speed) const
+  {
+    const float_type *primitive = buffers.primitive[stage_id % 2].data ();
+    float_type *next_primitive = buffers.primitive[(stage_id + 1) % 2].data ();
+    const float_type *initial = buffers.initial.data ();
+    const float_type *previous = stage_id == 0 ? initial : buffers.stage.data ();
+    float_type *stage = buffers.stage.data ();
+
+    const float_type initial_weight = initial_weights[stage_id];
+    const float_type stage_weight = float_type (1.0) - initial_weight;
+
+    float_type *x_fluxes = buffers.x_fluxes.data ();
+    float_type *bottom_fluxes = buffers.bottom_fluxes.data ();
+    float_type *top_fluxes = buffers.top_fluxes.data ();
+
+    /// Faces of one direction of structured grid share the normal
+    const auto x_normal_x = static_cast<float_type> (geometry.get_normal_x (0, 2));
+    const auto x_normal_y = static_cast<float_type> (geometry.get_normal_y (0, 2));
+    const auto y_normal_x = static_cast<float_type> (geometry.get_normal_x (0, 3));
+    const auto y_normal_y = static_cast<float_type> (geometry.get_normal_y (0, 3));
+
+    auto calculate_y_faces_fluxes = [&] (unsigned int j, float_type *fluxes) {
+      for (unsigned int i = i_begin; i < i_end; i++)
+      {
+        float_type f_sigma[4];
+        calculate_face_flux<limiter> (primitive, j * pitch + i, pitch, gamma, y_normal_x, y_normal_y, f_sigma);
+
+        for (unsigned int c = 0; c < 4; c++)
+          fluxes[c * pitch + i] = f_sigma[c];
+      }
+    };
+
+    calculate_y_faces_fluxes (j_begin - 1, bottom_fluxes);
+
+    for (unsigned int j = j_begin; j < j_end; j++)
+    {
+      /// Face i is the left face of cell i
+      for (unsigned int i = i_begin; i <= i_end; i++)
+      {
+        float_type f_sigma[4];
+        calculate_face_flux<limiter> (primitive, j * pitch + i - 1, 1, gamma, x_normal_x, x_normal_y, f_sigma);
+
+        for (unsigned int c = 0; c < 4; c++)
+          x_fluxes[c * pitch + i] = f_sigma[c];
+      }
+
+      calculate_y_faces_fluxes (j, top_fluxes);
+
+      for (unsigned int i = i_begin; i < i_end; i++)
+      {
+        const unsigned int cell_id = topology.get_cell_id (buffers.columns[i], buffers.rows[j]);
+        const unsigned int tile_cell_id = j * pitch + i;
+
+        /// Left and bottom fluxes are directed into the cell, edges go in the order of the cell-centric kernel
+        float_type flux[4] = {0.0, 0.0, 0.0, 0.0};
+        for (unsigned int c = 0; c < 4; c++)
+        {
+          flux[c] += geometry.get_edge_area (cell_id, 0) * -x_fluxes[c * pitch + i];
+          flux[c] += geometry.get_edge_area (cell_id, 1) * -bottom_fluxes[c * pitch + i];
+          flux[c] += geometry.get_edge_area (cell_id, 2) * x_fluxes[c * pitch + i + 1];
+          flux[c] += geometry.get_edge_area (cell_id, 3) * top_fluxes[c * pitch + i];
+        }
+
+        float_type new_q[4];
+        for (unsigned int c = 0; c < 4; c++)
+        {
+          new_q[c] = previous[c * tile_area + tile_cell_id] - (dt / geometry.get_cell_volume (cell_id)) * flux[c];
+
+          if (stage_id > 0)
+            new_q[c] = initial_weight * initial[c * tile_area + tile_cell_id] + stage_weight * new_q[c];
+        }
+
+        if (is_last_stage)
+        {
+          euler_2d_store_state<variables> (cell_id, gamma, new_q, p_rho_next, p_u_next, p_v_next, p_p_next);
+
+          if (max_wave_speed)
+            *max_wave_speed = std::max (*max_wave_speed, euler_2d_calculate_max_wave_speed<variables> (
+                cell_id, gamma, p_rho_next, p_u_next, p_v_next, p_p_next));
+        }
+        else
+        {
+          for (unsigned int c = 0; c < 4; c++)
+            stage[c * tile_area + tile_cell_id] = new_q[c];
+
+          euler_2d_store_state<euler_2d_variables::primitive> (
+              tile_cell_id, gamma, new_q,
+              next_primitive, next_primitive + tile_area, next_primitive + 2 * tile_area, next_primitive + 3 * tile_area);
+        }
+      }
+
+      std::swap (bottom_fluxes, top_fluxes);
+    }
+  }
+
+  /// Copies boundary cells of tile cells [i_begin, i_end) x [j_begin, j_end) into ghost cells of the region
+  void copy_ghost_cells (
+      float_type *primitive,
+      float_type *stage,
+      unsigned int i_begin,
+      unsigned int i_end,
+      unsigned int j_begin,
+      unsigned int j_end,
+      unsigned int ghost_columns_begin,
+      unsigned int ghost_columns_end,
+      unsigned int ghost_rows_begin,
+      unsigned int ghost_rows_end) const
+  {
+    auto copy_cell = [&] (unsigned int destination_id, unsigned int source_id) {
+      for (unsigned int c = 0; c < 4; c++)
+      {
+        primitive[c * tile_area + destination_id] = primitive[c * tile_area + source_id];
+        stage[c * tile_area + destination_id] = stage[c * tile_area + source_id];
+      }
+    };
+
+    /// Columns first, so that ghost rows copy ghost columns of boundary rows
+    for (unsigned int j = j_begin; j < j_end; j++)
+    {
+      for (unsigned int i = i_begin; i < std::min (i_end, ghost_columns_begin); i++)
+        copy_cell (j * pitch + i, j * pitch + ghost_columns_begin);
+      for (unsigned int i = std::max (i_begin, ghost_columns_end); i < i_end; i++)
+        copy_cell (j * pitch + i, j * pitch + ghost_columns_end - 1);
+    }
+
+    for (unsigned int i = i_begin; i < i_end; i++)
+    {
+      for (unsigned int j = j_begin; j < std::min (j_end, ghost_rows_begin); j++)
+        copy_cell (j * pitch + i, ghost_rows_begin * pitch + i);
+      for (unsigned int j = std::max (j_begin, ghost_rows_end); j < j_end; j++)
+        copy_cell (j * pitch + i, (ghost_rows_end - 1) * pitch + i);
+    }
+  }
+};
+
+#endif  // ANYSIM_EULER_2D_MUSCL_H
@@ -0,0 +1,96 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_EULER_2D_SIMD_H
+#define ANYSIM_EULER_2D_SIMD_H
+
+/**
+ * Cells of uniform structured grid share edges areas and volume, and faces of one direction
+ * share the normal, so consecutive cells and faces go to SIMD lanes directly.
+ */
+struct euler_2d_simd_stencil
+{
+  float edges_areas[4];
+  float cell_volume;
+};
+
+/**
+ * Vectorized euler_2d_calculate_face_flux for faces between cells [begin, end) and cells
+ * [begin + neighbor_offset, end + neighbor_offset). Component c of the face of cell begin + i
+ * is written to fluxes[c * stride + i].
+ * @return number of faces processed from begin. Kernels process whole vectors only, so the
+ *         rest of faces is left for the scalar code.
+ */
+template <class float_type>
+using euler_2d_simd_faces_kernel_type = unsigned int (
+    unsigned int begin,
+    unsigned int end,
+    unsigned int neighbor_offset,
+
+    float_type gamma,
+    float_type normal_x,
+    float_type normal_y,
+
+    const float_type *p_rho,
+    const float_type *p_u,
+    const float_type *p_v,
+    const float_type *p_p,
+
+    float_type *fluxes,
+    unsigned int stride);
+
+/**
+ * Vectorized update of cells [begin, end) of one grid row from faces fluxes, laid out as in
+ * euler_2d_simd_faces_kernel_type. Left and right faces of cell begin + i are x_fluxes[i] and
+ * x_fluxes[i + 1], bottom and top ones are bottom_fluxes[i] and top_fluxes[i]. All fluxes are
+ * directed along the axes. Operations follow euler_2d_calculate_next_cell_values one by one,
+ * so results match the scalar path.
+ * @param max_wave_speed Optional, raised to euler_2d_calculate_max_wave_speed of new values of processed cells
+ * @return number of cells processed from begin
+ */
+template <class float_type>
+using euler_2d_simd_update_kernel_type = unsigned int (
+    unsigned int begin,
+    unsigned int end,
+
+    float_type dt,
+    float_type gamma,
+    const euler_2d_simd_stencil &stencil,
+
+    const float_type *x_fluxes,
+    const float_type *bottom_fluxes,
+    const float_type *top_fluxes,
+    unsigned int stride,
+
+    const float_type *p_rho,
+    float_type *p_rho_next,
+    const float_type *p_u,
+    float_type *p_u_next,
+    const float_type *p_v,
+    float_type *p_v_next,
+    const float_type *p_p,
+    float_type *p_p_next,
+
+    float_type *max_wave_speed);
+
+template <class float_type>
+struct euler_2d_simd_kernels
+{
+  /// Cells values are primitive rho, u, v and p
+  euler_2d_simd_faces_kernel_type<float_type> *calculate_faces_fluxes = nullptr;
+  euler_2d_simd_update_kernel_type<float_type> *update_cells_values = nullptr;
+
+  /// Cells values are conserved rho, rho * u, rho * v and rho * E, passed in place of rho, u, v and p
+  euler_2d_simd_faces_kernel_type<float_type> *calculate_conservative_faces_fluxes = nullptr;
+  euler_2d_simd_update_kernel_type<float_type> *update_conservative_cells_values = nullptr;
+};
+
+/// Kernels of the widest instruction set that the CPU supports. Instruction set is detected on the first call.
+template <class float_type>
+const euler_2d_simd_kernels<float_type> &get_euler_2d_simd_kernels ();
+
+/// Name of the instruction set of get_euler_2d_simd_kernels kernels, e.g. "AVX2"
+const char *get_euler_2d_simd_instruction_set ();
+
+#endif  // ANYSIM_EULER_2D_SIMD_H
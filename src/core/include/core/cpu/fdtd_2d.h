@@ -12,6 +12,7 @@
 #include "core/gpu/coloring.cuh"
 #include "core/cpu/sources_holder.h"
 #include "core/cpu/thread_pool.h"
+#include "core/cpu/adaptive_partition.h"
 #include "core/solver/solver.h"
 #include "core/common/curl.h"
 #include "cpp/common_funcs.h"
@@ -22,26 +23,17 @@
 #include <chrono>
 #include <memory>
 #include <cmath>
-
-constexpr double C0 = 299792458; /// Speed of light [metres per second]
+#include <type_traits>
 
 #ifndef ANYSIM_FDTD_2D_H
 #define ANYSIM_FDTD_2D_H
 
-enum class boundary_condition
-{
-  dirichlet, periodic
-};
-
 template <class float_type>
 class fdtd_2d : public solver
 {
-  boundary_condition left_bc, bottom_bc, right_bc, top_bc;
-
   bool use_gpu = false;
 
   float_type dt = 0.1;
-  float_type t = 0.0;
 
   float_type *m_h = nullptr;
   float_type *dz = nullptr;
@@ -62,16 +54,21 @@ class fdtd_2d : public solver
 
   std::unique_ptr<sources_holder<float_type>> sources;
 
+  /// Shared by update_h and update_e, so neighbours_sync sees the same slices in both
+  adaptive_partition cells_partition;
+
+  using solve_cpu_type = void (fdtd_2d::*) (unsigned int, float_type, const grid_topology &, const grid_geometry &);
+
+  /// solve_cpu instantiation for boundary conditions of the grid
+  solve_cpu_type solve_cpu_function = nullptr;
+
 public:
   fdtd_2d () = delete;
   fdtd_2d (
     thread_pool &threads_arg,
     workspace &solver_workspace_arg)
   : solver (threads_arg, solver_workspace_arg)
-  , left_bc (boundary_condition::periodic)
-  , bottom_bc (boundary_condition::periodic)
-  , right_bc (boundary_condition::periodic)
-  , top_bc (boundary_condition::periodic)
+  , cells_partition (threads_arg.get_threads_count ())
   { }
 
   void fill_configuration_scheme (configuration &config, std::size_t config_id) final
@@ -89,6 +86,12 @@ public:
     return true;
   }
 
+  /// Curl is computed from sides of structured cells
+  bool is_unstructured_mesh_supported () const final
+  {
+    return false;
+  }
+
   void apply_configuration (const configuration &config, std::size_t solver_id, grid *solver_grid_arg, int gpu_num) final
   {
     solver_grid = solver_grid_arg;
@@ -102,16 +105,14 @@ public:
     const auto topology = solver_grid->gen_topology_wrapper ();
     const auto geometry = solver_grid->gen_geometry_wrapper ();
     const unsigned int n_cells = topology.get_cells_count ();
+    cells_partition.reset (topology.get_halo_size ());
 
-    float min_len = std::numeric_limits<float_type>::max ();
-
-    for (unsigned int cell_id = 0; cell_id < n_cells; cell_id++)
-      for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
-        min_len = std::min (min_len, geometry.get_edge_area (cell_id, edge_id));
-
-    dt = cfl * min_len / C0;
-    t = 0.0; /// Reset time
+    /// Boundary conditions don't change until the next configuration, so the kernel is chosen once
+    dispatch_boundary_conditions (topology, [this] (const auto &boundary_topology) {
+      solve_cpu_function = &fdtd_2d::solve_cpu<std::decay_t<decltype (boundary_topology)>>;
+    });
 
+    dt = cfl * geometry.get_min_spacing () / C0;
 
     sources = std::make_unique<sources_holder<float_type>> ();
     for (auto &source_id: config.children_for (sources_id))
@@ -143,11 +144,13 @@ public:
     er  = reinterpret_cast<float_type *> (solver_workspace.get ("er"));
     hr  = reinterpret_cast<float_type *> (solver_workspace.get ("hr"));
 
-    std::fill_n (er, n_cells, 1.0);
-    std::fill_n (hr, n_cells, 1.0);
+    threads.fill (er, n_cells, float_type (1.0), cells_partition);
+    threads.fill (hr, n_cells, float_type (1.0), cells_partition);
 
-    for (unsigned int i = 0; i < n_cells; i++)
-      m_h[i] = C0 * dt / hr[i];
+    threads.execute_first_touch (n_cells, [&] (const work_range &range) {
+      for (unsigned int i = range.chunk_begin; i < range.chunk_end; i++)
+        m_h[i] = C0 * dt / hr[i];
+    }, cells_partition);
 
 #ifdef GPU_BUILD
     if (use_gpu)
@@ -176,31 +179,38 @@ public:
     else
 #endif
     {
-      std::fill_n (hx, n_cells, 0.0);
-      std::fill_n (hy, n_cells, 0.0);
-      std::fill_n (ez, n_cells, 0.0);
-      std::fill_n (dz, n_cells, 0.0);
+      threads.fill (hx, n_cells, float_type (0.0), cells_partition);
+      threads.fill (hy, n_cells, float_type (0.0), cells_partition);
+      threads.fill (ez, n_cells, float_type (0.0), cells_partition);
+      threads.fill (dz, n_cells, float_type (0.0), cells_partition);
     }
   }
 
   void handle_grid_change () final { }
+  void update_results (unsigned int /* thread_id */, unsigned int /* threads_count */) final { }
 
+  template <class boundary_topology_type>
   void update_h (
     unsigned int thread_id,
-    unsigned int total_threads,
     const grid_topology &topology,
+    const boundary_topology_type &boundary_topology,
     const grid_geometry &geometry)
   {
-    auto yr = work_range::split (topology.get_cells_count (), thread_id, total_threads);
-    for (unsigned int cell_id = yr.chunk_begin; cell_id < yr.chunk_end; cell_id++)
-      fdtd_2d_update_h (cell_id, topology, geometry, ez, m_h, hx, hy);
+    cells_partition.for_each_chunk (threads, thread_id, topology.get_cells_count (), [&] (const work_range &yr) {
+      topology.for_each_cells_strip (yr.chunk_begin, yr.chunk_end, boundary_topology, [&] (unsigned int begin, unsigned int end, const auto &strip_topology) {
+        for (unsigned int cell_id = begin; cell_id < end; cell_id++)
+          fdtd_2d_update_h (cell_id, strip_topology, geometry, ez, m_h, hx, hy);
+      });
+    });
   }
 
+  template <class boundary_topology_type>
   void update_e (
     unsigned int thread_id,
-    unsigned int total_threads,
+    float_type t,
     const sources_holder<float_type> &s,
     const grid_topology &topology,
+    const boundary_topology_type &boundary_topology,
     const grid_geometry &geometry)
   {
     const float_type C0_p_dt = C0 * dt;
@@ -208,20 +218,21 @@ public:
     auto sources_offsets = s.get_sources_offsets ();
     auto sources_frequencies = s.get_sources_frequencies ();
 
-    auto yr = work_range::split (topology.get_cells_count (), thread_id, total_threads);
-    for (unsigned int cell_id = yr.chunk_begin; cell_id < yr.chunk_end; cell_id++)
-      fdtd_2d_update_e (
-          cell_id, t, C0_p_dt, topology, geometry, er, hx, hy, dz, ez,
-          s.get_sources_count (), sources_frequencies, sources_offsets);
+    cells_partition.for_each_chunk (threads, thread_id, topology.get_cells_count (), [&] (const work_range &yr) {
+      topology.for_each_cells_strip (yr.chunk_begin, yr.chunk_end, boundary_topology, [&] (unsigned int begin, unsigned int end, const auto &strip_topology) {
+        for (unsigned int cell_id = begin; cell_id < end; cell_id++)
+          fdtd_2d_update_e (
+              cell_id, t, C0_p_dt, strip_topology, geometry, er, hx, hy, dz, ez,
+              s.get_sources_count (), sources_frequencies, sources_offsets);
+      });
+    });
   }
 
   /// Ez mode
-  double solve (unsigned int /* step */, unsigned int thread_id, unsigned int total_threads) final
+  double solve (unsigned int step, unsigned int thread_id, unsigned int /* total_threads */) final
   {
-    threads.barrier ();
-    if (is_main_thread (thread_id))
-      t += dt;
-
+    /// Every thread computes time on its own, so steps aren't separated by barrier
+    const float_type t = static_cast<float_type> (step + 1) * dt;
     const auto topology = solver_grid->gen_topology_wrapper ();
     const auto geometry = solver_grid->gen_geometry_wrapper ();
 
@@ -229,31 +240,39 @@ public:
     if (use_gpu)
     {
       if (is_main_thread (thread_id))
-        solve_gpu (topology, geometry);
+        solve_gpu (t, topology, geometry);
     }
     else
 #endif
     {
-      solve_cpu (thread_id, total_threads, topology, geometry);
+      (this->*solve_cpu_function) (thread_id, t, topology, geometry);
     }
 
     return dt;
   }
 
 private:
+  /// Stencils read cells within halo, so threads wait only for neighbouring slices
+  template <class boundary_topology_type>
   void solve_cpu (
       unsigned int thread_id,
-      unsigned int total_threads,
+      float_type t,
       const grid_topology &topology,
       const grid_geometry &geometry)
   {
-    update_h (thread_id, total_threads, topology, geometry);
-    threads.barrier ();
-    update_e (thread_id, total_threads, *sources, topology, geometry);
+    const unsigned int n_cells = topology.get_cells_count ();
+    const unsigned int halo_size = topology.get_halo_size ();
+    const boundary_topology_type boundary_topology (topology);
+
+    update_h (thread_id, topology, boundary_topology, geometry);
+    threads.neighbours_sync (thread_id, n_cells, halo_size);
+    update_e (thread_id, t, *sources, topology, boundary_topology, geometry);
+    threads.neighbours_sync (thread_id, n_cells, halo_size);
   }
 
 #ifdef GPU_BUILD
   void solve_gpu (
+      float_type t,
       const grid_topology &topology,
       const grid_geometry &geometry)
   {
@@ -0,0 +1,312 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_FDTD_3D_H
+#define ANYSIM_FDTD_3D_H
+
+#include "core/config/configuration.h"
+#include "core/cpu/sources_holder.h"
+#include "core/cpu/thread_pool.h"
+#include "core/cpu/adaptive_partition.h"
+#include "core/solver/solver.h"
+#include "core/grid/grid.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <cstring>
+#include <cmath>
+
+/**
+ * 3D Yee scheme with periodic boundaries. E and H components are stored in grid_3d_topology
+ * order. Threads own slabs of whole layers, so the only data shared between threads are the
+ * boundary layers of neighbouring slabs. Inside of a slab rows are swept in blocks of rows that
+ * walk through all layers of the slab: forward and backward neighbours of the next layer are
+ * still in cache when it's updated.
+ */
+template <class float_type>
+class fdtd_3d : public solver
+{
+  /// Cache that should hold block rows of the three layers read by the stencil
+  static constexpr std::size_t blocking_cache_size = 256 * 1024;
+
+  float_type dt = 0.1;
+
+  float_type *ex = nullptr;
+  float_type *ey = nullptr;
+  float_type *ez = nullptr;
+  float_type *hx = nullptr;
+  float_type *hy = nullptr;
+  float_type *hz = nullptr;
+
+  /// E and H coefficients, C0 * dt / er and C0 * dt / hr. D isn't stored because er doesn't change in time.
+  float_type *me = nullptr;
+  float_type *mh = nullptr;
+
+  /// Middle layer of ez, the planar field that extractors show
+  float_type *ez_slice = nullptr;
+
+  unsigned int block_rows = 1;
+
+  grid *solver_grid = nullptr;
+
+  std::unique_ptr<sources_holder<float_type>> sources;
+
+  /// Partition of layers, shared by update_h and update_e, so neighbours_sync sees the same slabs in both
+  adaptive_partition layers_partition;
+
+public:
+  fdtd_3d () = delete;
+  fdtd_3d (
+    thread_pool &threads_arg,
+    workspace &solver_workspace_arg)
+  : solver (threads_arg, solver_workspace_arg)
+  , layers_partition (threads_arg.get_threads_count ())
+  { }
+
+  void fill_configuration_scheme (configuration &config, std::size_t config_id) final
+  {
+    config.create_node (config_id, "cfl", 0.5);
+    config.create_node (config_id, "nz", 10);
+    config.create_node (config_id, "depth", 1.0);
+    const auto source_scheme_id = config.create_group ("source_scheme");
+    config.create_node (source_scheme_id, "frequency", 1E+8);
+    config.create_node (source_scheme_id, "x", 0.5);
+    config.create_node (source_scheme_id, "y", 0.5);
+    config.create_node (source_scheme_id, "z", 0.5);
+    config.create_array (config_id, "sources", source_scheme_id);
+  }
+
+  bool is_gpu_supported () const final
+  {
+    return false;
+  }
+
+  bool is_unstructured_mesh_supported () const final
+  {
+    return false;
+  }
+
+  void apply_configuration (const configuration &config, std::size_t solver_id, grid *solver_grid_arg, int /* gpu_num */) final
+  {
+    solver_grid = solver_grid_arg;
+    sources.reset ();
+
+    const auto solver_children = config.children_for (solver_id);
+    float_type cfl = config.get_node_value (solver_children[0]);
+    const int nz = config.get_node_value (solver_children[1]);
+    const double depth = config.get_node_value (solver_children[2]);
+    const auto sources_id = solver_children[3];
+
+    if (nz <= 0 || solver_grid->set_layers (nz, depth))
+    {
+      std::cerr << "Error! fdtd_3d needs uniform structured grid and positive nz and depth" << std::endl;
+      return;
+    }
+
+    const auto topology = solver_grid->gen_3d_topology_wrapper ();
+    const auto geometry = solver_grid->gen_3d_geometry_wrapper ();
+    const unsigned int n_cells = topology.get_cells_count ();
+    layers_partition.reset ();
+
+    /// Courant limit of 3D Yee scheme is min spacing / (C0 * sqrt (3)), cfl is relative to 1D limit as in fdtd_2d
+    if (cfl <= float_type (0) || cfl >= float_type (1 / std::sqrt (3.0)))
+    {
+      std::cerr << "cfl " << cfl << " is out of (0, 1/sqrt(3)) stability range of fdtd_3d, 0.5 is used" << std::endl;
+      cfl = 0.5;
+    }
+    dt = cfl * geometry.get_min_spacing () / C0;
+
+    const std::size_t row_bytes = 3 * 4 * topology.get_nx () * sizeof (float_type);
+    block_rows = std::max<std::size_t> (1, std::min<std::size_t> (topology.get_ny (), blocking_cache_size / row_bytes));
+
+    sources = std::make_unique<sources_holder<float_type>> ();
+
+    for (auto &source_id: config.children_for (sources_id))
+    {
+      const auto source_children = config.children_for (source_id);
+      const double frequency = config.get_node_value (source_children[0]);
+      const double x = config.get_node_value (source_children[1]);
+      const double y = config.get_node_value (source_children[2]);
+      const double z = config.get_node_value (source_children[3]);
+
+      sources->append_source (frequency, geometry.get_cell_id_by_coordinates (x, y, z));
+    }
+
+    for (auto field: { "ex", "ey", "ez", "hx", "hy", "hz", "me", "mh" })
+      solver_grid->create_volume_field<float_type> (field, memory_holder_type::host, 1);
+    solver_grid->create_field<float_type> ("ez_slice", memory_holder_type::host, 1);
+
+    ex = reinterpret_cast<float_type *> (solver_workspace.get ("ex"));
+    ey = reinterpret_cast<float_type *> (solver_workspace.get ("ey"));
+    ez = reinterpret_cast<float_type *> (solver_workspace.get ("ez"));
+    hx = reinterpret_cast<float_type *> (solver_workspace.get ("hx"));
+    hy = reinterpret_cast<float_type *> (solver_workspace.get ("hy"));
+    hz = reinterpret_cast<float_type *> (solver_workspace.get ("hz"));
+    me = reinterpret_cast<float_type *> (solver_workspace.get ("me"));
+    mh = reinterpret_cast<float_type *> (solver_workspace.get ("mh"));
+    ez_slice = reinterpret_cast<float_type *> (solver_workspace.get ("ez_slice"));
+
+    /// Vacuum, er = hr = 1
+    const unsigned int layer_cells = topology.get_layer_cells_count ();
+    for (auto field: { ex, ey, ez, hx, hy, hz })
+      threads.fill (field, n_cells, float_type (0.0), layers_partition, layer_cells);
+    threads.fill (me, n_cells, static_cast<float_type> (C0 * dt), layers_partition, layer_cells);
+    threads.fill (mh, n_cells, static_cast<float_type> (C0 * dt), layers_partition, layer_cells);
+    threads.fill (ez_slice, layer_cells, float_type (0.0));
+  }
+
+  void handle_grid_change () final { }
+  void update_results (unsigned int /* thread_id */, unsigned int /* threads_count */) final { }
+
+  double solve (unsigned int step, unsigned int thread_id, unsigned int /* total_threads */) final
+  {
+    /// Unconfigured solver has no fields to update, so the calculation is stopped
+    if (!sources)
+    {
+      if (threads.is_team_leader (thread_id))
+        std::cerr << "Error! fdtd_3d isn't configured, calculation is stopped" << std::endl;
+      return std::numeric_limits<double>::infinity ();
+    }
+
+    const float_type t = static_cast<float_type> (step + 1) * dt;
+    const auto topology = solver_grid->gen_3d_topology_wrapper ();
+    const auto geometry = solver_grid->gen_3d_geometry_wrapper ();
+    const unsigned int nz = topology.get_nz ();
+
+    /// H reads next layer of E, E reads previous layer of H, so slabs wait only for neighbouring slabs.
+    /// Work stealing tiles are single layers, there are only nz of them.
+    layers_partition.for_each_chunk (threads, thread_id, nz, [&] (const work_range &layers) {
+      update_h (layers.chunk_begin, layers.chunk_end, topology, geometry);
+    }, 1);
+    threads.neighbours_sync (thread_id, nz, 1);
+
+    layers_partition.for_each_chunk (threads, thread_id, nz, [&] (const work_range &layers) {
+      update_e (layers.chunk_begin, layers.chunk_end, t, topology, geometry);
+    }, 1);
+    threads.neighbours_sync (thread_id, nz, 1);
+
+    return dt;
+  }
+
+private:
+  /**
+   * Calls action (row_offset, up_offset, front_offset) for every row of layers [z_begin, z_end)
+   * in blocks of block_rows rows. Offsets lead from the row to the next row and the next layer
+   * of the cell (forward) or, if backward, to the previous ones. Boundaries are periodic.
+   */
+  template <class action_type>
+  void for_each_row (
+      unsigned int z_begin,
+      unsigned int z_end,
+      bool backward,
+      const grid_3d_topology &topology,
+      const action_type &action) const
+  {
+    const int nx = topology.get_nx ();
+    const int ny = topology.get_ny ();
+    const int nz = topology.get_nz ();
+    const int layer = nx * ny;
+
+    for (int y_begin = 0; y_begin < ny; y_begin += block_rows)
+    {
+      const int y_end = std::min (ny, y_begin + static_cast<int> (block_rows));
+
+      for (int z = z_begin; z < static_cast<int> (z_end); z++)
+      {
+        const int z_step = backward ? (z == 0 ? (nz - 1) * layer : -layer)
+                                    : (z == nz - 1 ? -(nz - 1) * layer : layer);
+
+        for (int y = y_begin; y < y_end; y++)
+        {
+          const int y_step = backward ? (y == 0 ? (ny - 1) * nx : -nx)
+                                      : (y == ny - 1 ? -(ny - 1) * nx : nx);
+          action (z * layer + y * nx, y_step, z_step);
+        }
+      }
+    }
+  }
+
+  void update_h (unsigned int z_begin, unsigned int z_end, const grid_3d_topology &topology, const grid_3d_geometry &geometry)
+  {
+    const unsigned int nx = topology.get_nx ();
+    const float_type rdx = 1.0 / geometry.get_dx ();
+    const float_type rdy = 1.0 / geometry.get_dy ();
+    const float_type rdz = 1.0 / geometry.get_dz ();
+
+    for_each_row (z_begin, z_end, false, topology, [&] (int row, int y_step, int z_step) {
+      auto update_cell = [&] (unsigned int cell_id, unsigned int right_id)
+      {
+        const unsigned int top_id = cell_id + y_step;
+        const unsigned int front_id = cell_id + z_step;
+
+        const float_type cex = (ez[top_id] - ez[cell_id]) * rdy - (ey[front_id] - ey[cell_id]) * rdz;
+        const float_type cey = (ex[front_id] - ex[cell_id]) * rdz - (ez[right_id] - ez[cell_id]) * rdx;
+        const float_type cez = (ey[right_id] - ey[cell_id]) * rdx - (ex[top_id] - ex[cell_id]) * rdy;
+
+        hx[cell_id] -= mh[cell_id] * cex;
+        hy[cell_id] -= mh[cell_id] * cey;
+        hz[cell_id] -= mh[cell_id] * cez;
+      };
+
+      for (unsigned int cell_id = row; cell_id < row + nx - 1; cell_id++)
+        update_cell (cell_id, cell_id + 1);
+      update_cell (row + nx - 1, row);
+    });
+  }
+
+  void update_e (
+      unsigned int z_begin,
+      unsigned int z_end,
+      float_type t,
+      const grid_3d_topology &topology,
+      const grid_3d_geometry &geometry)
+  {
+    const unsigned int nx = topology.get_nx ();
+    const float_type rdx = 1.0 / geometry.get_dx ();
+    const float_type rdy = 1.0 / geometry.get_dy ();
+    const float_type rdz = 1.0 / geometry.get_dz ();
+
+    for_each_row (z_begin, z_end, true, topology, [&] (int row, int y_step, int z_step) {
+      auto update_cell = [&] (unsigned int cell_id, unsigned int left_id)
+      {
+        const unsigned int bottom_id = cell_id + y_step;
+        const unsigned int back_id = cell_id + z_step;
+
+        const float_type chx = (hz[cell_id] - hz[bottom_id]) * rdy - (hy[cell_id] - hy[back_id]) * rdz;
+        const float_type chy = (hx[cell_id] - hx[back_id]) * rdz - (hz[cell_id] - hz[left_id]) * rdx;
+        const float_type chz = (hy[cell_id] - hy[left_id]) * rdx - (hx[cell_id] - hx[bottom_id]) * rdy;
+
+        ex[cell_id] += me[cell_id] * chx;
+        ey[cell_id] += me[cell_id] * chy;
+        ez[cell_id] += me[cell_id] * chz;
+      };
+
+      update_cell (row, row + nx - 1);
+      for (unsigned int cell_id = row + 1; cell_id < row + nx; cell_id++)
+        update_cell (cell_id, cell_id - 1);
+    });
+
+    /// Sources are soft, as in fdtd_2d they are added to D, which is E in vacuum
+    const unsigned int sources_count = sources->get_sources_count ();
+    const unsigned int *sources_offsets = sources->get_sources_offsets ();
+    const float_type *sources_frequencies = sources->get_sources_frequencies ();
+
+    for (unsigned int source_id = 0; source_id < sources_count; source_id++)
+    {
+      const unsigned int cell_id = sources_offsets[source_id];
+      const unsigned int z = topology.get_cell_z (cell_id);
+
+      if (z >= z_begin && z < z_end)
+        ez[cell_id] += me[cell_id] / (C0 * dt) * calculate_source (t, sources_frequencies[source_id]);
+    }
+
+    const unsigned int slice_z = topology.get_nz () / 2;
+    if (slice_z >= z_begin && slice_z < z_end)
+      std::memcpy (ez_slice, ez + slice_z * topology.get_layer_cells_count (), topology.get_layer_cells_count () * sizeof (float_type));
+  }
+};
+
+#endif // ANYSIM_FDTD_3D_H
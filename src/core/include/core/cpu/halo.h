@@ -0,0 +1,103 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_HALO_H
+#define ANYSIM_HALO_H
+
+#include "core/cpu/thread_pool.h"
+#include "core/grid/grid.h"
+
+/**
+ * Source coordinate of a ghost cell coordinate for one axis. Real coordinates map to themselves.
+ * @return false if the ghost cell has no source (none boundary condition)
+ */
+inline bool get_halo_source (int coordinate, int n, unsigned int low_bc, unsigned int high_bc, int &source)
+{
+  source = coordinate;
+
+  if (coordinate < 0)
+  {
+    if (low_bc == boundary_to_id (boundary_type::periodic))
+      source = coordinate + n;
+    else if (low_bc == boundary_to_id (boundary_type::mirror))
+      source = -coordinate - 1;
+    else
+      return false;
+  }
+  else if (coordinate >= n)
+  {
+    if (high_bc == boundary_to_id (boundary_type::periodic))
+      source = coordinate - n;
+    else if (high_bc == boundary_to_id (boundary_type::mirror))
+      source = 2 * n - coordinate - 1;
+    else
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Boundary-fill phase of a field in halo layout. Ghost cells of periodic sides get values of the
+ * opposite side, ghost cells of mirror sides get the reflected real cells (the first layer is a copy
+ * of the boundary cell, which matches grid_topology neighbours). Ghost cells of sides with none
+ * condition are left to the solver. Left and right ghost columns are filled first, so that bottom
+ * and top ghost rows copy corners from already filled columns. Should be called by all threads of
+ * the team once per step, after the field is updated and before it's read with halo_layout topology.
+ * Ends with barrier.
+ */
+template <class field_type>
+void fill_halo (
+    thread_pool &threads,
+    unsigned int thread_id,
+    const grid_topology &topology,
+    const grid_halo_layout &layout,
+    field_type *field)
+{
+  const int h = static_cast<int> (layout.get_halo_width ());
+  const int nx = static_cast<int> (layout.get_nx ());
+  const int ny = static_cast<int> (layout.get_ny ());
+
+  if (!h)
+    return;
+
+  const unsigned int left_bc = topology.get_boundary_condition (side_type::left);
+  const unsigned int bottom_bc = topology.get_boundary_condition (side_type::bottom);
+  const unsigned int right_bc = topology.get_boundary_condition (side_type::right);
+  const unsigned int top_bc = topology.get_boundary_condition (side_type::top);
+
+  threads.for_each_chunk (thread_id, ny, [&] (const work_range &rows) {
+    for (int y = rows.chunk_begin; y < static_cast<int> (rows.chunk_end); y++)
+    {
+      for (int layer = 0; layer < h; layer++)
+      {
+        int source = 0;
+        if (get_halo_source (-layer - 1, nx, left_bc, right_bc, source))
+          field[layout.get_cell_id (-layer - 1, y)] = field[layout.get_cell_id (source, y)];
+        if (get_halo_source (nx + layer, nx, left_bc, right_bc, source))
+          field[layout.get_cell_id (nx + layer, y)] = field[layout.get_cell_id (source, y)];
+      }
+    }
+  });
+
+  threads.barrier (thread_id);
+
+  threads.for_each_chunk (thread_id, layout.get_padded_nx (), [&] (const work_range &columns) {
+    for (int x = static_cast<int> (columns.chunk_begin) - h; x < static_cast<int> (columns.chunk_end) - h; x++)
+    {
+      for (int layer = 0; layer < h; layer++)
+      {
+        int source = 0;
+        if (get_halo_source (-layer - 1, ny, bottom_bc, top_bc, source))
+          field[layout.get_cell_id (x, -layer - 1)] = field[layout.get_cell_id (x, source)];
+        if (get_halo_source (ny + layer, ny, bottom_bc, top_bc, source))
+          field[layout.get_cell_id (x, ny + layer)] = field[layout.get_cell_id (x, source)];
+      }
+    }
+  });
+
+  threads.barrier (thread_id);
+}
+
+#endif  // ANYSIM_HALO_H
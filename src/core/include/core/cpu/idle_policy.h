@@ -0,0 +1,73 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_IDLE_POLICY_H
+#define ANYSIM_IDLE_POLICY_H
+
+#include <atomic>
+#include <chrono>
+
+#include "core/cpu/cache_line.h"
+
+/**
+ * Waiting thread spins for spin_time, then yields to OS for yield_time and then
+ * parks on futex until it's woken. Adaptive waiter learns spin time from previous
+ * waits: each wait longer than spin_time halves it, so the waiter parks almost at
+ * once if waits are usually longer (e.g. paused GUI), and each shorter wait decays
+ * it back toward spin_time, so bursts after a long pause spin again.
+ */
+struct idle_policy
+{
+  std::chrono::microseconds spin_time {50};
+  std::chrono::microseconds yield_time {200};
+  bool adaptive = true;
+};
+
+/**
+ * Epoch that can be waited by idle_waiter. Advance wakes parked threads only
+ * if there are any, so it's just an increment while waiters spin.
+ */
+class parking_epoch
+{
+public:
+  parking_epoch ()
+    : value (0)
+    , parked (0)
+  { }
+
+  unsigned int load () const { return value.load (std::memory_order_acquire); }
+
+  /// Increments epoch and wakes threads parked on it
+  void advance ();
+
+private:
+  friend class idle_waiter;
+
+  std::atomic<unsigned int> value;
+  std::atomic<unsigned int> parked;
+};
+
+/**
+ * Wait state of one thread. Each thread has its own waiter, so learned spin
+ * time reflects waits of the thread at one place (barrier, pool dispatch).
+ */
+class alignas (get_level1_dcache_linesize ()) idle_waiter
+{
+public:
+  idle_waiter () { set_policy (idle_policy {}); }
+
+  void set_policy (const idle_policy &policy_arg);
+
+  /// Returns when epoch differs from old_value
+  void wait (parking_epoch &epoch, unsigned int old_value);
+
+private:
+  void learn (std::chrono::nanoseconds wait_time);
+
+private:
+  idle_policy policy;
+  std::chrono::nanoseconds spin_budget {};
+};
+
+#endif  // ANYSIM_IDLE_POLICY_H
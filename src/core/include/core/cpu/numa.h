@@ -0,0 +1,22 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_NUMA_H
+#define ANYSIM_NUMA_H
+
+#include <vector>
+
+struct cpu_info
+{
+  unsigned int cpu_id;
+  unsigned int numa_node;
+};
+
+/**
+ * @return CPUs from the process affinity mask ordered by NUMA node. Thread pool
+ *         places thread i on the i-th CPU of this list.
+ */
+std::vector<cpu_info> get_available_cpus ();
+
+#endif  // ANYSIM_NUMA_H
@@ -0,0 +1,82 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_REDUCTION_OPERATIONS_H
+#define ANYSIM_REDUCTION_OPERATIONS_H
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+struct min_operation
+{
+  static constexpr bool is_commutative = true;
+
+  template <class data_type>
+  data_type operator () (const data_type &l, const data_type &r) const { return std::min (l, r); }
+};
+
+struct max_operation
+{
+  static constexpr bool is_commutative = true;
+
+  template <class data_type>
+  data_type operator () (const data_type &l, const data_type &r) const { return std::max (l, r); }
+};
+
+struct sum_operation
+{
+  static constexpr bool is_commutative = true;
+
+  template <class data_type>
+  data_type operator () (const data_type &l, const data_type &r) const { return l + r; }
+};
+
+/**
+ * Operations declare is_commutative to let thread_pool::reduce fold values in any order.
+ * Others, including lambdas, are only assumed to be associative.
+ */
+template <class operation_type, class = void>
+struct is_commutative_operation : std::false_type {};
+
+template <class operation_type>
+struct is_commutative_operation<operation_type, std::void_t<decltype (operation_type::is_commutative)>>
+  : std::bool_constant<operation_type::is_commutative> {};
+
+/**
+ * Applies i-th operation to i-th elements of tuples, so several values can be reduced at once:
+ *
+ *   std::tuple<float, float, double> value {min, max, sum};
+ *   threads.reduce (thread_id, value, tuple_operation (min_operation {}, max_operation {}, sum_operation {}));
+ */
+template <class... operation_types>
+class tuple_operation
+{
+public:
+  static constexpr bool is_commutative = (is_commutative_operation<operation_types>::value && ...);
+
+  explicit tuple_operation (operation_types... operations_arg)
+    : operations (operations_arg...)
+  { }
+
+  template <class... data_types>
+  std::tuple<data_types...> operator () (const std::tuple<data_types...> &l, const std::tuple<data_types...> &r) const
+  {
+    static_assert (sizeof... (data_types) == sizeof... (operation_types), "Error! Each tuple element needs its operation");
+    return apply (l, r, std::index_sequence_for<data_types...> {});
+  }
+
+private:
+  template <class tuple_type, std::size_t... indices>
+  tuple_type apply (const tuple_type &l, const tuple_type &r, std::index_sequence<indices...>) const
+  {
+    return tuple_type (std::get<indices> (operations) (std::get<indices> (l), std::get<indices> (r))...);
+  }
+
+private:
+  std::tuple<operation_types...> operations;
+};
+
+#endif  // ANYSIM_REDUCTION_OPERATIONS_H
@@ -0,0 +1,36 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_TELEMETRY_H
+#define ANYSIM_TELEMETRY_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include <x86intrin.h> // For __rdtsc
+
+#include "core/cpu/cache_line.h"
+
+inline std::uint64_t read_tsc ()
+{
+  return __rdtsc ();
+}
+
+/// TSC ticks of one thread since the last thread_pool::reset_telemetry
+struct thread_telemetry
+{
+  std::uint64_t action_ticks = 0;     /// Time in execute's action, including barriers inside of it
+  std::uint64_t barrier_ticks = 0;    /// Time in team barriers, reductions and neighbours_sync waits
+  std::uint64_t barrier_episodes = 0;
+
+  std::uint64_t get_compute_ticks () const { return action_ticks - barrier_ticks; }
+};
+
+struct cache_padded_telemetry
+{
+  alignas (get_level1_dcache_linesize ()) thread_telemetry value;
+  std::byte padding[get_level1_dcache_linesize () - sizeof (thread_telemetry)];
+};
+
+#endif  // ANYSIM_TELEMETRY_H
@@ -7,21 +7,41 @@
 
 #include <atomic>
 #include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
 #include <thread>
-#include <mutex>
 #include <cstddef>
-#include <functional>
-#include <condition_variable>
+#include <cstdint>
+#include <type_traits>
+#include <new>
 
-constexpr inline unsigned int get_level1_dcache_linesize ()
+#include "core/cpu/barrier.h"
+#include "core/cpu/reduction_operations.h"
+#include "core/cpu/telemetry.h"
+
+struct cache_padded_reduction_slot
 {
-  return 64;
-}
+  alignas (get_level1_dcache_linesize ()) std::byte data[get_level1_dcache_linesize ()];
+};
+
+struct cache_padded_counter
+{
+  unsigned int value;
+  std::byte padding[get_level1_dcache_linesize () - sizeof (unsigned int)];
+};
 
-struct cache_padded_void_ptr
+struct cache_padded_progress
 {
-  void *ptr;
-  std::byte padding[get_level1_dcache_linesize () - sizeof (void *)];
+  alignas (get_level1_dcache_linesize ()) parking_epoch epoch;
+  std::byte padding[get_level1_dcache_linesize () - sizeof (parking_epoch)];
+};
+
+struct cache_padded_tiles_range
+{
+  std::atomic<std::uint64_t> range;
+  unsigned int generation;
+  std::byte padding[get_level1_dcache_linesize () - sizeof (std::atomic<std::uint64_t>) - sizeof (unsigned int)];
 };
 
 class work_range
@@ -57,65 +77,382 @@ inline bool is_main_thread (unsigned int thread_id)
   return thread_id == get_main_thread ();
 }
 
+enum class scheduling_policy
+{
+  static_split, work_stealing, adaptive_split /// Adaptive split for adaptive_partition loops, static for others
+};
+
+/// Name and size of a team of consecutive pool threads, see thread_pool::set_teams
+struct thread_team_size
+{
+  std::string name;
+  unsigned int threads_count;
+};
+
 class thread_pool
 {
 public:
+  static constexpr unsigned int default_tile_size = 2048;
+  static constexpr unsigned int min_tiles_per_thread = 4; /// Tiles of small loops shrink until each thread has this many
+  static constexpr unsigned int max_tiles_count = 1u << 24u; /// Tiles range is packed into 48 bits
+
   thread_pool (const thread_pool &) = delete;
 
   thread_pool ();
   explicit thread_pool (unsigned int thread_count);
   ~thread_pool ();
 
-  void execute (const std::function<void(unsigned int, unsigned int)> &action_arg);
+  /**
+   * Calls action_arg (thread_id, threads_count) on every thread and waits for all of them.
+   * The callable stays on the caller's stack: no copy, no allocation and the main thread
+   * calls it directly. Workers get it through one function pointer.
+   */
+  template <class action_type>
+  void execute (const action_type &action_arg)
+  {
+    dispatch (&invoke_action<action_type>, &action_arg);
+
+    const std::uint64_t action_begin = telemetry_enabled ? read_tsc () : 0;
+    action_arg (get_main_thread (), total_threads);
+    if (telemetry_enabled)
+      telemetry[get_main_thread ()].value.action_ticks += read_tsc () - action_begin;
+
+    pool_barrier (get_main_thread ());
+  }
 
-  void barrier ();
+  /// Waits for the threads of thread_id's team
+  void barrier (unsigned int thread_id);
 
-  template <class data_type, class condition_type>
-  void reduce (unsigned int thread_id, data_type &value, const condition_type &condition)
+  /**
+   * Calls on_group_arrival for each group of arrived threads, see empty_arrival_callback.
+   * Callback gets ids of threads within the team.
+   */
+  template <class callback_type>
+  void barrier (unsigned int thread_id, const callback_type &on_group_arrival)
   {
-    static_assert (std::is_copy_assignable<data_type>::value, "Error! Data type in reduce function has to be copy assignable");
+    thread_team &team = team_of (thread_id);
+    const unsigned int team_thread_id = thread_id - team.first_thread;
+    const std::uint64_t wait_begin = telemetry_enabled ? read_tsc () : 0;
 
-    buffer[thread_id].ptr = &value;
-    barrier ();
+    if (active_barrier_type == barrier_type::combining_tree)
+      team.threads_tree_barrier->wait (team_thread_id, on_group_arrival);
+    else
+      team.threads_barrier.wait (team_thread_id, on_group_arrival);
 
-    if (is_main_thread (thread_id))
-      for (unsigned int thread = get_main_thread () + 1; thread < total_threads; thread++)
-        if (condition (*reinterpret_cast<data_type*> (buffer[thread].ptr), *reinterpret_cast<data_type*> (buffer[thread_id].ptr)))
-          buffer[get_main_thread ()].ptr = buffer[thread].ptr;
+    if (telemetry_enabled)
+      count_barrier_episode (thread_id, wait_begin);
+  }
+
+  /**
+   * Per-thread TSC counters of time in actions and barriers, see thread_telemetry. Costs
+   * two TSC reads per barrier when enabled. Should be called outside of execute.
+   */
+  void set_telemetry (bool enable) { telemetry_enabled = enable; }
+  bool is_telemetry_enabled () const { return telemetry_enabled; }
+  void reset_telemetry ();
+  const thread_telemetry &get_telemetry (unsigned int thread_id) const { return telemetry[thread_id].value; }
+
+  /**
+   * Splits threads into named teams of consecutive threads (in the order of teams_sizes).
+   * Barriers, reductions, for_each_chunk and neighbours_sync only involve the team of the
+   * calling thread, so teams can run different work inside one execute. Thread ids stay
+   * global. The pool starts with one team of all threads. Should be called outside of execute.
+   * @return true if teams sizes don't sum up to the threads count
+   */
+  bool set_teams (const std::vector<thread_team_size> &teams_sizes);
+
+  unsigned int get_threads_count () const { return total_threads; }
+  unsigned int get_teams_count () const { return teams.size (); }
+  unsigned int get_team_id (unsigned int thread_id) const { return threads_teams[thread_id]; }
+  const std::string &get_team_name (unsigned int team_id) const { return teams[team_id]->name; }
+
+  /// @return teams count if there is no team with the name
+  unsigned int find_team (const std::string &name) const;
+
+  unsigned int get_team_thread_id (unsigned int thread_id) const { return thread_id - team_of (thread_id).first_thread; }
+  unsigned int get_team_threads_count (unsigned int thread_id) const { return team_of (thread_id).threads_count; }
+  bool is_team_leader (unsigned int thread_id) const { return get_team_thread_id (thread_id) == 0; }
+
+  /**
+   * Applies to waits for the next execute and to barriers. Should be called outside of execute.
+   * Short spin keeps GUI bursts responsive, parking keeps paused pool from burning cores.
+   */
+  void set_idle_policy (const idle_policy &policy_arg);
+
+  /**
+   * Replaces barrier for phases where each thread works on its static split slice of
+   * [0, work_size) and reads only elements within halo_size (cyclic) of its own. Thread
+   * publishes its progress and waits only for the two neighbouring slices to reach the same
+   * phase, so neighbours never drift apart by more than one phase. Falls back to barrier
+   * with work stealing or when slices are shorter than halo. All threads have to make the
+   * same calls.
+   */
+  void neighbours_sync (unsigned int thread_id, unsigned int work_size, unsigned int halo_size);
+
+  /**
+   * Should be called outside of execute. Combining tree barrier groups fan_in threads
+   * of one NUMA node at its leaves.
+   */
+  void set_barrier_type (barrier_type type, unsigned int fan_in = combining_tree_barrier::default_fan_in);
+  barrier_type get_barrier_type () const { return active_barrier_type; }
+
+  /**
+   * Pins thread i to the i-th CPU of get_available_cpus list, so neighbouring threads share
+   * NUMA node. Pins the calling thread as main thread. Should be called outside of execute.
+   * @return true if some thread wasn't pinned
+   */
+  bool pin_threads ();
 
-    barrier ();
-    value = *reinterpret_cast<data_type*> (buffer[get_main_thread ()].ptr);
-    barrier ();
+  unsigned int get_numa_node (unsigned int thread_id) const { return threads_numa_nodes[thread_id]; }
+
+  /// Chunks of for_each_chunk with static split, default partition of execute_first_touch
+  struct team_split
+  {
+    work_range get_chunk (unsigned int team_thread_id, unsigned int team_threads_count, unsigned int work_size) const
+    {
+      return work_range::split (work_size, team_thread_id, team_threads_count);
+    }
+  };
+
+  /**
+   * Calls action for the chunk of [0, work_size) that partition gives to each thread of the main
+   * thread's team, so with first-touch placement pages written by action land on the NUMA node of
+   * the thread that processes them in solver loops. Threads of other teams (extraction) don't
+   * call action. Partition is team_split or adaptive_partition of the solver loop, whose items
+   * span item_size elements, so the range passed to action is in elements. Should be called
+   * outside of execute.
+   */
+  template <class action_type, class partition_type = team_split>
+  void execute_first_touch (
+    unsigned int work_size,
+    const action_type &action,
+    const partition_type &partition = partition_type {},
+    unsigned int item_size = 1)
+  {
+    const unsigned int compute_team = get_team_id (get_main_thread ());
+
+    execute ([&] (unsigned int thread_id, unsigned int) {
+      if (get_team_id (thread_id) != compute_team)
+        return;
+
+      const auto items = partition.get_chunk (get_team_thread_id (thread_id), get_team_threads_count (thread_id), work_size);
+      action (work_range (items.chunk_begin * item_size, items.chunk_end * item_size));
+    });
+  }
+
+  /// Fills count elements with first-touch placement of execute_first_touch, count has to be a multiple of item_size
+  template <class data_type, class partition_type = team_split>
+  void fill (
+    data_type *data,
+    unsigned int count,
+    const data_type &value,
+    const partition_type &partition = partition_type {},
+    unsigned int item_size = 1)
+  {
+    execute_first_touch (count / item_size, [&] (const work_range &range) {
+      std::fill (data + range.chunk_begin, data + range.chunk_end, value);
+    }, partition, item_size);
+  }
+
+  /**
+   * Should be called outside of execute. With work stealing policy each for_each_chunk call
+   * without its own grain is cut into tiles of at most tile_size_arg elements.
+   */
+  void set_scheduling_policy (scheduling_policy policy_arg, unsigned int tile_size_arg = default_tile_size);
+  scheduling_policy get_scheduling_policy () const { return policy; }
+
+  /**
+   * Calls action for each chunk of [0, work_size) assigned to thread_id. Static split gives every
+   * thread its work_range::split slice. Work stealing cuts the work into tiles, puts each thread's
+   * slice of tiles into its own deque and lets threads that run out of tiles steal half of the
+   * remaining tiles of another thread. Tiles are only stolen within the same call, but the
+   * whole range is processed only after the next barrier. Adaptive split is done only by
+   * adaptive_partition, here it's a static split.
+   *
+   * @param grain Elements per tile of work stealing, e.g. 1 for loops over layers or patches.
+   *              Zero takes tile_size, reduced so that each team thread gets min_tiles_per_thread
+   *              tiles of loops that are too small for tile_size tiles.
+   */
+  template <class action_type>
+  void for_each_chunk (unsigned int thread_id, unsigned int work_size, const action_type &action, unsigned int grain = 0)
+  {
+    const unsigned int team_thread_id = get_team_thread_id (thread_id);
+    const unsigned int team_threads_count = get_team_threads_count (thread_id);
+
+    if (policy != scheduling_policy::work_stealing)
+    {
+      action (work_range::split (work_size, team_thread_id, team_threads_count));
+      return;
+    }
+
+    const unsigned int default_grain = std::max (1u, std::min (tile_size, work_size / (team_threads_count * min_tiles_per_thread)));
+    const unsigned int chunk_size = std::max (grain ? grain : default_grain, work_size / max_tiles_count + 1);
+    const unsigned int tiles_count = work_size / chunk_size + (work_size % chunk_size != 0);
+    push_tiles (thread_id, work_range::split (tiles_count, team_thread_id, team_threads_count));
+
+    do
+    {
+      unsigned int tile {};
+      while (pop_tile (thread_id, tile))
+      {
+        /// End of the last tile might not fit into unsigned int for work sizes close to its limit
+        const std::size_t tile_begin = static_cast<std::size_t> (tile) * chunk_size;
+        const std::size_t tile_end = std::min<std::size_t> (work_size, tile_begin + chunk_size);
+        action (work_range (static_cast<unsigned int> (tile_begin), static_cast<unsigned int> (tile_end)));
+      }
+    }
+    while (steal_tiles (thread_id));
+  }
+
+  /**
+   * Replaces value of each thread with operation applied to values of all threads in the order
+   * of team threads. Operation has to be associative. Values of commutative operations
+   * (min_operation, sum_operation, tuple_operation of them, etc.) are folded in the barrier tree
+   * by the last thread to arrive at each node. Tree nodes group threads by NUMA node rather than
+   * by id, so values of other operations are folded in order by each thread after the barrier.
+   * Either way the reduction costs a single barrier. Reduction slots are double buffered, so
+   * the result of the previous call is intact until every thread has arrived at the next one.
+   */
+  template <class data_type, class operation_type>
+  void reduce (unsigned int thread_id, data_type &value, const operation_type &operation)
+  {
+    static_assert (sizeof (data_type) <= sizeof (cache_padded_reduction_slot::data), "Error! Data type in reduce function has to fit into cache line");
+    static_assert (alignof (data_type) <= alignof (cache_padded_reduction_slot), "Error! Data type in reduce function is overaligned");
+    static_assert (std::is_copy_constructible<data_type>::value, "Error! Data type in reduce function has to be copy constructible");
+    static_assert (std::is_trivially_destructible<data_type>::value, "Error! Data type in reduce function has to be trivially destructible");
+
+    const unsigned int layer = reductions_count[thread_id].value++ % 2;
+    const unsigned int first_thread = team_of (thread_id).first_thread;
+    auto get_slot = [&] (unsigned int team_thread) {
+      return std::launder (reinterpret_cast<data_type *> (reduction_slots[layer * total_threads + first_thread + team_thread].data));
+    };
+
+    new (reduction_slots[layer * total_threads + thread_id].data) data_type (value);
+
+    if constexpr (is_commutative_operation<operation_type>::value)
+    {
+      barrier (thread_id, [&] (unsigned int target, const unsigned int *sources_begin, const unsigned int *sources_end) {
+        data_type &result = *get_slot (target);
+        for (const unsigned int *source = sources_begin; source != sources_end; source++)
+          if (*source != target)
+            result = operation (result, *get_slot (*source));
+      });
+
+      value = *get_slot (get_reduction_root (thread_id));
+    }
+    else
+    {
+      barrier (thread_id);
+
+      const unsigned int team_threads_count = get_team_threads_count (thread_id);
+      data_type result = *get_slot (0);
+      for (unsigned int team_thread = 1; team_thread < team_threads_count; team_thread++)
+        result = operation (result, *get_slot (team_thread));
+      value = result;
+    }
   }
 
   template <class data_type>
   void reduce_min (unsigned int thread_id, data_type &value)
   {
-    reduce (thread_id, value, [] (const data_type &l, const data_type &r) { return l < r; });
+    reduce (thread_id, value, min_operation {});
   }
 
   template <class data_type>
   void reduce_max (unsigned int thread_id, data_type &value)
   {
-    reduce (thread_id, value, [] (const data_type &l, const data_type &r) { return l > r; });
+    reduce (thread_id, value, max_operation {});
+  }
+
+  template <class data_type>
+  void reduce_sum (unsigned int thread_id, data_type &value)
+  {
+    reduce (thread_id, value, sum_operation {});
   }
 
 private:
+  using action_invoker_type = void (*) (const void *, unsigned int, unsigned int);
+
+  template <class action_type>
+  static void invoke_action (const void *action_arg, unsigned int thread_id, unsigned int threads_count)
+  {
+    (*static_cast<const action_type *> (action_arg)) (thread_id, threads_count);
+  }
+
+  /// Consecutive threads with their own barriers
+  struct thread_team
+  {
+    thread_team (
+      std::string name_arg,
+      unsigned int first_thread_arg,
+      unsigned int threads_count_arg);
+
+    const std::string name;
+    const unsigned int first_thread;
+    const unsigned int threads_count;
+    centralized_barrier threads_barrier;
+    std::unique_ptr<combining_tree_barrier> threads_tree_barrier;
+  };
+
+  thread_team &team_of (unsigned int thread_id) { return *teams[threads_teams[thread_id]]; }
+  const thread_team &team_of (unsigned int thread_id) const { return *teams[threads_teams[thread_id]]; }
+
+  void count_barrier_episode (unsigned int thread_id, std::uint64_t wait_begin)
+  {
+    auto &thread_counters = telemetry[thread_id].value;
+    thread_counters.barrier_ticks += read_tsc () - wait_begin;
+    thread_counters.barrier_episodes++;
+  }
+
+  void dispatch (action_invoker_type invoker, const void *action_arg);
+  void wait_for_workers () const;
   void run_thread (unsigned int thread_id);
+  void pool_barrier (unsigned int thread_id);
+  void apply_barrier_type (thread_team &team) const;
+  unsigned int get_reduction_root (unsigned int thread_id) const;
+
+  void push_tiles (unsigned int thread_id, const work_range &tiles);
+  bool pop_tile (unsigned int thread_id, unsigned int &tile);
+  bool steal_tiles (unsigned int thread_id);
 
 private:
-  std::mutex lock;
-  unsigned int epoch;
-  std::condition_variable cv;
+  parking_epoch dispatch_epoch;
+  std::unique_ptr<idle_waiter[]> dispatch_waiters;
+  idle_policy threads_idle_policy;
   std::vector<std::thread> threads;
 
-  std::atomic<unsigned int> barrier_epoch;
-  std::atomic<unsigned int> threads_in_barrier;
+  std::atomic<bool> finalize_pool;
+
+  /// Workers count their exits from execute's last barrier, see wait_for_workers
+  std::uint64_t dispatches_count = 0;
+  alignas (get_level1_dcache_linesize ()) std::atomic<std::uint64_t> workers_departures;
 
-  bool finalize_pool = false;
   const unsigned int total_threads;
-  std::function<void(unsigned int, unsigned int)> action;
-  std::unique_ptr<cache_padded_void_ptr[]> buffer;
+  std::vector<unsigned int> threads_cpus;
+  std::vector<unsigned int> threads_numa_nodes;
+
+  barrier_type active_barrier_type = barrier_type::centralized;
+  unsigned int tree_barrier_fan_in = combining_tree_barrier::default_fan_in;
+  centralized_barrier threads_barrier;
+  std::unique_ptr<combining_tree_barrier> threads_tree_barrier;
+
+  std::vector<std::unique_ptr<thread_team>> teams;
+  std::vector<unsigned int> threads_teams;
+
+  action_invoker_type action_invoker = nullptr;
+  const void *action = nullptr;
+  std::unique_ptr<cache_padded_reduction_slot[]> reduction_slots;
+  std::unique_ptr<cache_padded_counter[]> reductions_count;
+
+  scheduling_policy policy = scheduling_policy::static_split;
+  unsigned int tile_size = default_tile_size;
+  std::unique_ptr<cache_padded_tiles_range[]> tiles;
+
+  std::unique_ptr<cache_padded_progress[]> progress;
+  std::unique_ptr<idle_waiter[]> progress_waiters;
+
+  bool telemetry_enabled = false;
+  std::unique_ptr<cache_padded_telemetry[]> telemetry;
 };
 
 #endif //ANYSIM_THREAD_POOL_H
@@ -43,13 +43,17 @@ CPU_GPU void fill_state_vector (
   q[3] = rhoc * calculate_total_energy (pc, uc, vc, rhoc, gamma);
 }
 
+/**
+ * Flux of the state vector Q_c in edge coordinate system
+ * @param U_c Velocity normal to the edge
+ */
 template <class float_type>
-CPU_GPU void fill_flux_vector (const float_type *Q_c, float_type *F_c, float_type gamma)
+CPU_GPU void fill_flux_vector (const float_type *Q_c, float_type U_c, float_type p_c, float_type *F_c)
 {
-  F_c[0] = Q_c[0] * Q_c[1];
-  F_c[1] = Q_c[0] * Q_c[1] * Q_c[1] + Q_c[3];
-  F_c[2] = Q_c[0] * Q_c[1] * Q_c[2];
-  F_c[3] = Q_c[0] * Q_c[1] * calculate_total_energy (Q_c[3], Q_c[1], Q_c[2], Q_c[0], gamma) + Q_c[1] * Q_c[3];
+  F_c[0] = Q_c[1];
+  F_c[1] = Q_c[1] * U_c + p_c;
+  F_c[2] = Q_c[2] * U_c;
+  F_c[3] = (Q_c[3] + p_c) * U_c;
 }
 
 inline CPU_GPU unsigned int get_neighbor_index (
@@ -169,14 +173,258 @@ CPU_GPU float_type calculate_p (float_type gamma, float_type E, float_type u, fl
   return (E - (u * u + v * v) / 2.0f) * (gamma - 1.0f) * rho;
 }
 
+/// Pressure of ideal gas with state vector q
+template <class float_type>
+CPU_GPU float_type calculate_p_of_state_vector (float_type gamma, const float_type *q)
+{
+  return (gamma - 1.0f) * (q[3] - (q[1] * q[1] + q[2] * q[2]) / (2.0f * q[0]));
+}
+
+/// Cells values of euler_2d layers
+enum class euler_2d_variables
+{
+  primitive,   /// rho, u, v, p
+  conservative /// rho, rho * u, rho * v, rho * E
+};
+
+/**
+ * State vector of the cell with its density and pressure. Layers of conservative variables are
+ * passed in place of p_u, p_v and p_p, so only pressure is derived from them.
+ */
+template <euler_2d_variables variables, class float_type>
+CPU_GPU void euler_2d_load_state (
+    unsigned int i,
+    float_type gamma,
+    const float_type *p_rho,
+    const float_type *p_u,
+    const float_type *p_v,
+    const float_type *p_p,
+    float_type *q,
+    float_type &rho,
+    float_type &p)
+{
+  if constexpr (variables == euler_2d_variables::primitive)
+  {
+    fill_state_vector (i, gamma, p_rho, p_u, p_v, p_p, q);
+    rho = p_rho[i];
+    p = p_p[i];
+  }
+  else
+  {
+    q[0] = p_rho[i];
+    q[1] = p_u[i];
+    q[2] = p_v[i];
+    q[3] = p_p[i];
+    rho = q[0];
+    p = calculate_p_of_state_vector (gamma, q);
+  }
+}
+
+/// Velocity and pressure of the cell from its conserved variables rho, rho * u, rho * v and rho * E
+template <class float_type>
+CPU_GPU void euler_2d_calculate_primitive_variables (
+    unsigned int i,
+    float_type gamma,
+    const float_type *p_rho,
+    const float_type *p_rho_u,
+    const float_type *p_rho_v,
+    const float_type *p_rho_e,
+    float_type &u,
+    float_type &v,
+    float_type &p)
+{
+  const float_type q[4] = { p_rho[i], p_rho_u[i], p_rho_v[i], p_rho_e[i] };
+
+  u = q[1] / q[0];
+  v = q[2] / q[0];
+  p = calculate_p_of_state_vector (gamma, q);
+}
+
+/// Writes state vector q of the cell, see euler_2d_load_state
+template <euler_2d_variables variables, class float_type>
+CPU_GPU void euler_2d_store_state (
+    unsigned int i,
+    float_type gamma,
+    const float_type *q,
+    float_type *p_rho,
+    float_type *p_u,
+    float_type *p_v,
+    float_type *p_p)
+{
+  if constexpr (variables == euler_2d_variables::primitive)
+  {
+    const float_type rho = q[0];
+    const float_type u   = q[1] / rho;
+    const float_type v   = q[2] / rho;
+    const float_type E   = q[3] / rho;
+
+    p_rho[i] = rho;
+    p_u[i] = u;
+    p_v[i] = v;
+    p_p[i] = calculate_p (gamma, E, u, v, rho);
+  }
+  else
+  {
+    p_rho[i] = q[0];
+    p_u[i] = q[1];
+    p_v[i] = q[2];
+    p_p[i] = q[3];
+  }
+}
+
+/**
+ * Maximum of |u ± a| and |v ± a| of the cell, which limits the time step. Conservative variables
+ * are converted with a single division.
+ */
+template <euler_2d_variables variables, class float_type>
+CPU_GPU float_type euler_2d_calculate_max_wave_speed (
+    unsigned int i,
+    float_type gamma,
+    const float_type *p_rho,
+    const float_type *p_u,
+    const float_type *p_v,
+    const float_type *p_p)
+{
+  const float_type rho = p_rho[i];
+  float_type u, v, a;
+
+  if constexpr (variables == euler_2d_variables::primitive)
+  {
+    u = p_u[i];
+    v = p_v[i];
+    a = speed_of_sound_in_gas (gamma, p_p[i], rho);
+  }
+  else
+  {
+    const float_type rho_inv = float_type (1.0) / rho;
+    u = p_u[i] * rho_inv;
+    v = p_v[i] * rho_inv;
+
+    const float_type p = (gamma - 1.0f) * (p_p[i] - (p_u[i] * u + p_v[i] * v) / 2.0f);
+    a = std::sqrt (gamma * p * rho_inv);
+  }
+
+  return std::max (std::max (std::fabs (u + a), std::fabs (u - a)), std::max (std::fabs (v + a), std::fabs (v - a)));
+}
+
+/**
+ * Rusanov flux through the edge of the cell with state q_c to its neighbour with state q_n
+ * per unit of edge area. Normal points out of the cell, flux is in global coordinate system.
+ */
 template <class float_type>
+CPU_GPU void euler_2d_calculate_edge_flux (
+    float_type gamma,
+    float_type normal_x,
+    float_type normal_y,
+    const float_type *q_c,
+    const float_type *q_n,
+    float_type p_c, float_type p_n,
+    float_type rho_c, float_type rho_n,
+    float_type *f_sigma)
+{
+  float_type Q_c[4];
+  float_type Q_n[4];
+
+  float_type F_c[4];
+  float_type F_n[4];
+
+  float_type F_sigma[4];  /// Edge flux in local coordinate system
+
+  rotate_vector_to_edge_coordinates (normal_x, normal_y, q_c, Q_c);
+  rotate_vector_to_edge_coordinates (normal_x, normal_y, q_n, Q_n);
+
+  const float_type U_c = Q_c[1] / Q_c[0];
+  const float_type U_n = Q_n[1] / Q_n[0];
+
+  fill_flux_vector (Q_c, U_c, p_c, F_c);
+  fill_flux_vector (Q_n, U_n, p_n, F_n);
+
+  rusanov_scheme (gamma, p_c, p_n, rho_c, rho_n, U_c, U_n, F_c, F_n, Q_n, Q_c, F_sigma);
+  rotate_vector_from_edge_coordinates (normal_x, normal_y, F_sigma, f_sigma);
+}
+
+/// Sides without neighbours (boundary_type::none) are open: zero-gradient outflow through the edge
+template <class topology_type>
+CPU_GPU unsigned int euler_2d_get_neighbor_id (unsigned int cell_id, unsigned int edge_id, const topology_type &topology)
+{
+  const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, edge_id);
+
+  if constexpr (topology_type::has_boundary_neighbors)
+    if (!does_neighbor_exist (neighbor_id))
+      return cell_id;
+
+  return neighbor_id;
+}
+
+/**
+ * Flux from the cell to its neighbour through the edge of the cell with the normal, per unit
+ * of edge area in global coordinate system
+ */
+template <euler_2d_variables variables = euler_2d_variables::primitive, class float_type>
+CPU_GPU void euler_2d_calculate_face_flux (
+    unsigned int cell_id,
+    unsigned int neighbor_id,
+
+    float_type gamma,
+    float_type normal_x,
+    float_type normal_y,
+
+    const float_type *p_rho,
+    const float_type *p_u,
+    const float_type *p_v,
+    const float_type *p_p,
+
+    float_type *f_sigma)
+{
+  float_type q_c[4], rho_c, pressure_c;
+  float_type q_n[4], rho_n, pressure_n;
+
+  euler_2d_load_state<variables> (cell_id, gamma, p_rho, p_u, p_v, p_p, q_c, rho_c, pressure_c);
+  euler_2d_load_state<variables> (neighbor_id, gamma, p_rho, p_u, p_v, p_p, q_n, rho_n, pressure_n);
+
+  euler_2d_calculate_edge_flux (
+      gamma, normal_x, normal_y,
+      q_c, q_n,
+      pressure_c, pressure_n,
+      rho_c, rho_n,
+      f_sigma);
+}
+
+/**
+ * Writes values of the next time step of the cell with state vector q_c
+ * @param flux Sum of edges fluxes multiplied by edges areas
+ */
+template <euler_2d_variables variables = euler_2d_variables::primitive, class float_type>
+CPU_GPU void euler_2d_update_cell_values (
+    unsigned int cell_id,
+
+    float_type dt,
+    float_type gamma,
+    float cell_volume,
+
+    const float_type *q_c,
+    const float_type *flux,
+
+    float_type *p_rho_next,
+    float_type *p_u_next,
+    float_type *p_v_next,
+    float_type *p_p_next)
+{
+  float_type new_q[4];
+  for (int c = 0; c < 4; c++)
+    new_q[c] = q_c[c] - (dt / cell_volume) * (flux[c]);
+
+  euler_2d_store_state<variables> (cell_id, gamma, new_q, p_rho_next, p_u_next, p_v_next, p_p_next);
+}
+
+template <euler_2d_variables variables = euler_2d_variables::primitive, class float_type, class topology_type>
 CPU_GPU void euler_2d_calculate_next_cell_values (
     unsigned int cell_id,
 
     float_type dt,
     float_type gamma,
 
-    const grid_topology &topology,
+    const topology_type &topology,
     const grid_geometry &geometry,
 
     const float_type *p_rho,
@@ -188,62 +436,29 @@ CPU_GPU void euler_2d_calculate_next_cell_values (
     const float_type *p_p,
     float_type *p_p_next)
 {
-  float_type q_c[4];
-  float_type q_n[4];
-
-  float_type Q_c[4];
-  float_type Q_n[4];
-
-  float_type F_c[4];
-  float_type F_n[4];
-
-  float_type F_sigma[4];  /// Edge flux in local coordinate system
+  float_type q_c[4], rho_c, pressure_c;
   float_type f_sigma[4];  /// Edge flux in global coordinate system
 
-  fill_state_vector (cell_id, gamma, p_rho, p_u, p_v, p_p, q_c);
+  euler_2d_load_state<variables> (cell_id, gamma, p_rho, p_u, p_v, p_p, q_c, rho_c, pressure_c);
 
   float_type flux[4] = {0.0, 0.0, 0.0, 0.0};
 
   /// Edge flux
   for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
   {
-    const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, edge_id);
-    fill_state_vector (neighbor_id, gamma, p_rho, p_u, p_v, p_p, q_n);
-    const float_type normal_x = geometry.get_normal_x (cell_id, edge_id);
-    const float_type normal_y = geometry.get_normal_y (cell_id, edge_id);
-    rotate_vector_to_edge_coordinates (normal_x, normal_y, q_c, Q_c);
-    rotate_vector_to_edge_coordinates (normal_x, normal_y, q_n, Q_n);
-    fill_flux_vector (Q_c, F_c, gamma);
-    fill_flux_vector (Q_n, F_n, gamma);
-
-    const float_type U_c = Q_c[1] / Q_c[0];
-    const float_type U_n = Q_n[1] / Q_n[0];
-
-    rusanov_scheme (
-        gamma,
-        p_p[cell_id], p_p[neighbor_id],
-        p_rho[cell_id], p_rho[neighbor_id],
-        U_c, U_n, F_c, F_n, Q_n, Q_c, F_sigma);
-
-    rotate_vector_from_edge_coordinates (normal_x, normal_y, F_sigma, f_sigma);
+    euler_2d_calculate_face_flux<variables> (
+        cell_id, euler_2d_get_neighbor_id (cell_id, edge_id, topology), gamma,
+        static_cast<float_type> (geometry.get_normal_x (cell_id, edge_id)),
+        static_cast<float_type> (geometry.get_normal_y (cell_id, edge_id)),
+        p_rho, p_u, p_v, p_p, f_sigma);
 
     for (int c = 0; c < 4; c++)
       flux[c] += geometry.get_edge_area (cell_id, edge_id) * f_sigma[c];
   }
 
-  float_type new_q[4];
-  for (int c = 0; c < 4; c++)
-    new_q[c] = q_c[c] - (dt / geometry.get_cell_volume (cell_id)) * (flux[c]);
-
-  const float_type rho = new_q[0];
-  const float_type u   = new_q[1] / rho;
-  const float_type v   = new_q[2] / rho;
-  const float_type E   = new_q[3] / rho;
-
-  p_rho_next[cell_id] = rho;
-  p_u_next[cell_id] = u;
-  p_v_next[cell_id] = v;
-  p_p_next[cell_id] = calculate_p (gamma, E, u, v, rho);
+  euler_2d_update_cell_values<variables> (
+      cell_id, dt, gamma, geometry.get_cell_volume (cell_id),
+      q_c, flux, p_rho_next, p_u_next, p_v_next, p_p_next);
 }
 
 template <class float_type>
@@ -8,10 +8,10 @@
 #include "core/common/common_defs.h"
 #include "core/common/curl.h"
 
-template <class float_type>
+template <class float_type, class topology_type>
 CPU_GPU void fdtd_2d_update_h (
     unsigned int cell_id,
-    const grid_topology &topology,
+    const topology_type &topology,
     const grid_geometry &geometry,
 
     const float_type * __restrict__ ez,
@@ -27,12 +27,12 @@ CPU_GPU void fdtd_2d_update_h (
   hy[cell_id] -= mh[cell_id] * cey;
 }
 
-template <class float_type>
+template <class float_type, class topology_type>
 CPU_GPU void fdtd_2d_update_e (
     unsigned int cell_id,
     const float_type t,
     const float_type C0_p_dt,
-    const grid_topology &topology,
+    const topology_type &topology,
     const grid_geometry &geometry,
 
     const float_type * __restrict__ er,
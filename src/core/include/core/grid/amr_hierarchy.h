@@ -0,0 +1,83 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_AMR_HIERARCHY_H
+#define ANYSIM_AMR_HIERARCHY_H
+
+#include <limits>
+#include <vector>
+
+/**
+ * Quadtree of fixed-size patches over a periodic structured domain. Level 0 is a regular array of
+ * base patches and every refinement splits a leaf into four children of the next level, so a patch
+ * of level l at position (x, y) covers positions [2x, 2x + 1] x [2y, 2y + 1] of level l + 1. Only
+ * leaves hold solution. Leaves sharing a side differ by at most one level (2:1 balance), which
+ * keeps ghost cells and flux correction local to one coarse-fine interface.
+ */
+class amr_hierarchy
+{
+public:
+  static constexpr unsigned int no_patch = std::numeric_limits<unsigned int>::max ();
+
+  struct patch
+  {
+    unsigned int level;
+    unsigned int x;
+    unsigned int y;
+    unsigned int parent;
+
+    /// Children are consecutive ids in order (0, 0), (1, 0), (0, 1), (1, 1), no_patch for leaves
+    unsigned int first_child;
+
+    bool is_leaf () const { return first_child == no_patch; }
+  };
+
+  void initialize (unsigned int base_nx_arg, unsigned int base_ny_arg, unsigned int max_level_arg);
+
+  /**
+   * Splits the leaf into four children. Coarser leaves next to the patch are refined first to keep
+   * 2:1 balance, so all split patches are appended to refined, in order of splitting.
+   * @return true if the patch isn't a leaf or is on max level
+   */
+  bool refine (unsigned int patch_id, std::vector<unsigned int> &refined);
+
+  /// @return true if children of the patch are leaves and neighbours stay balanced without them
+  bool can_coarsen (unsigned int patch_id) const;
+
+  /// Drops children of the patch, their ids are reused by later refinements. Should be checked with can_coarsen.
+  void coarsen (unsigned int patch_id);
+
+  /**
+   * Patch of the level at position (x, y), positions are periodic. If the position isn't refined
+   * up to the level, returns the leaf that covers it.
+   */
+  unsigned int find_patch (unsigned int level, int x, int y) const;
+
+  /// Leaves in depth-first order, so that neighbouring leaves are usually close in the list
+  const std::vector<unsigned int> &get_leaves () const { return leaves; }
+
+  const patch &get_patch (unsigned int patch_id) const { return patches[patch_id]; }
+  unsigned int get_patches_count () const { return patches.size (); }
+  unsigned int get_max_level () const { return max_level; }
+  unsigned int get_level_nx (unsigned int level) const { return base_nx << level; }
+  unsigned int get_level_ny (unsigned int level) const { return base_ny << level; }
+
+  /// Finest level that has leaves
+  unsigned int get_finest_level () const;
+
+private:
+  unsigned int allocate_children (unsigned int parent_id);
+  void update_leaves ();
+
+private:
+  unsigned int base_nx = 0;
+  unsigned int base_ny = 0;
+  unsigned int max_level = 0;
+
+  std::vector<patch> patches;
+  std::vector<unsigned int> free_children_blocks;
+  std::vector<unsigned int> leaves;
+};
+
+#endif  // ANYSIM_AMR_HIERARCHY_H
@@ -98,6 +98,7 @@ public:
   [[nodiscard]] geometry_element_type get_element_type () const { return elements_type; }
 
   void append_pixel (const point &left_bottom_corner, const sizes_set &sizes);
+  void append_quad (const point &a, const point &b, const point &c, const point &d);
   void append_vertex (const point &v);
 
 private:
@@ -7,6 +7,9 @@
 
 #include <cmath>
 #include <string>
+#include <map>
+#include <mutex>
+#include <memory>
 #include <vector>
 #include <algorithm>
 
@@ -50,6 +53,21 @@ inline CPU_GPU unsigned int boundary_to_id (boundary_type boundary)
   return 0;
 }
 
+/// @return true if name isn't one of periodic, mirror or none
+inline bool boundary_from_name (const std::string &name, boundary_type &boundary)
+{
+  if (name == "periodic")
+    boundary = boundary_type::periodic;
+  else if (name == "mirror")
+    boundary = boundary_type::mirror;
+  else if (name == "none")
+    boundary = boundary_type::none;
+  else
+    return true;
+
+  return false;
+}
+
 constexpr unsigned int unknown_neighbor_id = std::numeric_limits<unsigned int>::max () - 1;
 inline CPU_GPU bool does_neighbor_exist (unsigned int cell_id) { return cell_id != unknown_neighbor_id; }
 inline CPU_GPU bool is_edge_left (unsigned int edge_id) { return edge_id == side_to_id (side_type::left); }
@@ -57,16 +75,323 @@ inline CPU_GPU bool is_edge_bottom (unsigned int edge_id) { return edge_id == si
 inline CPU_GPU bool is_edge_right (unsigned int edge_id) { return edge_id == side_to_id (side_type::right); }
 inline CPU_GPU bool is_edge_top (unsigned int edge_id) { return edge_id == side_to_id (side_type::top); }
 
+enum class cells_layout
+{
+  row_major, tiled, morton
+};
+
+/**
+ * Order of cells of a structured grid in fields. Row major layout stores rows one after another,
+ * so vertical neighbours are nx cells away. Tiled layout stores tile_size x tile_size blocks one after
+ * another (row major inside of blocks and between them), so inside of a block vertical neighbours
+ * are at most tile_size cells away. Morton layout stores cells in Z-order, which keeps most of
+ * neighbours close on every level of cache. Grids that aren't multiples of tile size or powers of
+ * two are supported: cell ids are dense in [0, nx * ny) for every layout.
+ */
+class grid_cells_order
+{
+public:
+  static constexpr unsigned int default_tile_size = 32;
+
+  void initialize (unsigned int nx_arg, unsigned int ny_arg, cells_layout layout_arg, unsigned int tile_size_arg)
+  {
+    nx = nx_arg;
+    ny = ny_arg;
+    layout = layout_arg;
+    tile_size = tile_size_arg ? tile_size_arg : default_tile_size;
+
+    morton_size = 1;
+    while (morton_size < nx || morton_size < ny)
+      morton_size *= 2;
+
+    morton_cell_ids = nullptr;
+    morton_row_major_ids = nullptr;
+  }
+
+  /// Morton ids of grids that aren't power of two squares are ranks found by a walk over quadrants of every level
+  CPU_GPU bool needs_morton_permutation () const { return layout == cells_layout::morton && !is_full_morton_square (); }
+
+  /// cell_ids[y * nx + x] is the id of cell (x, y) and row_major_ids[cell_id] is y * nx + x
+  void fill_morton_permutation (unsigned int *cell_ids, unsigned int *row_major_ids) const
+  {
+    for (unsigned int y = 0; y < ny; y++)
+    {
+      for (unsigned int x = 0; x < nx; x++)
+      {
+        const unsigned int cell_id = get_morton_cell_id (x, y);
+        cell_ids[y * nx + x] = cell_id;
+        row_major_ids[cell_id] = y * nx + x;
+      }
+    }
+  }
+
+  /**
+   * Replaces the walk over quadrants with lookups in arrays of fill_morton_permutation. Arrays
+   * have to outlive the order and its copies. They are in host memory, so device code keeps
+   * walking quadrants.
+   */
+  void set_morton_permutation (const unsigned int *cell_ids, const unsigned int *row_major_ids)
+  {
+    morton_cell_ids = cell_ids;
+    morton_row_major_ids = row_major_ids;
+  }
+
+  CPU_GPU cells_layout get_layout () const { return layout; }
+  CPU_GPU unsigned int get_tile_size () const { return tile_size; }
+
+  CPU_GPU unsigned int get_cell_id (unsigned int x, unsigned int y) const
+  {
+    if (layout == cells_layout::tiled)
+      return get_tiled_cell_id (x, y);
+    else if (layout == cells_layout::morton)
+      return get_morton_cell_id (x, y);
+
+    return y * nx + x;
+  }
+
+  CPU_GPU void get_cell_coordinates (unsigned int cell_id, unsigned int &x, unsigned int &y) const
+  {
+    if (layout == cells_layout::tiled)
+      return get_tiled_cell_coordinates (cell_id, x, y);
+    else if (layout == cells_layout::morton)
+      return get_morton_cell_coordinates (cell_id, x, y);
+
+    x = cell_id % nx;
+    y = cell_id / nx;
+  }
+
+  CPU_GPU unsigned int get_cell_x (unsigned int cell_id) const
+  {
+    unsigned int x {}, y {};
+    get_cell_coordinates (cell_id, x, y);
+    return x;
+  }
+
+  CPU_GPU unsigned int get_cell_y (unsigned int cell_id) const
+  {
+    unsigned int x {}, y {};
+    get_cell_coordinates (cell_id, x, y);
+    return y;
+  }
+
+  /// Max cyclic distance between ids of neighbouring cells, including neighbours through periodic boundaries
+  CPU_GPU unsigned int get_neighbors_distance () const
+  {
+    if (layout == cells_layout::tiled)
+      return 2 * tile_size * nx < nx * ny ? 2 * tile_size * nx : nx * ny;
+    else if (layout == cells_layout::morton)
+      return nx * ny;
+
+    return nx;
+  }
+
+private:
+  CPU_GPU unsigned int get_tile_rows (unsigned int tile_y) const
+  {
+    const unsigned int rows_left = ny - tile_y * tile_size;
+    return rows_left < tile_size ? rows_left : tile_size;
+  }
+
+  CPU_GPU unsigned int get_tile_columns (unsigned int tile_x) const
+  {
+    const unsigned int columns_left = nx - tile_x * tile_size;
+    return columns_left < tile_size ? columns_left : tile_size;
+  }
+
+  CPU_GPU unsigned int get_tiled_cell_id (unsigned int x, unsigned int y) const
+  {
+    const unsigned int tile_x = x / tile_size;
+    const unsigned int tile_y = y / tile_size;
+
+    /// Every row of tiles except the last one has tile_size * nx cells
+    return tile_y * tile_size * nx
+         + tile_x * tile_size * get_tile_rows (tile_y)
+         + (y % tile_size) * get_tile_columns (tile_x)
+         + x % tile_size;
+  }
+
+  CPU_GPU void get_tiled_cell_coordinates (unsigned int cell_id, unsigned int &x, unsigned int &y) const
+  {
+    const unsigned int tile_y = cell_id / (tile_size * nx);
+    const unsigned int tiles_row_offset = cell_id - tile_y * tile_size * nx;
+    const unsigned int tile_rows = get_tile_rows (tile_y);
+    const unsigned int tile_x = tiles_row_offset / (tile_size * tile_rows);
+    const unsigned int tile_offset = tiles_row_offset - tile_x * tile_size * tile_rows;
+    const unsigned int tile_columns = get_tile_columns (tile_x);
+
+    x = tile_x * tile_size + tile_offset % tile_columns;
+    y = tile_y * tile_size + tile_offset / tile_columns;
+  }
+
+  CPU_GPU bool is_full_morton_square () const { return nx == morton_size && ny == morton_size; }
+
+  /// Inserts zero bit before each of the lower 16 bits
+  CPU_GPU static unsigned int spread_bits (unsigned int value)
+  {
+    value &= 0x0000ffff;
+    value = (value | (value << 8)) & 0x00ff00ff;
+    value = (value | (value << 4)) & 0x0f0f0f0f;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+  }
+
+  CPU_GPU static unsigned int compact_bits (unsigned int value)
+  {
+    value &= 0x55555555;
+    value = (value | (value >> 1)) & 0x33333333;
+    value = (value | (value >> 2)) & 0x0f0f0f0f;
+    value = (value | (value >> 4)) & 0x00ff00ff;
+    value = (value | (value >> 8)) & 0x0000ffff;
+    return value;
+  }
+
+  /// Count of grid cells in the block of size x size cells with the left bottom cell at (block_x, block_y)
+  CPU_GPU unsigned int get_cells_in_block (unsigned int block_x, unsigned int block_y, unsigned int size) const
+  {
+    const unsigned int columns = block_x >= nx ? 0 : (nx - block_x < size ? nx - block_x : size);
+    const unsigned int rows = block_y >= ny ? 0 : (ny - block_y < size ? ny - block_y : size);
+    return columns * rows;
+  }
+
+  /**
+   * Rank of the cell Z-order code among codes of grid cells. Quadrants are visited in Z-order
+   * (left bottom, right bottom, left top, right top) and cells of skipped quadrants are counted,
+   * so cells outside of the grid don't take ids.
+   */
+  CPU_GPU unsigned int get_morton_cell_id (unsigned int x, unsigned int y) const
+  {
+    if (is_full_morton_square ())
+      return spread_bits (x) | (spread_bits (y) << 1);
+
+#ifndef __CUDA_ARCH__
+    if (morton_cell_ids)
+      return morton_cell_ids[y * nx + x];
+#endif
+
+    unsigned int cell_id = 0;
+    unsigned int block_x = 0;
+    unsigned int block_y = 0;
+
+    for (unsigned int size = morton_size / 2; size > 0; size /= 2)
+    {
+      const unsigned int quadrant_x = x >= block_x + size ? 1 : 0;
+      const unsigned int quadrant_y = y >= block_y + size ? 1 : 0;
+      const unsigned int quadrant = quadrant_y * 2 + quadrant_x;
+
+      for (unsigned int skipped = 0; skipped < quadrant; skipped++)
+        cell_id += get_cells_in_block (block_x + (skipped % 2) * size, block_y + (skipped / 2) * size, size);
+
+      block_x += quadrant_x * size;
+      block_y += quadrant_y * size;
+    }
+
+    return cell_id;
+  }
+
+  CPU_GPU void get_morton_cell_coordinates (unsigned int cell_id, unsigned int &x, unsigned int &y) const
+  {
+    if (is_full_morton_square ())
+    {
+      x = compact_bits (cell_id);
+      y = compact_bits (cell_id >> 1);
+      return;
+    }
+
+#ifndef __CUDA_ARCH__
+    if (morton_row_major_ids)
+    {
+      const unsigned int row_major_id = morton_row_major_ids[cell_id];
+      x = row_major_id % nx;
+      y = row_major_id / nx;
+      return;
+    }
+#endif
+
+    x = 0;
+    y = 0;
+
+    for (unsigned int size = morton_size / 2; size > 0; size /= 2)
+    {
+      for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+      {
+        const unsigned int block_x = x + (quadrant % 2) * size;
+        const unsigned int block_y = y + (quadrant / 2) * size;
+        const unsigned int block_cells = get_cells_in_block (block_x, block_y, size);
+
+        if (cell_id < block_cells)
+        {
+          x = block_x;
+          y = block_y;
+          break;
+        }
+
+        cell_id -= block_cells;
+      }
+    }
+  }
+
+private:
+  unsigned int nx, ny;
+  cells_layout layout;
+  unsigned int tile_size;
+  unsigned int morton_size;
+
+  /// See set_morton_permutation
+  const unsigned int *morton_cell_ids;
+  const unsigned int *morton_row_major_ids;
+};
+
+/**
+ * Topology of cells that have all four neighbours inside of the grid. Neighbours are at fixed
+ * offsets from the cell, so kernels instantiated with it don't check boundaries and don't
+ * compute cell coordinates. It's valid only for cells passed with it by
+ * grid_topology::for_each_cells_strip.
+ */
+class grid_interior_topology
+{
+public:
+  /// Neighbours are other cells of the grid, see grid_topology::has_boundary_neighbors
+  static constexpr bool has_boundary_neighbors = false;
+
+  void initialize_for_structured_uniform_grid (unsigned int nx_arg, unsigned int n_cells_arg)
+  {
+    nx = nx_arg;
+    n_cells = n_cells_arg;
+  }
+
+  CPU_GPU unsigned int get_cells_count () const { return n_cells; }
+  CPU_GPU unsigned int get_edges_count (unsigned int /* cell_id */) const { return 4; }
+
+  CPU_GPU unsigned int get_neighbor_id (unsigned int cell_id, unsigned int edge_id) const
+  {
+    /// Indexed by edge id. Unsigned overflow turns left and bottom offsets into subtraction.
+    const unsigned int offsets[4] = { 0u - 1u, 0u - nx, 1u, nx };
+    return cell_id + offsets[edge_id];
+  }
+
+private:
+  unsigned int n_cells;
+  unsigned int nx;
+};
+
 class grid_topology
 {
 public:
+  /**
+   * Boundary cells may be their own neighbours (mirror) or lack neighbours (none), so kernels
+   * instantiated with the topology check neighbours. Topologies without such cells skip the checks.
+   */
+  static constexpr bool has_boundary_neighbors = true;
+
   void initialize_for_structured_uniform_grid (
     unsigned int nx_arg,
     unsigned int ny_arg,
     unsigned int bc_left,
     unsigned int bc_bottom,
     unsigned int bc_right,
-    unsigned int bc_top)
+    unsigned int bc_top,
+    const grid_cells_order &order_arg)
   {
     boundary_conditions[side_to_id (side_type::left)] = bc_left;
     boundary_conditions[side_to_id (side_type::bottom)] = bc_bottom;
@@ -76,100 +401,331 @@ public:
     nx = nx_arg;
     ny = ny_arg;
     n_cells = nx * ny;
+    order = order_arg;
 
     complex_topology = nullptr;
     complex_topology_mapping = nullptr;
+    complex_bandwidth = 0;
+  }
+
+  /**
+   * Topology of unstructured mesh in CSR arrays: neighbours of the cell are
+   * neighbors[offsets[cell_id]] ... neighbors[offsets[cell_id + 1] - 1]. Arrays aren't copied.
+   * @param bandwidth Max difference between ids of neighbouring cells
+   */
+  void initialize_for_unstructured_mesh (
+    unsigned int n_cells_arg,
+    const unsigned int *offsets,
+    const unsigned int *neighbors,
+    unsigned int bandwidth)
+  {
+    for (auto &bc: boundary_conditions)
+      bc = boundary_to_id (boundary_type::none);
+
+    nx = n_cells_arg;
+    ny = 1;
+    n_cells = n_cells_arg;
+    order.initialize (nx, ny, cells_layout::row_major, 0);
+
+    complex_topology = neighbors;
+    complex_topology_mapping = offsets;
+    complex_bandwidth = bandwidth;
+  }
+
+  CPU_GPU bool is_complex () const
+  {
+    return complex_topology && complex_topology_mapping;
   }
 
   CPU_GPU unsigned int get_cells_count () const { return n_cells; }
-  CPU_GPU unsigned int get_cell_x (unsigned int cell_id) const { return cell_id % nx; }
-  CPU_GPU unsigned int get_cell_y (unsigned int cell_id) const { return cell_id / nx; }
-  CPU_GPU unsigned int get_cell_id (unsigned int x, unsigned int y) const { return y * nx + x; }
+  CPU_GPU unsigned int get_nx () const { return nx; }
+  CPU_GPU unsigned int get_ny () const { return ny; }
+  CPU_GPU unsigned int get_cell_x (unsigned int cell_id) const { return order.get_cell_x (cell_id); }
+  CPU_GPU unsigned int get_cell_y (unsigned int cell_id) const { return order.get_cell_y (cell_id); }
+  CPU_GPU unsigned int get_cell_id (unsigned int x, unsigned int y) const { return order.get_cell_id (x, y); }
+  CPU_GPU const grid_cells_order &get_cells_order () const { return order; }
 
-  CPU_GPU unsigned int get_edges_count (unsigned int /* cell_id */) const { return 4; }
+  CPU_GPU unsigned int get_edges_count (unsigned int cell_id) const
+  {
+    if (is_complex ())
+      return complex_topology_mapping[cell_id + 1] - complex_topology_mapping[cell_id];
+    return 4;
+  }
+
+  /// Max cyclic distance between cell id and ids of its neighbours (periodic boundaries wrap around)
+  CPU_GPU unsigned int get_halo_size () const
+  {
+    return is_complex () ? complex_bandwidth : order.get_neighbors_distance ();
+  }
 
   CPU_GPU unsigned int get_neighbor_id (unsigned int cell_id, unsigned int edge_id) const
   {
-    const unsigned int x = get_cell_x (cell_id);
-    const unsigned int y = get_cell_y (cell_id);
+    if (is_complex ())
+      return complex_topology[complex_topology_mapping[cell_id] + edge_id];
+
+    unsigned int x {}, y {};
+    order.get_cell_coordinates (cell_id, x, y);
 
     if (is_edge_left (edge_id))
-      return is_cell_on_left_boundary (x) ? get_left_boundary_neighbor (x, y) : get_cell_id (x - 1, y);
+      return is_cell_on_left_boundary (x) ? get_boundary_neighbor<side_type::left> (x, y) : get_cell_id (x - 1, y);
     else if (is_edge_bottom (edge_id))
-      return is_cell_on_bottom_boundary (y) ? get_bottom_boundary_neighbor (x, y) : get_cell_id (x, y - 1);
+      return is_cell_on_bottom_boundary (y) ? get_boundary_neighbor<side_type::bottom> (x, y) : get_cell_id (x, y - 1);
     else if (is_edge_right (edge_id))
-      return is_cell_on_right_boundary (x) ? get_right_boundary_neighbor (x, y) : get_cell_id (x + 1, y);
+      return is_cell_on_right_boundary (x) ? get_boundary_neighbor<side_type::right> (x, y) : get_cell_id (x + 1, y);
     else if (is_edge_top (edge_id))
-      return is_cell_on_top_boundary (y) ? get_top_boundary_neighbor (x, y) : get_cell_id (x, y + 1);
+      return is_cell_on_top_boundary (y) ? get_boundary_neighbor<side_type::top> (x, y) : get_cell_id (x, y + 1);
 
     return unknown_neighbor_id;
   }
 
-private:
-  CPU_GPU bool is_complex () const
+  /// Neighbour of structured grid cell with boundary conditions known at compile time, see grid_boundary_topology
+  template <boundary_type left_bc, boundary_type bottom_bc, boundary_type right_bc, boundary_type top_bc>
+  CPU_GPU unsigned int get_structured_neighbor_id (unsigned int cell_id, unsigned int edge_id) const
   {
-    return complex_topology && complex_topology_mapping;
+    unsigned int x {}, y {};
+    order.get_cell_coordinates (cell_id, x, y);
+
+    if (is_edge_left (edge_id))
+      return is_cell_on_left_boundary (x) ? get_boundary_neighbor<side_type::left, left_bc> (x, y) : get_cell_id (x - 1, y);
+    else if (is_edge_bottom (edge_id))
+      return is_cell_on_bottom_boundary (y) ? get_boundary_neighbor<side_type::bottom, bottom_bc> (x, y) : get_cell_id (x, y - 1);
+    else if (is_edge_right (edge_id))
+      return is_cell_on_right_boundary (x) ? get_boundary_neighbor<side_type::right, right_bc> (x, y) : get_cell_id (x + 1, y);
+    else if (is_edge_top (edge_id))
+      return is_cell_on_top_boundary (y) ? get_boundary_neighbor<side_type::top, top_bc> (x, y) : get_cell_id (x, y + 1);
+
+    return unknown_neighbor_id;
+  }
+
+  CPU_GPU unsigned int get_boundary_condition (side_type side) const { return boundary_conditions[side_to_id (side)]; }
+
+  CPU_GPU grid_interior_topology get_interior_topology () const
+  {
+    grid_interior_topology interior;
+    interior.initialize_for_structured_uniform_grid (nx, n_cells);
+    return interior;
+  }
+
+  /**
+   * Splits cells [begin, end) into strips of consecutive cells. Strips of interior cells are passed
+   * as action (strip_begin, strip_end, interior_topology) and strips of boundary cells as
+   * action (strip_begin, strip_end, *this), so per-cell kernels called from a generic action are
+   * compiled into a boundary-free loop for the interior and a general one for the boundary strips.
+   * Strips are visited in cells order. Interior neighbours are at fixed offsets only in row major
+   * layout, so other layouts and unstructured meshes get one general strip.
+   */
+  template <class action_type>
+  void for_each_cells_strip (unsigned int begin, unsigned int end, const action_type &action) const
+  {
+    for_each_cells_strip (begin, end, *this, action);
+  }
+
+  /// Same as above, but boundary strips are passed with boundary_topology, e.g. grid_boundary_topology
+  template <class boundary_topology_type, class action_type>
+  void for_each_cells_strip (
+    unsigned int begin,
+    unsigned int end,
+    const boundary_topology_type &boundary_topology,
+    const action_type &action) const
+  {
+    if (begin >= end)
+      return;
+
+    if (is_complex () || order.get_layout () != cells_layout::row_major)
+    {
+      action (begin, end, boundary_topology);
+      return;
+    }
+
+    const grid_interior_topology interior = get_interior_topology ();
+
+    for (unsigned int row_begin = get_cell_id (0, get_cell_y (begin)); row_begin < end; row_begin += nx)
+    {
+      const unsigned int y = get_cell_y (row_begin);
+      const unsigned int strip_begin = std::max (begin, row_begin);
+      const unsigned int strip_end = std::min (end, row_begin + nx);
+
+      if (is_cell_on_bottom_boundary (y) || is_cell_on_top_boundary (y) || nx < 3)
+      {
+        action (strip_begin, strip_end, boundary_topology);
+        continue;
+      }
+
+      const unsigned int interior_begin = std::max (strip_begin, row_begin + 1);
+      const unsigned int interior_end = std::min (strip_end, row_begin + nx - 1);
+
+      if (strip_begin < interior_begin)
+        action (strip_begin, interior_begin, boundary_topology);
+      if (interior_begin < interior_end)
+        action (interior_begin, interior_end, interior);
+      if (std::max (interior_end, strip_begin) < strip_end)
+        action (std::max (interior_end, strip_begin), strip_end, boundary_topology);
+    }
   }
 
+private:
   CPU_GPU bool is_cell_on_left_boundary (unsigned int x) const { return x == 0; }
   CPU_GPU bool is_cell_on_right_boundary (unsigned int x) const { return x == nx - 1; }
   CPU_GPU bool is_cell_on_bottom_boundary (unsigned int y) const { return y == 0; }
   CPU_GPU bool is_cell_on_top_boundary (unsigned int y) const { return y == ny - 1; }
 
-  CPU_GPU unsigned int get_left_boundary_neighbor (unsigned int x, unsigned int y) const
+  template <side_type side, boundary_type bc>
+  CPU_GPU unsigned int get_boundary_neighbor (unsigned int x, unsigned int y) const
   {
-    const auto bc = boundary_conditions[side_to_id (side_type::left)];
-    if (bc == boundary_to_id (boundary_type::mirror))
+    if constexpr (bc == boundary_type::mirror)
       return get_cell_id (x, y);
-    else if (bc == boundary_to_id (boundary_type::periodic))
+    else if constexpr (bc == boundary_type::periodic && side == side_type::left)
       return get_cell_id (nx - 1, y);
+    else if constexpr (bc == boundary_type::periodic && side == side_type::bottom)
+      return get_cell_id (x, ny - 1);
+    else if constexpr (bc == boundary_type::periodic && side == side_type::right)
+      return get_cell_id (0, y);
+    else if constexpr (bc == boundary_type::periodic && side == side_type::top)
+      return get_cell_id (x, 0);
 
     /// none
     return unknown_neighbor_id;
   }
 
-  CPU_GPU unsigned int get_bottom_boundary_neighbor (unsigned int x, unsigned int y) const
+  template <side_type side>
+  CPU_GPU unsigned int get_boundary_neighbor (unsigned int x, unsigned int y) const
   {
-    const auto bc = boundary_conditions[side_to_id (side_type::bottom)];
+    const auto bc = boundary_conditions[side_to_id (side)];
     if (bc == boundary_to_id (boundary_type::mirror))
-      return get_cell_id (x, y);
+      return get_boundary_neighbor<side, boundary_type::mirror> (x, y);
     else if (bc == boundary_to_id (boundary_type::periodic))
-      return get_cell_id (x, ny - 1);
+      return get_boundary_neighbor<side, boundary_type::periodic> (x, y);
 
-    /// none
-    return unknown_neighbor_id;
+    return get_boundary_neighbor<side, boundary_type::none> (x, y);
   }
 
-  CPU_GPU unsigned int get_right_boundary_neighbor (unsigned int x, unsigned int y) const
+private:
+  unsigned int n_cells;
+  unsigned int nx, ny;
+  grid_cells_order order;
+  const unsigned int *complex_topology;
+  const unsigned int *complex_topology_mapping;
+  unsigned int complex_bandwidth;
+  unsigned int boundary_conditions[4];
+};
+
+/**
+ * Topology of structured grid with boundary conditions fixed at compile time. Kernels instantiated
+ * with it don't read boundary conditions, so every combination of conditions gets its own kernel
+ * without branches on them. It's created by dispatch_boundary_conditions for a topology that has
+ * the same conditions.
+ */
+template <boundary_type left_bc, boundary_type bottom_bc, boundary_type right_bc, boundary_type top_bc>
+class grid_boundary_topology
+{
+public:
+  static constexpr bool has_boundary_neighbors =
+       left_bc != boundary_type::periodic || bottom_bc != boundary_type::periodic
+    || right_bc != boundary_type::periodic || top_bc != boundary_type::periodic;
+
+  explicit grid_boundary_topology (const grid_topology &topology_arg) : topology (topology_arg) { }
+
+  CPU_GPU unsigned int get_cells_count () const { return topology.get_cells_count (); }
+  CPU_GPU unsigned int get_edges_count (unsigned int /* cell_id */) const { return 4; }
+  CPU_GPU unsigned int get_halo_size () const { return topology.get_halo_size (); }
+
+  CPU_GPU unsigned int get_neighbor_id (unsigned int cell_id, unsigned int edge_id) const
   {
-    const auto bc = boundary_conditions[side_to_id (side_type::right)];
-    if (bc == boundary_to_id (boundary_type::mirror))
-      return get_cell_id (x, y);
-    else if (bc == boundary_to_id (boundary_type::periodic))
-      return get_cell_id (0, y);
+    return topology.template get_structured_neighbor_id<left_bc, bottom_bc, right_bc, top_bc> (cell_id, edge_id);
+  }
 
-    /// none
-    return unknown_neighbor_id;
+  template <class action_type>
+  void for_each_cells_strip (unsigned int begin, unsigned int end, const action_type &action) const
+  {
+    topology.for_each_cells_strip (begin, end, *this, action);
   }
 
-  CPU_GPU unsigned int get_top_boundary_neighbor (unsigned int x, unsigned int y) const
+private:
+  grid_topology topology;
+};
+
+template <boundary_type... known_bcs, class action_type>
+void dispatch_boundary_conditions_of_sides (const grid_topology &topology, const action_type &action)
+{
+  if constexpr (sizeof... (known_bcs) == 4)
+  {
+    action (grid_boundary_topology<known_bcs...> (topology));
+  }
+  else
   {
-    const auto bc = boundary_conditions[side_to_id (side_type::top)];
+    const auto bc = topology.get_boundary_condition (static_cast<side_type> (sizeof... (known_bcs)));
+
     if (bc == boundary_to_id (boundary_type::mirror))
-      return get_cell_id (x, y);
+      dispatch_boundary_conditions_of_sides<known_bcs..., boundary_type::mirror> (topology, action);
     else if (bc == boundary_to_id (boundary_type::periodic))
-      return get_cell_id (x, 0);
+      dispatch_boundary_conditions_of_sides<known_bcs..., boundary_type::periodic> (topology, action);
+    else
+      dispatch_boundary_conditions_of_sides<known_bcs..., boundary_type::none> (topology, action);
+  }
+}
 
-    /// none
-    return unknown_neighbor_id;
+/**
+ * Calls action (boundary_topology) with grid_boundary_topology that has conditions of the topology.
+ * Unstructured meshes don't have boundary conditions, so they are passed as is.
+ */
+template <class action_type>
+void dispatch_boundary_conditions (const grid_topology &topology, const action_type &action)
+{
+  if (topology.is_complex ())
+    action (topology);
+  else
+    dispatch_boundary_conditions_of_sides<> (topology, action);
+}
+
+/**
+ * Layout of a field allocated with halo_width layers of ghost cells around the grid. Rows are
+ * padded to nx + 2 * halo_width cells, so every real cell has its neighbours at fixed offsets and
+ * kernels read them unconditionally once the halo is filled (see fill_halo). Cell ids of this
+ * layout are padded ids.
+ */
+class grid_halo_layout
+{
+public:
+  void initialize_for_structured_uniform_grid (unsigned int nx_arg, unsigned int ny_arg, unsigned int halo_width_arg)
+  {
+    nx = nx_arg;
+    ny = ny_arg;
+    halo_width = halo_width_arg;
+  }
+
+  CPU_GPU unsigned int get_nx () const { return nx; }
+  CPU_GPU unsigned int get_ny () const { return ny; }
+  CPU_GPU unsigned int get_halo_width () const { return halo_width; }
+  CPU_GPU unsigned int get_padded_nx () const { return nx + 2 * halo_width; }
+  CPU_GPU unsigned int get_padded_ny () const { return ny + 2 * halo_width; }
+  CPU_GPU unsigned int get_padded_cells_count () const { return get_padded_nx () * get_padded_ny (); }
+  CPU_GPU unsigned int get_cells_count () const { return nx * ny; }
+
+  /// Ghost cells have x in [-halo_width, 0) or [nx, nx + halo_width), and the same for y
+  CPU_GPU unsigned int get_cell_id (int x, int y) const
+  {
+    const int h = static_cast<int> (halo_width);
+    return static_cast<unsigned int> (y + h) * get_padded_nx () + static_cast<unsigned int> (x + h);
+  }
+
+  /// Padded id of the cell with row major id
+  CPU_GPU unsigned int get_padded_cell_id (unsigned int cell_id) const
+  {
+    return get_cell_id (static_cast<int> (cell_id % nx), static_cast<int> (cell_id / nx));
+  }
+
+  CPU_GPU unsigned int get_edges_count (unsigned int /* cell_id */) const { return 4; }
+
+  CPU_GPU unsigned int get_neighbor_id (unsigned int cell_id, unsigned int edge_id) const
+  {
+    const unsigned int padded_nx = get_padded_nx ();
+    const unsigned int offsets[4] = { 0u - 1u, 0u - padded_nx, 1u, padded_nx };
+    return cell_id + offsets[edge_id];
   }
 
 private:
-  unsigned int n_cells;
   unsigned int nx, ny;
-  unsigned int *complex_topology;
-  unsigned int *complex_topology_mapping;
-  unsigned int boundary_conditions[4];
+  unsigned int halo_width;
 };
 
 class grid_geometry
@@ -177,41 +733,141 @@ class grid_geometry
 public:
   void initialize_for_structured_uniform_grid (
     unsigned int nx_arg, unsigned int ny_arg,
-    float dx_arg, float dy_arg)
+    float dx_arg, float dy_arg,
+    const grid_cells_order &order_arg)
   {
     nx = nx_arg;
     ny = ny_arg;
     dx = dx_arg;
     dy = dy_arg;
+    order = order_arg;
+    min_spacing = std::min (dx, dy);
+
+    columns_widths = nullptr;
+    faces_offsets = nullptr;
+  }
+
+  /**
+   * Geometry of structured grid with per-column widths and per-row heights. Centers are
+   * precomputed, so kernels read 1D metric arrays instead of summing widths. Arrays aren't copied.
+   * @param min_spacing_arg Narrowest column or row, used for CFL
+   */
+  void initialize_for_structured_rectilinear_grid (
+    unsigned int nx_arg, unsigned int ny_arg,
+    const float *columns_widths_arg,
+    const float *columns_centers_arg,
+    const float *rows_heights_arg,
+    const float *rows_centers_arg,
+    float min_spacing_arg,
+    const grid_cells_order &order_arg)
+  {
+    initialize_for_structured_uniform_grid (nx_arg, ny_arg, columns_widths_arg[0], rows_heights_arg[0], order_arg);
+
+    columns_widths = columns_widths_arg;
+    columns_centers = columns_centers_arg;
+    rows_heights = rows_heights_arg;
+    rows_centers = rows_centers_arg;
+    min_spacing = min_spacing_arg;
+  }
+
+  /**
+   * Geometry of unstructured mesh. Faces of the cell are [faces_offsets[cell_id], faces_offsets[cell_id + 1])
+   * of faces arrays, as in grid_topology::initialize_for_unstructured_mesh. Arrays aren't copied.
+   * @param min_spacing_arg Shortest face of the mesh, used for CFL
+   */
+  void initialize_for_unstructured_mesh (
+    const unsigned int *faces_offsets_arg,
+    const float *faces_normals_x_arg,
+    const float *faces_normals_y_arg,
+    const float *faces_areas_arg,
+    const float *cells_volumes_arg,
+    const float *cells_centers_x_arg,
+    const float *cells_centers_y_arg,
+    float min_spacing_arg)
+  {
+    nx = ny = 0;
+    dx = dy = 0.0f;
+    order.initialize (nx, ny, cells_layout::row_major, 0);
+    min_spacing = min_spacing_arg;
+    columns_widths = nullptr;
+
+    faces_offsets = faces_offsets_arg;
+    faces_normals_x = faces_normals_x_arg;
+    faces_normals_y = faces_normals_y_arg;
+    faces_areas = faces_areas_arg;
+    cells_volumes = cells_volumes_arg;
+    cells_centers_x = cells_centers_x_arg;
+    cells_centers_y = cells_centers_y_arg;
+  }
+
+  CPU_GPU bool is_unstructured () const { return faces_offsets != nullptr; }
+  CPU_GPU bool is_rectilinear () const { return columns_widths != nullptr; }
+
+  /// Shortest cell side (face for unstructured meshes) of the whole grid
+  CPU_GPU float get_min_spacing () const { return min_spacing; }
+
+  CPU_GPU float get_cell_width (unsigned int cell_id) const
+  {
+    if (is_rectilinear ())
+      return columns_widths[order.get_cell_x (cell_id)];
+    return dx;
+  }
+
+  CPU_GPU float get_cell_height (unsigned int cell_id) const
+  {
+    if (is_rectilinear ())
+      return rows_heights[order.get_cell_y (cell_id)];
+    return dy;
   }
 
-  CPU_GPU float get_cell_volume (unsigned int /* cell_id */) const { return dx * dy; }
+  CPU_GPU float get_cell_volume (unsigned int cell_id) const
+  {
+    if (is_unstructured ())
+      return cells_volumes[cell_id];
+    return get_cell_width (cell_id) * get_cell_height (cell_id);
+  }
 
-  CPU_GPU float get_edge_area (unsigned int /*cell_id*/, unsigned int edge_id) const
+  CPU_GPU float get_edge_area (unsigned int cell_id, unsigned int edge_id) const
   {
+    if (is_unstructured ())
+      return faces_areas[faces_offsets[cell_id] + edge_id];
+
     if (is_edge_left (edge_id) || is_edge_right (edge_id))
-      return dx;
+      return get_cell_height (cell_id);
 
     if (is_edge_bottom (edge_id) || is_edge_top (edge_id))
-      return dy;
+      return get_cell_width (cell_id);
 
     return {};
   }
 
   CPU_GPU float get_cell_center_x (unsigned int cell_id) const
   {
-    const unsigned int x = cell_id % nx;
+    if (is_unstructured ())
+      return cells_centers_x[cell_id];
+
+    const unsigned int x = order.get_cell_x (cell_id);
+    if (is_rectilinear ())
+      return columns_centers[x];
     return x * dx + dx / 2.0;
   }
 
   CPU_GPU float get_cell_center_y (unsigned int cell_id) const
   {
-    const unsigned int y = cell_id / nx;
+    if (is_unstructured ())
+      return cells_centers_y[cell_id];
+
+    const unsigned int y = order.get_cell_y (cell_id);
+    if (is_rectilinear ())
+      return rows_centers[y];
     return y * dy + dy / 2.0;
   }
 
-  CPU_GPU float get_normal_x (unsigned int /* cell_id */, unsigned int edge_id) const
+  CPU_GPU float get_normal_x (unsigned int cell_id, unsigned int edge_id) const
   {
+    if (is_unstructured ())
+      return faces_normals_x[faces_offsets[cell_id] + edge_id];
+
     if (is_edge_left (edge_id))
       return -1.0;
     else if (is_edge_bottom (edge_id) || is_edge_top (edge_id))
@@ -222,8 +878,11 @@ public:
     return 0.0;
   }
 
-  CPU_GPU float get_normal_y (unsigned int /* cell_id */, unsigned int edge_id) const
+  CPU_GPU float get_normal_y (unsigned int cell_id, unsigned int edge_id) const
   {
+    if (is_unstructured ())
+      return faces_normals_y[faces_offsets[cell_id] + edge_id];
+
     if (is_edge_left (edge_id) || is_edge_right (edge_id))
       return 0.0;
     else if (is_edge_bottom (edge_id))
@@ -244,20 +903,195 @@ public:
     return std::abs (get_cell_center_y (first_cell) - get_cell_center_y (second_cell));
   }
 
+  /// Structured grids only
   CPU_GPU unsigned int get_cell_id_by_coordinates (float x, float y) const
   {
+    if (is_rectilinear ())
+      return order.get_cell_id (
+        find_segment (x, nx, columns_widths, columns_centers),
+        find_segment (y, ny, rows_heights, rows_centers));
+
     const unsigned int grid_x = std::ceil (x / dx);
     const unsigned int grid_y = std::ceil (y / dy);
-    return nx * grid_y + grid_x;
+    return order.get_cell_id (grid_x, grid_y);
+  }
+
+private:
+  /// Binary search of the segment that contains coordinate, coordinates outside the grid map to the closest segment
+  CPU_GPU static unsigned int find_segment (float coordinate, unsigned int n, const float *sizes, const float *centers)
+  {
+    unsigned int begin = 0;
+    unsigned int end = n - 1;
+
+    while (begin < end)
+    {
+      const unsigned int middle = (begin + end) / 2;
+      if (coordinate < centers[middle] + sizes[middle] / 2)
+        end = middle;
+      else
+        begin = middle + 1;
+    }
+
+    return begin;
   }
 
 private:
   float dx, dy;
+  float min_spacing;
   unsigned int nx, ny;
+  grid_cells_order order;
+
+  /// Rectilinear grid arrays, columns_widths is null for uniform grids
+  const float *columns_widths;
+  const float *columns_centers;
+  const float *rows_heights;
+  const float *rows_centers;
+
+  /// Unstructured mesh arrays, faces_offsets is null for structured grids
+  const unsigned int *faces_offsets;
+  const float *faces_normals_x;
+  const float *faces_normals_y;
+  const float *faces_areas;
+  const float *cells_volumes;
+  const float *cells_centers_x;
+  const float *cells_centers_y;
+};
+
+enum class face_type
+{
+  left, bottom, back, right, top, front
 };
 
+inline CPU_GPU unsigned int face_to_id (face_type face)
+{
+  switch (face)
+  {
+    case face_type::left:   return 0;
+    case face_type::bottom: return 1;
+    case face_type::back:   return 2;
+    case face_type::right:  return 3;
+    case face_type::top:    return 4;
+    case face_type::front:  return 5;
+    default:                return 0;
+  }
+
+  return 0;
+}
+
+/**
+ * Topology of structured 3D grid with periodic boundaries. Layers of nx * ny cells are stored one
+ * after another (row major inside of layers), so a layer is a contiguous slab of fields and the
+ * neighbours across layers are nx * ny cells away.
+ */
+class grid_3d_topology
+{
+public:
+  void initialize_for_structured_uniform_grid (unsigned int nx_arg, unsigned int ny_arg, unsigned int nz_arg)
+  {
+    nx = nx_arg;
+    ny = ny_arg;
+    nz = nz_arg;
+  }
+
+  CPU_GPU unsigned int get_nx () const { return nx; }
+  CPU_GPU unsigned int get_ny () const { return ny; }
+  CPU_GPU unsigned int get_nz () const { return nz; }
+  CPU_GPU unsigned int get_layer_cells_count () const { return nx * ny; }
+  CPU_GPU unsigned int get_cells_count () const { return nx * ny * nz; }
+  CPU_GPU unsigned int get_faces_count (unsigned int /* cell_id */) const { return 6; }
+
+  CPU_GPU unsigned int get_cell_id (unsigned int x, unsigned int y, unsigned int z) const { return (z * ny + y) * nx + x; }
+  CPU_GPU unsigned int get_cell_x (unsigned int cell_id) const { return cell_id % nx; }
+  CPU_GPU unsigned int get_cell_y (unsigned int cell_id) const { return (cell_id / nx) % ny; }
+  CPU_GPU unsigned int get_cell_z (unsigned int cell_id) const { return cell_id / (nx * ny); }
+
+  CPU_GPU unsigned int get_neighbor_id (unsigned int cell_id, unsigned int face_id) const
+  {
+    const unsigned int x = get_cell_x (cell_id);
+    const unsigned int y = get_cell_y (cell_id);
+    const unsigned int z = get_cell_z (cell_id);
+
+    if (face_id == face_to_id (face_type::left))
+      return get_cell_id (x == 0 ? nx - 1 : x - 1, y, z);
+    else if (face_id == face_to_id (face_type::bottom))
+      return get_cell_id (x, y == 0 ? ny - 1 : y - 1, z);
+    else if (face_id == face_to_id (face_type::back))
+      return get_cell_id (x, y, z == 0 ? nz - 1 : z - 1);
+    else if (face_id == face_to_id (face_type::right))
+      return get_cell_id (x == nx - 1 ? 0 : x + 1, y, z);
+    else if (face_id == face_to_id (face_type::top))
+      return get_cell_id (x, y == ny - 1 ? 0 : y + 1, z);
+    else if (face_id == face_to_id (face_type::front))
+      return get_cell_id (x, y, z == nz - 1 ? 0 : z + 1);
+
+    return unknown_neighbor_id;
+  }
+
+private:
+  unsigned int nx, ny, nz;
+};
+
+class grid_3d_geometry
+{
+public:
+  void initialize_for_structured_uniform_grid (
+    unsigned int nx_arg, unsigned int ny_arg, unsigned int nz_arg,
+    float dx_arg, float dy_arg, float dz_arg)
+  {
+    nx = nx_arg;
+    ny = ny_arg;
+    nz = nz_arg;
+    dx = dx_arg;
+    dy = dy_arg;
+    dz = dz_arg;
+  }
+
+  CPU_GPU float get_dx () const { return dx; }
+  CPU_GPU float get_dy () const { return dy; }
+  CPU_GPU float get_dz () const { return dz; }
+  CPU_GPU float get_min_spacing () const { return std::min (dx, std::min (dy, dz)); }
+  CPU_GPU float get_cell_volume (unsigned int /* cell_id */) const { return dx * dy * dz; }
+
+  CPU_GPU float get_face_area (unsigned int /* cell_id */, unsigned int face_id) const
+  {
+    if (face_id == face_to_id (face_type::left) || face_id == face_to_id (face_type::right))
+      return dy * dz;
+    else if (face_id == face_to_id (face_type::bottom) || face_id == face_to_id (face_type::top))
+      return dx * dz;
+    return dx * dy;
+  }
+
+  /// Cell that contains the point, points outside the grid map to the closest cell
+  CPU_GPU unsigned int get_cell_id_by_coordinates (float x, float y, float z) const
+  {
+    const unsigned int grid_x = get_index (x, dx, nx);
+    const unsigned int grid_y = get_index (y, dy, ny);
+    const unsigned int grid_z = get_index (z, dz, nz);
+    return (grid_z * ny + grid_y) * nx + grid_x;
+  }
+
+private:
+  CPU_GPU static unsigned int get_index (float coordinate, float d, unsigned int n)
+  {
+    const float index = std::floor (coordinate / d);
+    if (index < 0.0f)
+      return 0;
+    return index < n ? static_cast<unsigned int> (index) : n - 1;
+  }
+
+private:
+  unsigned int nx, ny, nz;
+  float dx, dy, dz;
+};
+
+static_assert(std::is_pod<grid_cells_order>::value, "Class grid_cells_order has to be POD");
 static_assert(std::is_pod<grid_topology>::value, "Class grid_topology has to be POD");
 static_assert(std::is_pod<grid_geometry>::value, "Class grid_geometry has to be POD");
+static_assert(std::is_pod<grid_halo_layout>::value, "Class grid_halo_layout has to be POD");
+static_assert(std::is_pod<grid_3d_topology>::value, "Class grid_3d_topology has to be POD");
+static_assert(std::is_pod<grid_3d_geometry>::value, "Class grid_3d_geometry has to be POD");
+
+class unstructured_mesh;
 
 class grid
 {
@@ -267,7 +1101,9 @@ public:
     unsigned int nx_arg,
     unsigned int ny_arg,
     double width_arg,
-    double height_arg)
+    double height_arg,
+    cells_layout layout = cells_layout::row_major,
+    unsigned int tile_size = grid_cells_order::default_tile_size)
   : nx (nx_arg)
   , ny (ny_arg)
   , size (nx * ny)
@@ -276,63 +1112,186 @@ public:
   , dx (width / nx)
   , dy (height / ny)
   , solver_workspace (workspace_arg)
-  , gl_representation (geometry_element_type::quad, nx * ny)
   {
-    const auto dxf = static_cast<float> (dx);
-    const auto dyf = static_cast<float> (dy);
-
-    for (unsigned int j = 0; j < ny; j++)
-      {
-        const auto fj = static_cast<float> (j);
-
-        for (unsigned int i = 0; i < nx; i++)
-          {
-            const auto fi = static_cast<float> (i);
-            gl_representation.append_pixel (
-                point (dxf * fi, dyf * fj),
-                sizes_set (dxf, dyf));
-          }
-      }
+    initialize_cells_order (layout, tile_size);
+    update_invariants ();
   }
 
+  /**
+   * Rectilinear grid, cells of column i are columns_widths[i] wide and cells of row j are
+   * rows_heights[j] high. Fine cells can be placed only where they are needed.
+   */
+  grid (
+    workspace &workspace_arg,
+    const std::vector<double> &columns_widths_arg,
+    const std::vector<double> &rows_heights_arg,
+    cells_layout layout = cells_layout::row_major,
+    unsigned int tile_size = grid_cells_order::default_tile_size);
+
+  /// Grid of unstructured mesh cells. The mesh has to outlive the grid.
+  grid (workspace &workspace_arg, const unstructured_mesh &mesh_arg);
+
+  /**
+   * @param halo_width Layers of ghost cells around the field (see grid_halo_layout). Fields with
+   *                   halo are stored in padded layout, so they are not listed in fields names
+   *                   that extractors read as nx * ny cells.
+   * @return true if allocation fails or halo is wider than the grid
+   */
   template <class field_type>
-  bool create_field (const std::string &field_name, memory_holder_type holder, unsigned int layouts)
+  bool create_field (const std::string &field_name, memory_holder_type holder, unsigned int layouts, unsigned int halo_width = 0)
   {
-    if (solver_workspace.allocate (field_name, holder, size * sizeof (field_type), layouts))
+    if (halo_width > nx || halo_width > ny || (halo_width && mesh))
       return true;
-    if (std::find (fields_names.begin (), fields_names.end (), field_name) == fields_names.end ())
+
+    const auto layout = gen_halo_layout_wrapper (halo_width);
+    if (solver_workspace.allocate (field_name, holder, layout.get_padded_cells_count () * sizeof (field_type), layouts))
+      return true;
+
+    fields_halo_widths[field_name] = halo_width;
+    if (!halo_width && std::find (fields_names.begin (), fields_names.end (), field_name) == fields_names.end ())
       fields_names.push_back (field_name);
     return false;
   }
 
+  /**
+   * Extrudes the grid into nz layers along z, cells of the xy plane become columns of nz cells.
+   * Should be called by 3D solvers before creating fields.
+   * @return true if the grid isn't uniform structured one or fields are already created
+   */
+  bool set_layers (unsigned int nz_arg, double depth_arg)
+  {
+    if (!nz_arg || depth_arg <= 0.0 || mesh || is_rectilinear () || !fields_halo_widths.empty ())
+      return true;
+
+    nz = nz_arg;
+    depth = depth_arg;
+    return false;
+  }
+
+  unsigned int get_layers_count () const { return nz; }
+
+  /**
+   * Boundary conditions of structured grid sides, periodic by default. Unstructured meshes ignore them.
+   * Periodic side wraps onto the opposite one, so if only one side of a pair is periodic, both sides
+   * take the condition of the other side.
+   */
+  void set_boundary_conditions (boundary_type left, boundary_type bottom, boundary_type right, boundary_type top);
+
+  boundary_type get_boundary_condition (side_type side) const { return boundary_conditions[side_to_id (side)]; }
+
+  /**
+   * Field of nx * ny * nz cells in grid_3d_topology order. Volume fields aren't listed in
+   * fields names, extractors read planar fields of nx * ny cells.
+   * @return true if allocation fails
+   */
+  template <class field_type>
+  bool create_volume_field (const std::string &field_name, memory_holder_type holder, unsigned int layouts)
+  {
+    if (solver_workspace.allocate (field_name, holder, static_cast<std::size_t> (size) * nz * sizeof (field_type), layouts))
+      return true;
+
+    fields_halo_widths[field_name] = 0;
+    return false;
+  }
+
+  /// @return 0 for fields without halo and for unknown fields
+  unsigned int get_field_halo_width (const std::string &field_name) const
+  {
+    auto it = fields_halo_widths.find (field_name);
+    return it == fields_halo_widths.end () ? 0 : it->second;
+  }
+
   [[nodiscard]] const std::vector<std::string> &get_fields_names () const { return fields_names; }
 
   std::size_t get_cells_number () const { return nx * ny; }
 
+  bool is_unstructured () const { return mesh != nullptr; }
+  bool is_rectilinear () const { return !columns_widths.empty (); }
+
   grid_geometry gen_geometry_wrapper () const
   {
+    if (mesh)
+      return gen_unstructured_geometry_wrapper ();
+
     grid_geometry geometry;
-    geometry.initialize_for_structured_uniform_grid (nx, ny, dx, dy);
+    if (is_rectilinear ())
+      geometry.initialize_for_structured_rectilinear_grid (
+        nx, ny,
+        columns_widths.data (), columns_centers.data (),
+        rows_heights.data (), rows_centers.data (),
+        min_spacing, cells_order);
+    else
+      geometry.initialize_for_structured_uniform_grid (nx, ny, dx, dy, cells_order);
+    return geometry;
+  }
+
+  grid_3d_topology gen_3d_topology_wrapper () const
+  {
+    grid_3d_topology topology;
+    topology.initialize_for_structured_uniform_grid (nx, ny, nz);
+    return topology;
+  }
+
+  grid_3d_geometry gen_3d_geometry_wrapper () const
+  {
+    grid_3d_geometry geometry;
+    geometry.initialize_for_structured_uniform_grid (nx, ny, nz, dx, dy, depth / nz);
     return geometry;
   }
 
+  grid_halo_layout gen_halo_layout_wrapper (unsigned int halo_width) const
+  {
+    grid_halo_layout layout;
+    layout.initialize_for_structured_uniform_grid (nx, ny, halo_width);
+    return layout;
+  }
+
   grid_topology gen_topology_wrapper () const
   {
+    if (mesh)
+      return gen_unstructured_topology_wrapper ();
+
     grid_topology topology;
     topology.initialize_for_structured_uniform_grid (
       nx, ny,
-      boundary_to_id (boundary_type::periodic),
-      boundary_to_id (boundary_type::periodic),
-      boundary_to_id (boundary_type::periodic),
-      boundary_to_id (boundary_type::periodic));
+      boundary_to_id (boundary_conditions[side_to_id (side_type::left)]),
+      boundary_to_id (boundary_conditions[side_to_id (side_type::bottom)]),
+      boundary_to_id (boundary_conditions[side_to_id (side_type::right)]),
+      boundary_to_id (boundary_conditions[side_to_id (side_type::top)]),
+      cells_order);
     return topology;
   }
 
   float get_bounding_box_width () const { return width; }
   float get_bounding_box_height () const { return height; }
 
+  /// Shortest cell side (face for unstructured meshes), same as get_min_spacing of the geometry
+  float get_min_spacing () const { return min_spacing; }
+
+  /// Sum of cells volumes
+  double get_total_volume () const { return total_volume; }
+
+  /// Ascending ids of cells that have a side on the domain boundary
+  const std::vector<unsigned int> &get_boundary_cells () const { return boundary_cells; }
+
+  /**
+   * Vertices of cells for GUI and writers. It takes 48 bytes per cell, so it's built on the first
+   * request instead of grid construction and console runs without writers never allocate it.
+   * Safe to call from several threads.
+   */
   const geometry_representation &get_gl_representation () const;
 
+private:
+  grid_topology gen_unstructured_topology_wrapper () const;
+  grid_geometry gen_unstructured_geometry_wrapper () const;
+  void build_gl_representation () const;
+
+  /// Initializes cells order and caches Morton permutation of grids that aren't power of two squares
+  void initialize_cells_order (cells_layout layout, unsigned int tile_size);
+
+  /// Geometry of the grid doesn't change, so values that need a pass over cells are computed once by constructors
+  void update_invariants ();
+
 public:
   const std::size_t vertices_per_cell = 4;
   const std::size_t coordinates_per_vertex = 2;
@@ -347,9 +1306,35 @@ private:
   const double dx;
   const double dy;
 
+  /// Layers of 3D grids, see set_layers
+  unsigned int nz = 1;
+  double depth = 1.0;
+
+  boundary_type boundary_conditions[4] = {
+    boundary_type::periodic, boundary_type::periodic, boundary_type::periodic, boundary_type::periodic };
+
+  grid_cells_order cells_order;
+  std::vector<unsigned int> morton_cell_ids;
+  std::vector<unsigned int> morton_row_major_ids;
+  const unstructured_mesh *mesh = nullptr;
+
+  /// Metric arrays of rectilinear grids, empty for uniform grids
+  std::vector<float> columns_widths;
+  std::vector<float> columns_centers;
+  std::vector<float> rows_heights;
+  std::vector<float> rows_centers;
+
+  /// See update_invariants
+  float min_spacing = 0.0f;
+  double total_volume = 0.0;
+  std::vector<unsigned int> boundary_cells;
+
   workspace &solver_workspace;
   std::vector<std::string> fields_names;
-  geometry_representation gl_representation;
+  std::map<std::string, unsigned int> fields_halo_widths;
+
+  mutable std::once_flag gl_representation_flag;
+  mutable std::unique_ptr<geometry_representation> gl_representation;
 };
 
 #endif //ANYSIM_GRID_H
@@ -0,0 +1,79 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_UNSTRUCTURED_MESH_H
+#define ANYSIM_UNSTRUCTURED_MESH_H
+
+#include <vector>
+
+#include "core/grid/grid.h"
+
+/**
+ * 2D mesh of triangles and quads. Neighbours of cells are stored in CSR arrays: faces of the
+ * cell are [cells_offsets[cell_id], cells_offsets[cell_id + 1]) and each face knows its neighbour
+ * cell. Face normals and areas and cell volumes and centers are stored in separate arrays, so
+ * kernels read only what they use. Boundary faces have the cell itself as neighbour, as the
+ * mirror boundary of structured grids. The mesh has to outlive topology and geometry wrappers.
+ */
+class unstructured_mesh
+{
+public:
+  /**
+   * @param cells_offsets Vertices of the cell are [cells_offsets[cell_id], cells_offsets[cell_id + 1])
+   *                      of cells_vertices. Clockwise cells are turned counterclockwise.
+   * @return true if a cell isn't a triangle or a quad, refers to an unknown vertex or is degenerate
+   */
+  bool build (
+      std::vector<float> vertices_x_arg,
+      std::vector<float> vertices_y_arg,
+      std::vector<unsigned int> cells_offsets_arg,
+      std::vector<unsigned int> cells_vertices_arg);
+
+  /**
+   * Reverse Cuthill-McKee order of cells, which keeps neighbours ids close. Each connected part of the
+   * mesh starts from its cell of min degree that is farthest from an arbitrary cell of the part.
+   * @return old id of each new cell
+   */
+  std::vector<unsigned int> get_rcm_order () const;
+
+  /// Renumbers cells. new_to_old has to be a permutation of cells ids.
+  void reorder (const std::vector<unsigned int> &new_to_old);
+
+  unsigned int get_cells_count () const { return cells_offsets.size () - 1; }
+  unsigned int get_cell_vertices_count (unsigned int cell_id) const { return cells_offsets[cell_id + 1] - cells_offsets[cell_id]; }
+  unsigned int get_cell_vertex (unsigned int cell_id, unsigned int vertex_id) const { return cells_vertices[cells_offsets[cell_id] + vertex_id]; }
+  float get_vertex_x (unsigned int vertex_id) const { return vertices_x[vertex_id]; }
+  float get_vertex_y (unsigned int vertex_id) const { return vertices_y[vertex_id]; }
+
+  /// Max difference between ids of neighbouring cells
+  unsigned int get_bandwidth () const { return bandwidth; }
+
+  /// Shortest face of the mesh
+  float get_min_spacing () const { return min_spacing; }
+  float get_cell_volume (unsigned int cell_id) const { return cells_volumes[cell_id]; }
+
+  grid_topology gen_topology_wrapper () const;
+  grid_geometry gen_geometry_wrapper () const;
+
+private:
+  std::vector<float> vertices_x;
+  std::vector<float> vertices_y;
+  std::vector<unsigned int> cells_offsets;
+  std::vector<unsigned int> cells_vertices;
+
+  /// Faces of cells follow cells vertices (face i goes from vertex i to vertex i + 1), so cells_offsets are faces offsets too
+  std::vector<unsigned int> faces_neighbors;
+  std::vector<float> faces_normals_x;
+  std::vector<float> faces_normals_y;
+  std::vector<float> faces_areas;
+
+  std::vector<float> cells_volumes;
+  std::vector<float> cells_centers_x;
+  std::vector<float> cells_centers_y;
+
+  unsigned int bandwidth = 0;
+  float min_spacing = 0.0f;
+};
+
+#endif  // ANYSIM_UNSTRUCTURED_MESH_H
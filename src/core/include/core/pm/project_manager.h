@@ -10,9 +10,11 @@
 #include <vector>
 
 #include "core/sm/multiprocess.h"
+#include "core/cpu/thread_pool.h"
+#include "core/grid/grid.h"
 
-class grid;
 class workspace;
+class unstructured_mesh;
 class configuration;
 class simulation_manager;
 class result_extractor;
@@ -62,16 +64,46 @@ public:
 
   bool get_use_gpu () const { return gpu_num >= 0; }
 
+  void set_scheduling_policy (scheduling_policy policy) { threads_scheduling_policy = policy; }
+  void set_barrier_type (barrier_type type) { threads_barrier_type = type; }
+  void set_pin_threads (bool pin_threads_arg) { pin_threads = pin_threads_arg; }
+  void set_telemetry (bool telemetry_arg) { telemetry = telemetry_arg; }
+  void set_idle_policy (const idle_policy &policy) { threads_idle_policy = policy; }
+  void set_extraction_threads (unsigned int threads_count) { extraction_threads = threads_count; }
+
+  /**
+   * Cells of the mesh replace structured grid of the configuration for solvers that support it.
+   * Takes effect on the next grid creation.
+   */
+  void set_mesh (std::unique_ptr<unstructured_mesh> mesh_arg);
+
+  /// Takes effect on the next grid creation
+  void set_cells_layout (cells_layout layout, unsigned int tile_size)
+  {
+    grid_cells_layout = layout;
+    grid_tile_size = tile_size;
+    version--;
+  }
+
 private:
   unsigned int version = 0;
   std::string solver_name;
   std::string project_name;
   bool use_double_precision = true;
   int gpu_num = -1;
+  scheduling_policy threads_scheduling_policy = scheduling_policy::static_split;
+  barrier_type threads_barrier_type = barrier_type::centralized;
+  bool pin_threads = false;
+  bool telemetry = false;
+  idle_policy threads_idle_policy;
+  unsigned int extraction_threads = 0;
+  cells_layout grid_cells_layout = cells_layout::row_major;
+  unsigned int grid_tile_size = grid_cells_order::default_tile_size;
 
   multiprocess process_manager;
 
   std::string python_initializer;
+  std::unique_ptr<unstructured_mesh> mesh;
   std::unique_ptr<grid> solver_grid;
   std::unique_ptr<workspace> solver_workspace;
   std::unique_ptr<configuration> solver_configuration;
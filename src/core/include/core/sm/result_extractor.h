@@ -32,12 +32,12 @@ class cpu_results_visualizer : public result_extractor
 {
 private:
   template <class data_type>
-  void render (unsigned int thread_id, unsigned int threads_count, thread_pool &threads)
+  void render (unsigned int thread_id, unsigned int /* threads_count */, thread_pool &threads)
   {
     const auto &geometry_representation = pm.get_gl_representation ();
     const auto &solver_workspace = pm.get_solver_workspace ();
-    auto cr = work_range::split (geometry_representation.get_elements_count (), thread_id, threads_count);
-    auto data = reinterpret_cast<const data_type*> (solver_workspace.get (target_name));
+    const unsigned int elements_count = geometry_representation.get_elements_count ();
+    auto data = reinterpret_cast<const data_type*> (solver_workspace.get_results (target_name));
 
     if (!data)
       return;
@@ -45,19 +45,24 @@ private:
     data_type min = std::numeric_limits<data_type>::max ();
     data_type max = std::numeric_limits<data_type>::min ();
 
-    for (unsigned int c = cr.chunk_begin; c < cr.chunk_end; c++)
-    {
-      const data_type val = data[c];
-      if (val > max) max = val;
-      if (val < min) min = val;
-    }
-
-    threads.reduce_min (thread_id, min);
-    threads.reduce_max (thread_id, max);
-
-    for (unsigned int c = cr.chunk_begin; c < cr.chunk_end; c++)
-      for (unsigned int k = 0; k < 4; k++)
-        fill_vertex_color (data[c], colors + 3 * 4 * c + 3 * k, min, max);
+    threads.for_each_chunk (thread_id, elements_count, [&] (const work_range &cr) {
+      for (unsigned int c = cr.chunk_begin; c < cr.chunk_end; c++)
+      {
+        const data_type val = data[c];
+        if (val > max) max = val;
+        if (val < min) min = val;
+      }
+    });
+
+    std::tuple<data_type, data_type> min_max (min, max);
+    threads.reduce (thread_id, min_max, tuple_operation (min_operation {}, max_operation {}));
+    std::tie (min, max) = min_max;
+
+    threads.for_each_chunk (thread_id, elements_count, [&] (const work_range &cr) {
+      for (unsigned int c = cr.chunk_begin; c < cr.chunk_end; c++)
+        for (unsigned int k = 0; k < 4; k++)
+          fill_vertex_color (data[c], colors + 3 * 4 * c + 3 * k, min, max);
+    });
   }
 
 public:
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "core/cpu/thread_pool.h"
 
@@ -16,6 +17,18 @@ class workspace;
 class configuration;
 class result_extractor;
 
+/// Load balance of compute threads over the steps of the last render interval
+struct threads_imbalance_report
+{
+  unsigned int steps_count = 0;
+  double max_compute_time = 0.0;  /// Seconds per step of the slowest thread
+  double mean_compute_time = 0.0; /// Seconds per step averaged over threads
+  double mean_barrier_time = 0.0; /// Seconds per step averaged over threads
+  double barrier_episodes = 0.0;  /// Per step and thread
+
+  double get_imbalance () const { return mean_compute_time > 0.0 ? max_compute_time / mean_compute_time : 1.0; }
+};
+
 class simulation_manager
 {
 public:
@@ -31,8 +44,38 @@ public:
   void extract (result_extractor **extractors, unsigned int extractors_count);
   bool calculate_next_time_step (result_extractor **extractors, unsigned int extractors_count);
   bool is_gpu_supported () const;
+  bool is_unstructured_mesh_supported () const;
+
+  void set_scheduling_policy (scheduling_policy policy);
+  void set_barrier_type (barrier_type type);
+  void pin_threads ();
+  void set_idle_policy (const idle_policy &policy);
+
+  /**
+   * Moves extractors to their own team of threads_count threads. They extract a snapshot
+   * of the previous render interval while the rest of threads compute the next one, so
+   * results lag one interval behind. Zero runs extractors on all threads after the steps.
+   */
+  void set_extraction_threads (unsigned int threads_count);
+
+  /// Enables thread_pool telemetry and prints imbalance report after each render interval
+  void set_telemetry (bool enable);
+  const threads_imbalance_report &get_imbalance_report () const { return imbalance_report; }
+
+private:
+  void update_imbalance_report (unsigned int steps_count, double tsc_frequency);
+
+  bool is_extraction_thread (unsigned int thread_id) const;
+  void run_extractors (unsigned int thread_id, result_extractor **extractors, unsigned int extractors_count);
+  void extract_snapshot (result_extractor **extractors, unsigned int extractors_count);
+  void update_snapshot ();
+  void update_results ();
 
 private:
+  threads_imbalance_report imbalance_report;
+  std::vector<thread_telemetry> steps_telemetry;
+  bool snapshot_ready = false;
+  unsigned int extraction_threads = 0;
   size_t step = 0;
   double time = 0.0;
   double max_time = 0.0;
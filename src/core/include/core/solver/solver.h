@@ -26,8 +26,12 @@ public:
   virtual double solve (unsigned int step, unsigned int thread_id, unsigned int total_threads) = 0;
   virtual void apply_configuration (const configuration &config, std::size_t config_id, grid *solver_grid, int gpu_num) = 0;
   virtual void handle_grid_change () = 0;
+
+  /// Derives fields that steps don't keep up to date, called from all threads before results are extracted
+  virtual void update_results (unsigned int thread_id, unsigned int threads_count) = 0;
   virtual void fill_configuration_scheme (configuration &config, std::size_t config_id) = 0;
   virtual bool is_gpu_supported () const = 0;
+  virtual bool is_unstructured_mesh_supported () const = 0;
 
 protected:
   thread_pool &threads;
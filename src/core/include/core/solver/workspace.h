@@ -15,6 +15,7 @@ enum class memory_holder_type
 };
 
 class pinned_memory;
+class memory_object;
 class layered_memory_object;
 
 class workspace
@@ -43,9 +44,23 @@ public:
    */
   const void *get_host_copy (const std::string &name) const;
 
+  /**
+   * Snapshot keeps copies of active layers of host memory objects, so results of one
+   * step can be extracted while solver computes the next ones. Prepare allocates copies
+   * and has to be called before update_snapshot, which copies thread's part of each
+   * object and is called from all threads of the pool.
+   */
+  bool prepare_snapshot ();
+  void update_snapshot (unsigned int thread_id, unsigned int threads_count);
+  void drop_snapshot ();
+
+  /// Returns snapshot of name if there is one and host copy otherwise
+  const void *get_results (const std::string &name) const;
+
 private:
   std::unique_ptr<pinned_memory> temporal_buffer;
   std::map<std::string, std::unique_ptr<layered_memory_object>> storage;
+  std::map<std::string, std::unique_ptr<memory_object>> snapshot;
 };
 
 #endif //ANYSIM_WORKSPACE_H
@@ -0,0 +1,103 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/adaptive_partition.h"
+
+#include <algorithm>
+
+adaptive_partition::adaptive_partition (
+    unsigned int max_threads_count_arg,
+    unsigned int window_arg,
+    double hysteresis_arg)
+  : max_threads_count (max_threads_count_arg)
+  , window (std::max (1u, window_arg))
+  , hysteresis (hysteresis_arg)
+  , costs (new cache_padded_chunk_cost[max_threads_count_arg])
+{
+  reset ();
+}
+
+void adaptive_partition::reset (unsigned int min_chunk_size_arg)
+{
+  min_chunk_size = std::max (1u, min_chunk_size_arg);
+  boundaries_work_size = 0;
+  boundaries_threads_count = 0;
+
+  /// Threads of a team have to reach the end of window together
+  for (unsigned int thread_id = 0; thread_id < max_threads_count; thread_id++)
+  {
+    costs[thread_id].ticks = 0;
+    costs[thread_id].calls = 0;
+  }
+}
+
+work_range adaptive_partition::get_chunk (unsigned int team_thread_id, unsigned int team_threads_count, unsigned int work_size) const
+{
+  if (work_size != boundaries_work_size || team_threads_count != boundaries_threads_count)
+    return work_range::split (work_size, team_thread_id, team_threads_count);
+
+  return work_range (boundaries[team_thread_id], boundaries[team_thread_id + 1]);
+}
+
+void adaptive_partition::rebalance (thread_pool &threads, unsigned int thread_id, unsigned int work_size)
+{
+  /// Every thread of the team has recorded its window and nobody reads boundaries until the second barrier
+  threads.barrier (thread_id);
+
+  if (threads.is_team_leader (thread_id))
+    balance_boundaries (thread_id, threads.get_team_threads_count (thread_id), work_size);
+
+  threads.barrier (thread_id);
+
+  costs[thread_id].ticks = 0;
+  costs[thread_id].calls = 0;
+}
+
+void adaptive_partition::balance_boundaries (unsigned int first_thread, unsigned int team_threads_count, unsigned int work_size)
+{
+  std::vector<unsigned int> current (team_threads_count + 1, work_size);
+  for (unsigned int team_thread_id = 0; team_thread_id < team_threads_count; team_thread_id++)
+    current[team_thread_id] = get_chunk (team_thread_id, team_threads_count, work_size).chunk_begin;
+
+  double total_ticks = 0.0;
+  double max_ticks = 0.0;
+  for (unsigned int team_thread_id = 0; team_thread_id < team_threads_count; team_thread_id++)
+  {
+    total_ticks += costs[first_thread + team_thread_id].ticks;
+    max_ticks = std::max (max_ticks, static_cast<double> (costs[first_thread + team_thread_id].ticks));
+  }
+
+  boundaries = current;
+  boundaries_work_size = work_size;
+  boundaries_threads_count = team_threads_count;
+
+  const double mean_ticks = total_ticks / team_threads_count;
+  if (total_ticks == 0.0 || max_ticks <= mean_ticks * (1.0 + hysteresis))
+    return;
+
+  if (work_size < team_threads_count * min_chunk_size)
+    return;
+
+  /// Cost is assumed to be uniform inside of each chunk
+  unsigned int chunk = 0;
+  double chunks_ticks = 0.0;
+
+  for (unsigned int boundary = 1; boundary < team_threads_count; boundary++)
+  {
+    const double target_ticks = mean_ticks * boundary;
+
+    while (chunk < team_threads_count - 1 && chunks_ticks + costs[first_thread + chunk].ticks < target_ticks)
+      chunks_ticks += costs[first_thread + chunk++].ticks;
+
+    const double chunk_ticks = costs[first_thread + chunk].ticks;
+    const double fraction = chunk_ticks > 0.0 ? std::min (1.0, (target_ticks - chunks_ticks) / chunk_ticks) : 0.0;
+    boundaries[boundary] = current[chunk] + static_cast<unsigned int> (fraction * (current[chunk + 1] - current[chunk]));
+  }
+
+  for (unsigned int boundary = 1; boundary < team_threads_count; boundary++)
+    boundaries[boundary] = std::max (boundaries[boundary], boundaries[boundary - 1] + min_chunk_size);
+
+  for (unsigned int boundary = team_threads_count - 1; boundary > 0; boundary--)
+    boundaries[boundary] = std::min (boundaries[boundary], boundaries[boundary + 1] - min_chunk_size);
+}
@@ -0,0 +1,104 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/barrier.h"
+
+#include <map>
+#include <algorithm>
+
+centralized_barrier::centralized_barrier (unsigned int threads_count)
+  : total_threads (threads_count)
+  , threads_in_barrier (0)
+  , threads_ids (threads_count)
+  , waiters (new idle_waiter[threads_count])
+{
+  for (unsigned int thread_id = 0; thread_id < total_threads; thread_id++)
+    threads_ids[thread_id] = thread_id;
+}
+
+void centralized_barrier::set_idle_policy (const idle_policy &policy)
+{
+  for (unsigned int thread_id = 0; thread_id < total_threads; thread_id++)
+    waiters[thread_id].set_policy (policy);
+}
+
+combining_tree_barrier::combining_tree_barrier (
+    const std::vector<unsigned int> &threads_numa_nodes,
+    unsigned int fan_in_arg)
+  : threads_leaves (threads_numa_nodes.size ())
+  , waiters (new idle_waiter[threads_numa_nodes.size ()])
+{
+  const unsigned int fan_in = std::max (2u, fan_in_arg);
+
+  std::vector<unsigned int> parents;
+  std::vector<unsigned int> representatives;
+  std::vector<std::vector<unsigned int>> sources;
+
+  /// Groups sources by fan_in and returns indices of created nodes
+  auto create_level = [&] (const std::vector<unsigned int> &level_sources) {
+    std::vector<unsigned int> level;
+    for (unsigned int first_source = 0; first_source < level_sources.size (); first_source += fan_in)
+    {
+      const unsigned int last_source = std::min<unsigned int> (first_source + fan_in, level_sources.size ());
+
+      level.push_back (sources.size ());
+      sources.emplace_back (level_sources.begin () + first_source, level_sources.begin () + last_source);
+      representatives.push_back (level_sources[first_source]);
+      parents.push_back (0);
+    }
+    return level;
+  };
+
+  auto create_subtree_root = [&] (std::vector<unsigned int> level) {
+    while (level.size () > 1)
+    {
+      std::vector<unsigned int> level_sources;
+      for (auto &node: level)
+        level_sources.push_back (representatives[node]);
+
+      auto parents_level = create_level (level_sources);
+      for (unsigned int child = 0; child < level.size (); child++)
+        parents[level[child]] = parents_level[child / fan_in];
+
+      level = std::move (parents_level);
+    }
+    return level.front ();
+  };
+
+  std::map<unsigned int, std::vector<unsigned int>> numa_groups;
+  for (unsigned int thread_id = 0; thread_id < threads_numa_nodes.size (); thread_id++)
+    numa_groups[threads_numa_nodes[thread_id]].push_back (thread_id);
+
+  std::vector<unsigned int> numa_roots;
+  for (auto &numa_group: numa_groups)
+  {
+    const auto &group_threads = numa_group.second;
+    auto leaves = create_level (group_threads);
+
+    for (unsigned int thread = 0; thread < group_threads.size (); thread++)
+      threads_leaves[group_threads[thread]] = leaves[thread / fan_in];
+
+    numa_roots.push_back (create_subtree_root (leaves));
+  }
+
+  root = create_subtree_root (numa_roots);
+  parents[root] = root;
+
+  nodes.reset (new tree_node[sources.size ()]);
+  for (unsigned int node_id = 0; node_id < sources.size (); node_id++)
+  {
+    nodes[node_id].arrived.store (0);
+    nodes[node_id].children_count = sources[node_id].size ();
+    nodes[node_id].parent = parents[node_id];
+    nodes[node_id].representative = representatives[node_id];
+    nodes[node_id].sources_offset = nodes_sources.size ();
+    nodes_sources.insert (nodes_sources.end (), sources[node_id].begin (), sources[node_id].end ());
+  }
+}
+
+void combining_tree_barrier::set_idle_policy (const idle_policy &policy)
+{
+  for (unsigned int thread_id = 0; thread_id < threads_leaves.size (); thread_id++)
+    waiters[thread_id].set_policy (policy);
+}
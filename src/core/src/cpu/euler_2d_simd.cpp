@@ -0,0 +1,113 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/euler_2d_simd.h"
+
+#include "instrset.h"
+
+/// Kernels of euler_2d_simd_kernel.cpp, one namespace per instruction set
+#define DECLARE_EULER_2D_SIMD_KERNELS(instruction_set)                              \
+  namespace euler_2d_simd_##instruction_set                                         \
+  {                                                                                 \
+    euler_2d_simd_faces_kernel_type<float> calculate_faces_fluxes;                  \
+    euler_2d_simd_faces_kernel_type<double> calculate_faces_fluxes;                 \
+    euler_2d_simd_update_kernel_type<float> update_cells_values;                    \
+    euler_2d_simd_update_kernel_type<double> update_cells_values;                   \
+    euler_2d_simd_faces_kernel_type<float> calculate_conservative_faces_fluxes;     \
+    euler_2d_simd_faces_kernel_type<double> calculate_conservative_faces_fluxes;    \
+    euler_2d_simd_update_kernel_type<float> update_conservative_cells_values;       \
+    euler_2d_simd_update_kernel_type<double> update_conservative_cells_values;      \
+  }
+
+DECLARE_EULER_2D_SIMD_KERNELS(sse2)
+DECLARE_EULER_2D_SIMD_KERNELS(sse42)
+DECLARE_EULER_2D_SIMD_KERNELS(avx2)
+DECLARE_EULER_2D_SIMD_KERNELS(avx512)
+
+#undef DECLARE_EULER_2D_SIMD_KERNELS
+
+namespace
+{
+
+/// Instruction set levels of vectorclass instrset_detect
+enum class simd_instruction_set
+{
+  sse2 = 2, sse42 = 6, avx2 = 8, avx512 = 9
+};
+
+simd_instruction_set detect_instruction_set ()
+{
+  static const simd_instruction_set instruction_set = [] {
+    const int level = instrset_detect ();
+
+    if (level >= static_cast<int> (simd_instruction_set::avx512))
+      return simd_instruction_set::avx512;
+    if (level >= static_cast<int> (simd_instruction_set::avx2) && hasFMA3 ())
+      return simd_instruction_set::avx2;
+    if (level >= static_cast<int> (simd_instruction_set::sse42))
+      return simd_instruction_set::sse42;
+    return simd_instruction_set::sse2;
+  } ();
+
+  return instruction_set;
+}
+
+}
+
+template <class float_type>
+const euler_2d_simd_kernels<float_type> &get_euler_2d_simd_kernels ()
+{
+  static const euler_2d_simd_kernels<float_type> kernels = [] {
+    /// Overloads of the same name are told apart by the pointer types
+    euler_2d_simd_kernels<float_type> result;
+
+    switch (detect_instruction_set ())
+    {
+      case simd_instruction_set::avx512:
+        result.calculate_faces_fluxes = euler_2d_simd_avx512::calculate_faces_fluxes;
+        result.update_cells_values = euler_2d_simd_avx512::update_cells_values;
+        result.calculate_conservative_faces_fluxes = euler_2d_simd_avx512::calculate_conservative_faces_fluxes;
+        result.update_conservative_cells_values = euler_2d_simd_avx512::update_conservative_cells_values;
+        break;
+      case simd_instruction_set::avx2:
+        result.calculate_faces_fluxes = euler_2d_simd_avx2::calculate_faces_fluxes;
+        result.update_cells_values = euler_2d_simd_avx2::update_cells_values;
+        result.calculate_conservative_faces_fluxes = euler_2d_simd_avx2::calculate_conservative_faces_fluxes;
+        result.update_conservative_cells_values = euler_2d_simd_avx2::update_conservative_cells_values;
+        break;
+      case simd_instruction_set::sse42:
+        result.calculate_faces_fluxes = euler_2d_simd_sse42::calculate_faces_fluxes;
+        result.update_cells_values = euler_2d_simd_sse42::update_cells_values;
+        result.calculate_conservative_faces_fluxes = euler_2d_simd_sse42::calculate_conservative_faces_fluxes;
+        result.update_conservative_cells_values = euler_2d_simd_sse42::update_conservative_cells_values;
+        break;
+      case simd_instruction_set::sse2:
+        result.calculate_faces_fluxes = euler_2d_simd_sse2::calculate_faces_fluxes;
+        result.update_cells_values = euler_2d_simd_sse2::update_cells_values;
+        result.calculate_conservative_faces_fluxes = euler_2d_simd_sse2::calculate_conservative_faces_fluxes;
+        result.update_conservative_cells_values = euler_2d_simd_sse2::update_conservative_cells_values;
+        break;
+    }
+
+    return result;
+  } ();
+
+  return kernels;
+}
+
+const char *get_euler_2d_simd_instruction_set ()
+{
+  switch (detect_instruction_set ())
+  {
+    case simd_instruction_set::avx512: return "AVX-512";
+    case simd_instruction_set::avx2:   return "AVX2";
+    case simd_instruction_set::sse42:  return "SSE4.2";
+    case simd_instruction_set::sse2:   return "SSE2";
+  }
+
+  return "";
+}
+
+template const euler_2d_simd_kernels<float> &get_euler_2d_simd_kernels<float> ();
+template const euler_2d_simd_kernels<double> &get_euler_2d_simd_kernels<double> ();
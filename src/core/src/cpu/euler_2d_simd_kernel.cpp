@@ -0,0 +1,431 @@
+//
+// Created by egi on 10/17/26.
+//
+
+/**
+ * SIMD versions of euler_2d_calculate_face_flux and euler_2d_update_cell_values. The file is
+ * compiled once per instruction set with VCL_NAMESPACE set to a distinct namespace, so inline
+ * functions of vectorclass compiled for different instruction sets don't get merged by the
+ * linker. For the same reason the file doesn't use inline functions of other headers.
+ * euler_2d_simd.cpp picks the kernels at run time.
+ */
+
+#include "core/cpu/euler_2d_simd.h"
+
+#include "vectorclass.h"
+
+#if INSTRSET >= 9
+#define EULER_2D_SIMD_NAMESPACE euler_2d_simd_avx512
+using vec_float = VCL_NAMESPACE::Vec16f;
+using vec_double = VCL_NAMESPACE::Vec8d;
+#elif INSTRSET >= 8
+#define EULER_2D_SIMD_NAMESPACE euler_2d_simd_avx2
+using vec_float = VCL_NAMESPACE::Vec8f;
+using vec_double = VCL_NAMESPACE::Vec4d;
+#elif INSTRSET >= 6
+#define EULER_2D_SIMD_NAMESPACE euler_2d_simd_sse42
+using vec_float = VCL_NAMESPACE::Vec4f;
+using vec_double = VCL_NAMESPACE::Vec2d;
+#elif INSTRSET >= 2
+#define EULER_2D_SIMD_NAMESPACE euler_2d_simd_sse2
+using vec_float = VCL_NAMESPACE::Vec4f;
+using vec_double = VCL_NAMESPACE::Vec2d;
+#else
+#error Unsupported instruction set
+#endif
+
+namespace EULER_2D_SIMD_NAMESPACE
+{
+
+namespace
+{
+
+template <class float_type> struct vector_of;
+template <> struct vector_of<float> { using type = vec_float; };
+template <> struct vector_of<double> { using type = vec_double; };
+
+/// std::max and std::min pick the first argument for equal values, e.g. signed zeros
+template <class vec_type>
+vec_type scalar_max (const vec_type &a, const vec_type &b)
+{
+  return select (a < b, b, a);
+}
+
+template <class vec_type>
+vec_type scalar_min (const vec_type &a, const vec_type &b)
+{
+  return select (b < a, b, a);
+}
+
+template <class vec_type, class float_type>
+vec_type calculate_total_energy (const vec_type &p, const vec_type &u, const vec_type &v, const vec_type &rho, float_type gamma)
+{
+  return p / ((gamma - 1.0f) * rho) + (u*u + v*v) / 2.0f;
+}
+
+/**
+ * State vectors of cells [i, i + lanes), density and pressure are returned for the flux calculation.
+ * Layers of conservative variables rho * u, rho * v and rho * E are passed in place of p_u, p_v and p_p.
+ */
+template <bool is_conservative, class vec_type, class float_type>
+void load_state (
+    unsigned int i,
+    float_type gamma,
+    const float_type *p_rho,
+    const float_type *p_u,
+    const float_type *p_v,
+    const float_type *p_p,
+    vec_type *q,
+    vec_type &rho,
+    vec_type &p)
+{
+  if constexpr (is_conservative)
+  {
+    rho.load (p_rho + i);
+    q[0] = rho;
+    q[1].load (p_u + i);
+    q[2].load (p_v + i);
+    q[3].load (p_p + i);
+    p = (gamma - 1.0f) * (q[3] - (q[1] * q[1] + q[2] * q[2]) / (2.0f * q[0]));
+  }
+  else
+  {
+    vec_type u, v;
+
+    rho.load (p_rho + i);
+    u.load (p_u + i);
+    v.load (p_v + i);
+    p.load (p_p + i);
+
+    q[0] = rho;
+    q[1] = rho * u;
+    q[2] = rho * v;
+    q[3] = rho * calculate_total_energy (p, u, v, rho, gamma);
+  }
+}
+
+template <class vec_type, class float_type>
+void rotate_vector_to_edge_coordinates (float_type normal_x, float_type normal_y, const vec_type *v, vec_type *V)
+{
+  V[0] =  v[0];
+  V[1] =  v[1] * normal_x + v[2] * normal_y;
+  V[2] = -v[1] * normal_y + v[2] * normal_x;
+  V[3] =  v[3];
+}
+
+template <class vec_type, class float_type>
+void rotate_vector_from_edge_coordinates (float_type normal_x, float_type normal_y, const vec_type *V, vec_type *v)
+{
+  v[0] = V[0];
+  v[1] = V[1] * normal_x - V[2] * normal_y;
+  v[2] = V[1] * normal_y + V[2] * normal_x;
+  v[3] = V[3];
+}
+
+template <class vec_type>
+void fill_flux_vector (const vec_type *Q_c, const vec_type &U_c, const vec_type &p_c, vec_type *F_c)
+{
+  F_c[0] = Q_c[1];
+  F_c[1] = Q_c[1] * U_c + p_c;
+  F_c[2] = Q_c[2] * U_c;
+  F_c[3] = (Q_c[3] + p_c) * U_c;
+}
+
+/// Rusanov flux of euler_2d_calculate_edge_flux for vec_type lanes
+template <class vec_type, class float_type>
+void calculate_edge_flux (
+    float_type gamma,
+    float_type normal_x,
+    float_type normal_y,
+    const vec_type *q_c, const vec_type *q_n,
+    const vec_type &p_c, const vec_type &p_n,
+    const vec_type &rho_c, const vec_type &rho_n,
+    vec_type *f_sigma)
+{
+  vec_type Q_c[4];
+  vec_type Q_n[4];
+
+  vec_type F_c[4];
+  vec_type F_n[4];
+
+  vec_type F_sigma[4];
+
+  rotate_vector_to_edge_coordinates (normal_x, normal_y, q_c, Q_c);
+  rotate_vector_to_edge_coordinates (normal_x, normal_y, q_n, Q_n);
+
+  const vec_type U_c = Q_c[1] / Q_c[0];
+  const vec_type U_n = Q_n[1] / Q_n[0];
+
+  fill_flux_vector (Q_c, U_c, p_c, F_c);
+  fill_flux_vector (Q_n, U_n, p_n, F_n);
+
+  const vec_type ss_c = sqrt (gamma * p_c / rho_c);
+  const vec_type ss_n = sqrt (gamma * p_n / rho_n);
+
+  const vec_type zero (0.0f);
+  const vec_type splus  = scalar_max (zero, scalar_max (U_c + ss_c, U_n + ss_n));
+  const vec_type sminus = scalar_min (zero, scalar_min (U_c - ss_c, U_n - ss_n));
+  const vec_type sp = scalar_max (splus, -sminus);
+
+  for (int c = 0; c < 4; c++)
+  {
+    const vec_type central_difference = (F_c[c] + F_n[c]) / 2.0f;
+    const vec_type viscosity = sp * (Q_n[c] - Q_c[c]) / 2.0f;
+
+    F_sigma[c] = central_difference - viscosity;
+  }
+
+  rotate_vector_from_edge_coordinates (normal_x, normal_y, F_sigma, f_sigma);
+}
+
+template <bool is_conservative, class float_type>
+unsigned int calculate_faces_fluxes_of_type (
+    unsigned int begin,
+    unsigned int end,
+    unsigned int neighbor_offset,
+
+    float_type gamma,
+    float_type normal_x,
+    float_type normal_y,
+
+    const float_type *p_rho,
+    const float_type *p_u,
+    const float_type *p_v,
+    const float_type *p_p,
+
+    float_type *fluxes,
+    unsigned int stride)
+{
+  using vec_type = typename vector_of<float_type>::type;
+  constexpr unsigned int lanes = vec_type::size ();
+
+  unsigned int cell_id = begin;
+  for (; cell_id + lanes <= end; cell_id += lanes)
+  {
+    vec_type q_c[4];
+    vec_type q_n[4];
+    vec_type f_sigma[4];
+    vec_type rho_c, p_c;
+    vec_type rho_n, p_n;
+
+    load_state<is_conservative> (cell_id, gamma, p_rho, p_u, p_v, p_p, q_c, rho_c, p_c);
+    load_state<is_conservative> (cell_id + neighbor_offset, gamma, p_rho, p_u, p_v, p_p, q_n, rho_n, p_n);
+
+    calculate_edge_flux (gamma, normal_x, normal_y, q_c, q_n, p_c, p_n, rho_c, rho_n, f_sigma);
+
+    for (unsigned int c = 0; c < 4; c++)
+      f_sigma[c].store (fluxes + c * stride + cell_id - begin);
+  }
+
+  return cell_id - begin;
+}
+
+template <bool is_conservative, class float_type>
+unsigned int update_cells_values_of_type (
+    unsigned int begin,
+    unsigned int end,
+
+    float_type dt,
+    float_type gamma,
+    const euler_2d_simd_stencil &stencil,
+
+    const float_type *x_fluxes,
+    const float_type *bottom_fluxes,
+    const float_type *top_fluxes,
+    unsigned int stride,
+
+    const float_type *p_rho,
+    float_type *p_rho_next,
+    const float_type *p_u,
+    float_type *p_u_next,
+    const float_type *p_v,
+    float_type *p_v_next,
+    const float_type *p_p,
+    float_type *p_p_next,
+
+    float_type *max_wave_speed)
+{
+  using vec_type = typename vector_of<float_type>::type;
+  constexpr unsigned int lanes = vec_type::size ();
+
+  /// Lanes of the maximum are folded once per call
+  vec_type lanes_max_wave_speed (0.0f);
+
+  const float_type dt_by_volume = dt / stencil.cell_volume;
+  const float_type edges_areas[4] = {
+    stencil.edges_areas[0], stencil.edges_areas[1], stencil.edges_areas[2], stencil.edges_areas[3] };
+
+  unsigned int cell_id = begin;
+  for (; cell_id + lanes <= end; cell_id += lanes)
+  {
+    vec_type q_c[4];
+    vec_type rho_c, p_c;
+
+    load_state<is_conservative> (cell_id, gamma, p_rho, p_u, p_v, p_p, q_c, rho_c, p_c);
+
+    vec_type flux[4];
+    for (unsigned int c = 0; c < 4; c++)
+    {
+      const unsigned int i = c * stride + cell_id - begin;
+      vec_type left, bottom, right, top;
+
+      left.load (x_fluxes + i);
+      bottom.load (bottom_fluxes + i);
+      right.load (x_fluxes + i + 1);
+      top.load (top_fluxes + i);
+
+      /// Left and bottom fluxes are directed into the cell, edges go in the order of the scalar kernel
+      flux[c] = vec_type (0.0f);
+      flux[c] += edges_areas[0] * -left;
+      flux[c] += edges_areas[1] * -bottom;
+      flux[c] += edges_areas[2] * right;
+      flux[c] += edges_areas[3] * top;
+    }
+
+    vec_type new_q[4];
+    for (int c = 0; c < 4; c++)
+      new_q[c] = q_c[c] - dt_by_volume * flux[c];
+
+    vec_type u, v, a;
+
+    if constexpr (is_conservative)
+    {
+      new_q[0].store (p_rho_next + cell_id);
+      new_q[1].store (p_u_next + cell_id);
+      new_q[2].store (p_v_next + cell_id);
+      new_q[3].store (p_p_next + cell_id);
+
+      if (max_wave_speed)
+      {
+        const vec_type rho_inv = float_type (1.0) / new_q[0];
+        u = new_q[1] * rho_inv;
+        v = new_q[2] * rho_inv;
+
+        const vec_type p = (gamma - 1.0f) * (new_q[3] - (new_q[1] * u + new_q[2] * v) / 2.0f);
+        a = sqrt (gamma * p * rho_inv);
+      }
+    }
+    else
+    {
+      const vec_type rho = new_q[0];
+      const vec_type E   = new_q[3] / rho;
+      u = new_q[1] / rho;
+      v = new_q[2] / rho;
+
+      const vec_type p = (E - (u * u + v * v) / 2.0f) * (gamma - 1.0f) * rho;
+
+      rho.store (p_rho_next + cell_id);
+      u.store (p_u_next + cell_id);
+      v.store (p_v_next + cell_id);
+      p.store (p_p_next + cell_id);
+
+      if (max_wave_speed)
+        a = sqrt (gamma * p / rho);
+    }
+
+    /// Same operations as euler_2d_calculate_max_wave_speed applied to stored values
+    if (max_wave_speed)
+    {
+      lanes_max_wave_speed = max (lanes_max_wave_speed, max (abs (u + a), abs (u - a)));
+      lanes_max_wave_speed = max (lanes_max_wave_speed, max (abs (v + a), abs (v - a)));
+    }
+  }
+
+  if (max_wave_speed)
+  {
+    const float_type processed_max_wave_speed = horizontal_max (lanes_max_wave_speed);
+    if (processed_max_wave_speed > *max_wave_speed)
+      *max_wave_speed = processed_max_wave_speed;
+  }
+
+  return cell_id - begin;
+}
+
+}
+
+euler_2d_simd_faces_kernel_type<float> calculate_faces_fluxes;
+euler_2d_simd_faces_kernel_type<double> calculate_faces_fluxes;
+euler_2d_simd_update_kernel_type<float> update_cells_values;
+euler_2d_simd_update_kernel_type<double> update_cells_values;
+euler_2d_simd_faces_kernel_type<float> calculate_conservative_faces_fluxes;
+euler_2d_simd_faces_kernel_type<double> calculate_conservative_faces_fluxes;
+euler_2d_simd_update_kernel_type<float> update_conservative_cells_values;
+euler_2d_simd_update_kernel_type<double> update_conservative_cells_values;
+
+unsigned int calculate_faces_fluxes (
+    unsigned int begin, unsigned int end, unsigned int neighbor_offset, float gamma, float normal_x, float normal_y,
+    const float *p_rho, const float *p_u, const float *p_v, const float *p_p, float *fluxes, unsigned int stride)
+{
+  return calculate_faces_fluxes_of_type<false> (
+      begin, end, neighbor_offset, gamma, normal_x, normal_y, p_rho, p_u, p_v, p_p, fluxes, stride);
+}
+
+unsigned int calculate_faces_fluxes (
+    unsigned int begin, unsigned int end, unsigned int neighbor_offset, double gamma, double normal_x, double normal_y,
+    const double *p_rho, const double *p_u, const double *p_v, const double *p_p, double *fluxes, unsigned int stride)
+{
+  return calculate_faces_fluxes_of_type<false> (
+      begin, end, neighbor_offset, gamma, normal_x, normal_y, p_rho, p_u, p_v, p_p, fluxes, stride);
+}
+
+unsigned int update_cells_values (
+    unsigned int begin, unsigned int end, float dt, float gamma, const euler_2d_simd_stencil &stencil,
+    const float *x_fluxes, const float *bottom_fluxes, const float *top_fluxes, unsigned int stride,
+    const float *p_rho, float *p_rho_next, const float *p_u, float *p_u_next,
+    const float *p_v, float *p_v_next, const float *p_p, float *p_p_next, float *max_wave_speed)
+{
+  return update_cells_values_of_type<false> (
+      begin, end, dt, gamma, stencil, x_fluxes, bottom_fluxes, top_fluxes, stride,
+      p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+}
+
+unsigned int update_cells_values (
+    unsigned int begin, unsigned int end, double dt, double gamma, const euler_2d_simd_stencil &stencil,
+    const double *x_fluxes, const double *bottom_fluxes, const double *top_fluxes, unsigned int stride,
+    const double *p_rho, double *p_rho_next, const double *p_u, double *p_u_next,
+    const double *p_v, double *p_v_next, const double *p_p, double *p_p_next, double *max_wave_speed)
+{
+  return update_cells_values_of_type<false> (
+      begin, end, dt, gamma, stencil, x_fluxes, bottom_fluxes, top_fluxes, stride,
+      p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+}
+
+unsigned int calculate_conservative_faces_fluxes (
+    unsigned int begin, unsigned int end, unsigned int neighbor_offset, float gamma, float normal_x, float normal_y,
+    const float *p_rho, const float *p_u, const float *p_v, const float *p_p, float *fluxes, unsigned int stride)
+{
+  return calculate_faces_fluxes_of_type<true> (
+      begin, end, neighbor_offset, gamma, normal_x, normal_y, p_rho, p_u, p_v, p_p, fluxes, stride);
+}
+
+unsigned int calculate_conservative_faces_fluxes (
+    unsigned int begin, unsigned int end, unsigned int neighbor_offset, double gamma, double normal_x, double normal_y,
+    const double *p_rho, const double *p_u, const double *p_v, const double *p_p, double *fluxes, unsigned int stride)
+{
+  return calculate_faces_fluxes_of_type<true> (
+      begin, end, neighbor_offset, gamma, normal_x, normal_y, p_rho, p_u, p_v, p_p, fluxes, stride);
+}
+
+unsigned int update_conservative_cells_values (
+    unsigned int begin, unsigned int end, float dt, float gamma, const euler_2d_simd_stencil &stencil,
+    const float *x_fluxes, const float *bottom_fluxes, const float *top_fluxes, unsigned int stride,
+    const float *p_rho, float *p_rho_next, const float *p_u, float *p_u_next,
+    const float *p_v, float *p_v_next, const float *p_p, float *p_p_next, float *max_wave_speed)
+{
+  return update_cells_values_of_type<true> (
+      begin, end, dt, gamma, stencil, x_fluxes, bottom_fluxes, top_fluxes, stride,
+      p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+}
+
+unsigned int update_conservative_cells_values (
+    unsigned int begin, unsigned int end, double dt, double gamma, const euler_2d_simd_stencil &stencil,
+    const double *x_fluxes, const double *bottom_fluxes, const double *top_fluxes, unsigned int stride,
+    const double *p_rho, double *p_rho_next, const double *p_u, double *p_u_next,
+    const double *p_v, double *p_v_next, const double *p_p, double *p_p_next, double *max_wave_speed)
+{
+  return update_cells_values_of_type<true> (
+      begin, end, dt, gamma, stencil, x_fluxes, bottom_fluxes, top_fluxes, stride,
+      p_rho, p_rho_next, p_u, p_u_next, p_v, p_v_next, p_p, p_p_next, max_wave_speed);
+}
+
+}
@@ -0,0 +1,112 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/idle_policy.h"
+
+#include <thread>
+#include <climits>
+#include <algorithm>
+
+#include <xmmintrin.h> // For _mm_pause
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using idle_clock = std::chrono::steady_clock;
+
+static void park (std::atomic<unsigned int> &value, unsigned int old_value)
+{
+#ifdef __linux__
+  syscall (SYS_futex, reinterpret_cast<unsigned int *> (&value), FUTEX_WAIT_PRIVATE, old_value, nullptr, nullptr, 0);
+#else
+  (void) value;
+  (void) old_value;
+  std::this_thread::yield ();
+#endif
+}
+
+static void unpark_all (std::atomic<unsigned int> &value)
+{
+#ifdef __linux__
+  syscall (SYS_futex, reinterpret_cast<unsigned int *> (&value), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+  (void) value;
+#endif
+}
+
+void parking_epoch::advance ()
+{
+  /// Either a parking thread sees new value in futex call or we see it in parked counter
+  value.fetch_add (1u, std::memory_order_seq_cst);
+  if (parked.load (std::memory_order_seq_cst))
+    unpark_all (value);
+}
+
+void idle_waiter::set_policy (const idle_policy &policy_arg)
+{
+  policy = policy_arg;
+  spin_budget = policy.spin_time;
+}
+
+void idle_waiter::wait (parking_epoch &epoch, unsigned int old_value)
+{
+  if (epoch.load () != old_value)
+    return;
+
+  const unsigned int spins_between_clock_checks = 64;
+  const auto begin = idle_clock::now ();
+  auto now = begin;
+
+  while (now - begin < spin_budget)
+  {
+    for (unsigned int spin = 0; spin < spins_between_clock_checks; spin++)
+    {
+      if (epoch.load () != old_value)
+      {
+        learn (idle_clock::now () - begin);
+        return;
+      }
+
+      _mm_pause ();
+    }
+
+    now = idle_clock::now ();
+  }
+
+  while (now - begin < spin_budget + policy.yield_time)
+  {
+    if (epoch.load () != old_value)
+    {
+      learn (now - begin);
+      return;
+    }
+
+    std::this_thread::yield ();
+    now = idle_clock::now ();
+  }
+
+  epoch.parked.fetch_add (1u, std::memory_order_seq_cst);
+  while (epoch.value.load (std::memory_order_seq_cst) == old_value)
+    park (epoch.value, old_value);
+  epoch.parked.fetch_sub (1u, std::memory_order_relaxed);
+
+  learn (idle_clock::now () - begin);
+}
+
+void idle_waiter::learn (std::chrono::nanoseconds wait_time)
+{
+  if (!policy.adaptive)
+    return;
+
+  const std::chrono::nanoseconds min_spin_time = std::chrono::microseconds (1);
+
+  /// Long waits halve the budget, short ones bring it back toward spin_time, so a single park doesn't stick
+  if (wait_time < policy.spin_time)
+    spin_budget += (policy.spin_time - spin_budget) / 4;
+  else
+    spin_budget = std::max (min_spin_time, spin_budget / 2);
+}
@@ -0,0 +1,65 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/cpu/numa.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#include <cstring>
+#include <cstdlib>
+#endif
+
+#ifdef __linux__
+static unsigned int get_cpu_numa_node (unsigned int cpu_id)
+{
+  const std::string cpu_path = "/sys/devices/system/cpu/cpu" + std::to_string (cpu_id);
+  DIR *cpu_dir = opendir (cpu_path.c_str ());
+
+  if (!cpu_dir)
+    return 0;
+
+  unsigned int numa_node = 0;
+  while (dirent *entry = readdir (cpu_dir))
+  {
+    if (std::strncmp (entry->d_name, "node", 4) == 0)
+    {
+      numa_node = std::strtoul (entry->d_name + 4, nullptr, 10);
+      break;
+    }
+  }
+
+  closedir (cpu_dir);
+  return numa_node;
+}
+#endif
+
+std::vector<cpu_info> get_available_cpus ()
+{
+  std::vector<cpu_info> cpus;
+
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO (&mask);
+
+  if (sched_getaffinity (0, sizeof (mask), &mask) == 0)
+    for (unsigned int cpu_id = 0; cpu_id < CPU_SETSIZE; cpu_id++)
+      if (CPU_ISSET (cpu_id, &mask))
+        cpus.push_back ({ cpu_id, get_cpu_numa_node (cpu_id) });
+#endif
+
+  if (cpus.empty ())
+    for (unsigned int cpu_id = 0; cpu_id < std::max (1u, std::thread::hardware_concurrency ()); cpu_id++)
+      cpus.push_back ({ cpu_id, 0 });
+
+  std::stable_sort (cpus.begin (), cpus.end (), [] (const cpu_info &l, const cpu_info &r) {
+    return l.numa_node < r.numa_node;
+  });
+
+  return cpus;
+}
@@ -3,22 +3,42 @@
 //
 
 #include "core/cpu/thread_pool.h"
+#include "core/cpu/numa.h"
 
 #include <iostream>
 #include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
-#include <xmmintrin.h> // For _mm_pause
 #include "cpp_itt.h"
 
 thread_pool::thread_pool () : thread_pool (std::thread::hardware_concurrency ()) {}
 
 thread_pool::thread_pool (unsigned int threads_count)
-  : epoch (0)
-  , barrier_epoch (0)
-  , threads_in_barrier (0)
+  : dispatch_waiters (new idle_waiter[threads_count])
+  , finalize_pool (false)
+  , workers_departures (0)
   , total_threads (threads_count)
-  , buffer (new cache_padded_void_ptr[threads_count])
+  , threads_barrier (threads_count)
+  , reduction_slots (new cache_padded_reduction_slot[2 * threads_count])
+  , reductions_count (new cache_padded_counter[threads_count])
+  , tiles (new cache_padded_tiles_range[threads_count])
+  , progress_waiters (new idle_waiter[threads_count])
+  , telemetry (new cache_padded_telemetry[threads_count])
 {
+  const auto cpus = get_available_cpus ();
+  for (unsigned int thread_id = 0; thread_id < total_threads; thread_id++)
+  {
+    threads_cpus.push_back (cpus[thread_id % cpus.size ()].cpu_id);
+    threads_numa_nodes.push_back (cpus[thread_id % cpus.size ()].numa_node);
+  }
+
+  set_teams ({ { "all", total_threads } });
+
   for (unsigned int thread_id = 1; thread_id < total_threads; thread_id++)
     threads.emplace_back (&thread_pool::run_thread, this, thread_id);
 }
@@ -26,7 +46,7 @@ thread_pool::thread_pool (unsigned int threads_count)
 thread_pool::~thread_pool ()
 {
   finalize_pool = true;
-  cv.notify_all ();
+  dispatch_epoch.advance ();
 
   std::for_each (threads.begin (), threads.end (), [] (std::thread &thread) { thread.join (); });
 }
@@ -39,46 +59,315 @@ void thread_pool::run_thread (unsigned int thread_id)
 
   while (!finalize_pool)
   {
-    std::unique_lock guard (lock);
-    cv.wait (guard, [&] {
-      return epoch != thread_epoch || finalize_pool;
-    });
-    guard.unlock ();
+    dispatch_waiters[thread_id].wait (dispatch_epoch, thread_epoch);
 
     if (finalize_pool)
       return;
 
     thread_epoch++;
-    action (thread_id, total_threads);
-    barrier ();
+
+    const std::uint64_t action_begin = telemetry_enabled ? read_tsc () : 0;
+    action_invoker (action, thread_id, total_threads);
+    if (telemetry_enabled)
+      telemetry[thread_id].value.action_ticks += read_tsc () - action_begin;
+
+    pool_barrier (thread_id);
+    workers_departures.fetch_add (1u, std::memory_order_release);
   }
 }
 
-void thread_pool::execute (const std::function<void(unsigned int, unsigned int)> &action_arg)
+void thread_pool::dispatch (action_invoker_type invoker, const void *action_arg)
+{
+  /// Workers read the action only after the epoch advance and stop using it before
+  /// execute's barrier, so the pointer to caller's stack stays valid
+  action_invoker = invoker;
+  action = action_arg;
+  dispatches_count++;
+  dispatch_epoch.advance ();
+}
+
+/**
+ * Main thread leaves execute's last barrier as soon as it's released, while workers might still
+ * be releasing nodes of the tree barrier or returning from waits on barriers epochs. Barriers and
+ * waiters can't be replaced until workers leave them.
+ */
+void thread_pool::wait_for_workers () const
+{
+  const std::uint64_t expected_departures = dispatches_count * (total_threads - 1);
+  while (workers_departures.load (std::memory_order_acquire) != expected_departures)
+    std::this_thread::yield ();
+}
+
+void thread_pool::pool_barrier (unsigned int thread_id)
 {
+  if (active_barrier_type == barrier_type::combining_tree)
+    threads_tree_barrier->wait (thread_id);
+  else
+    threads_barrier.wait (thread_id);
+}
+
+void thread_pool::barrier (unsigned int thread_id)
+{
+  barrier (thread_id, empty_arrival_callback {});
+}
+
+thread_pool::thread_team::thread_team (
+    std::string name_arg,
+    unsigned int first_thread_arg,
+    unsigned int threads_count_arg)
+  : name (std::move (name_arg))
+  , first_thread (first_thread_arg)
+  , threads_count (threads_count_arg)
+  , threads_barrier (threads_count_arg)
+{ }
+
+bool thread_pool::set_teams (const std::vector<thread_team_size> &teams_sizes)
+{
+  unsigned int teams_threads = 0;
+  for (auto &team_size: teams_sizes)
+  {
+    if (team_size.threads_count == 0)
+      return true;
+    teams_threads += team_size.threads_count;
+  }
+
+  if (teams_threads != total_threads)
+    return true;
+
+  wait_for_workers ();
+  teams.clear ();
+  threads_teams.clear ();
+
+  for (auto &team_size: teams_sizes)
   {
-    std::lock_guard guard (lock);
-    action = action_arg;
-    epoch++;
+    teams.push_back (std::make_unique<thread_team> (team_size.name, threads_teams.size (), team_size.threads_count));
+    teams.back ()->threads_barrier.set_idle_policy (threads_idle_policy);
+    apply_barrier_type (*teams.back ());
+    threads_teams.resize (threads_teams.size () + team_size.threads_count, teams.size () - 1);
   }
-  cv.notify_all ();
 
-  action (0, total_threads);
-  barrier ();
+  /// Threads of a new team might have made different number of team calls before
+  progress.reset (new cache_padded_progress[total_threads]);
+  for (unsigned int thread_id = 0; thread_id < total_threads; thread_id++)
+  {
+    tiles[thread_id].range.store (0);
+    tiles[thread_id].generation = 0;
+    reductions_count[thread_id].value = 0;
+  }
+
+  return false;
 }
 
-void thread_pool::barrier ()
+unsigned int thread_pool::find_team (const std::string &name) const
 {
-  const unsigned int thread_epoch = barrier_epoch.load ();
+  for (unsigned int team_id = 0; team_id < teams.size (); team_id++)
+    if (teams[team_id]->name == name)
+      return team_id;
+  return teams.size ();
+}
 
-  if (threads_in_barrier.fetch_add (1u) == total_threads - 1)
+void thread_pool::neighbours_sync (unsigned int thread_id, unsigned int work_size, unsigned int halo_size)
+{
+  const thread_team &team = team_of (thread_id);
+  if (team.threads_count == 1)
+    return;
+
+  if (policy == scheduling_policy::work_stealing || work_size / team.threads_count < halo_size)
   {
-    threads_in_barrier.store (0);
-    barrier_epoch.fetch_add (1u);
+    barrier (thread_id);
+    return;
   }
-  else
+
+  /// Only owner advances its epoch, so it's also the count of thread's phases
+  progress[thread_id].epoch.advance ();
+  const unsigned int thread_phase = progress[thread_id].epoch.load ();
+  const unsigned int team_thread_id = thread_id - team.first_thread;
+  const std::uint64_t wait_begin = telemetry_enabled ? read_tsc () : 0;
+
+  for (unsigned int team_neighbour: { (team_thread_id + team.threads_count - 1) % team.threads_count,
+                                      (team_thread_id + 1) % team.threads_count })
   {
-    while (thread_epoch == barrier_epoch.load ())
-      _mm_pause ();
+    parking_epoch &neighbour_epoch = progress[team.first_thread + team_neighbour].epoch;
+
+    for (unsigned int neighbour_phase = neighbour_epoch.load ();
+         static_cast<int> (neighbour_phase - thread_phase) < 0;
+         neighbour_phase = neighbour_epoch.load ())
+      progress_waiters[thread_id].wait (neighbour_epoch, neighbour_phase);
   }
-}
\ No newline at end of file
+
+  if (telemetry_enabled)
+    count_barrier_episode (thread_id, wait_begin);
+}
+
+void thread_pool::reset_telemetry ()
+{
+  for (unsigned int thread_id = 0; thread_id < total_threads; thread_id++)
+    telemetry[thread_id].value = thread_telemetry {};
+}
+
+void thread_pool::set_idle_policy (const idle_policy &policy_arg)
+{
+  wait_for_workers ();
+  threads_idle_policy = policy_arg;
+
+  for (unsigned int thread_id = 0; thread_id < total_threads; thread_id++)
+  {
+    dispatch_waiters[thread_id].set_policy (threads_idle_policy);
+    progress_waiters[thread_id].set_policy (threads_idle_policy);
+  }
+
+  threads_barrier.set_idle_policy (threads_idle_policy);
+  if (threads_tree_barrier)
+    threads_tree_barrier->set_idle_policy (threads_idle_policy);
+
+  for (auto &team: teams)
+  {
+    team->threads_barrier.set_idle_policy (threads_idle_policy);
+    if (team->threads_tree_barrier)
+      team->threads_tree_barrier->set_idle_policy (threads_idle_policy);
+  }
+}
+
+bool thread_pool::pin_threads ()
+{
+  std::atomic<bool> error (false);
+
+#ifdef __linux__
+  execute ([&] (unsigned int thread_id, unsigned int) {
+    cpu_set_t mask;
+    CPU_ZERO (&mask);
+    CPU_SET (threads_cpus[thread_id], &mask);
+
+    if (pthread_setaffinity_np (pthread_self (), sizeof (mask), &mask))
+      error = true;
+  });
+#else
+  error = true;
+#endif
+
+  return error;
+}
+
+unsigned int thread_pool::get_reduction_root (unsigned int thread_id) const
+{
+  const thread_team &team = team_of (thread_id);
+
+  if (active_barrier_type == barrier_type::combining_tree)
+    return team.threads_tree_barrier->get_root_thread ();
+  return team.threads_barrier.get_root_thread ();
+}
+
+void thread_pool::apply_barrier_type (thread_team &team) const
+{
+  if (active_barrier_type != barrier_type::combining_tree)
+    return;
+
+  const auto team_numa_nodes_begin = threads_numa_nodes.begin () + team.first_thread;
+  const std::vector<unsigned int> team_numa_nodes (team_numa_nodes_begin, team_numa_nodes_begin + team.threads_count);
+
+  team.threads_tree_barrier = std::make_unique<combining_tree_barrier> (team_numa_nodes, tree_barrier_fan_in);
+  team.threads_tree_barrier->set_idle_policy (threads_idle_policy);
+}
+
+void thread_pool::set_barrier_type (barrier_type type, unsigned int fan_in)
+{
+  wait_for_workers ();
+  active_barrier_type = type;
+  tree_barrier_fan_in = fan_in;
+
+  if (type == barrier_type::combining_tree)
+  {
+    threads_tree_barrier = std::make_unique<combining_tree_barrier> (threads_numa_nodes, fan_in);
+    threads_tree_barrier->set_idle_policy (threads_idle_policy);
+  }
+
+  for (auto &team: teams)
+    apply_barrier_type (*team);
+}
+
+void thread_pool::set_scheduling_policy (scheduling_policy policy_arg, unsigned int tile_size_arg)
+{
+  policy = policy_arg;
+  tile_size = std::max (1u, tile_size_arg);
+}
+
+/**
+ * Tiles range is packed into one word with the generation of for_each_chunk call that
+ * pushed it. Owner and thieves shrink the range with a single CAS and thieves never
+ * take tiles that belong to another call.
+ */
+static std::uint64_t pack_tiles_range (unsigned int generation, unsigned int begin, unsigned int end)
+{
+  return static_cast<std::uint64_t> (generation & 0xffffu) << 48u
+       | static_cast<std::uint64_t> (begin) << 24u
+       | end;
+}
+
+static unsigned int get_tiles_range_generation (std::uint64_t range) { return range >> 48u; }
+static unsigned int get_tiles_range_begin (std::uint64_t range) { return (range >> 24u) & 0xffffffu; }
+static unsigned int get_tiles_range_end (std::uint64_t range) { return range & 0xffffffu; }
+
+void thread_pool::push_tiles (unsigned int thread_id, const work_range &thread_tiles)
+{
+  auto &thread_tiles_range = tiles[thread_id];
+  thread_tiles_range.generation++;
+  thread_tiles_range.range.store (
+    pack_tiles_range (thread_tiles_range.generation, thread_tiles.chunk_begin, thread_tiles.chunk_end),
+    std::memory_order_release);
+}
+
+bool thread_pool::pop_tile (unsigned int thread_id, unsigned int &tile)
+{
+  auto &range = tiles[thread_id].range;
+  std::uint64_t current = range.load (std::memory_order_acquire);
+
+  while (true)
+  {
+    const unsigned int generation = get_tiles_range_generation (current);
+    const unsigned int begin = get_tiles_range_begin (current);
+    const unsigned int end = get_tiles_range_end (current);
+
+    if (begin >= end)
+      return false;
+
+    if (range.compare_exchange_weak (current, pack_tiles_range (generation, begin + 1, end), std::memory_order_acq_rel))
+    {
+      tile = begin;
+      return true;
+    }
+  }
+}
+
+bool thread_pool::steal_tiles (unsigned int thread_id)
+{
+  auto &thread_tiles_range = tiles[thread_id];
+  const unsigned int thread_generation = thread_tiles_range.generation & 0xffffu;
+  const thread_team &team = team_of (thread_id);
+  const unsigned int team_thread_id = thread_id - team.first_thread;
+
+  /// Deque of the thread is empty here, so other threads don't touch it until we store stolen tiles
+  for (unsigned int offset = 1; offset < team.threads_count; offset++)
+  {
+    auto &range = tiles[team.first_thread + (team_thread_id + offset) % team.threads_count].range;
+    std::uint64_t current = range.load (std::memory_order_acquire);
+
+    while (true)
+    {
+      const unsigned int generation = get_tiles_range_generation (current);
+      const unsigned int begin = get_tiles_range_begin (current);
+      const unsigned int end = get_tiles_range_end (current);
+
+      if (generation != thread_generation || begin >= end)
+        break;
+
+      const unsigned int middle = begin + (end - begin) / 2;
+      if (range.compare_exchange_weak (current, pack_tiles_range (generation, begin, middle), std::memory_order_acq_rel))
+      {
+        thread_tiles_range.range.store (pack_tiles_range (generation, middle, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
@@ -30,7 +30,7 @@ __global__ void euler_2d_calculate_dt_gpu_kernel (
   const unsigned int first_cell_id = blockDim.x * blockIdx.x + threadIdx.x;
   const unsigned int stride = blockDim.x * gridDim.x;
 
-  float_type min_len = std::numeric_limits<float_type>::max ();
+  float_type min_len = geometry.get_min_spacing ();
   float_type max_speed = std::numeric_limits<float_type>::min ();
 
   for (unsigned int cell_id = first_cell_id; cell_id < topology.get_cells_count (); cell_id += stride)
@@ -43,13 +43,6 @@ __global__ void euler_2d_calculate_dt_gpu_kernel (
 
       max_speed = fmaxf (max_speed, fmaxf (fabsf (u + a), fabsf (u - a)));
       max_speed = fmaxf (max_speed, fmaxf (fabsf (v + a), fabsf (v - a)));
-
-      for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
-      {
-        const float_type edge_len = geometry.get_edge_area (cell_id, edge_id);
-        if (edge_len < min_len)
-          min_len = edge_len;
-      }
     }
 
   min_len   = block_reduce <float_type, reduce_operation::min, warps_count> (min_len);
@@ -0,0 +1,151 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/grid/amr_hierarchy.h"
+
+#include <algorithm>
+
+static const int sides_offsets[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+
+void amr_hierarchy::initialize (unsigned int base_nx_arg, unsigned int base_ny_arg, unsigned int max_level_arg)
+{
+  base_nx = base_nx_arg;
+  base_ny = base_ny_arg;
+  max_level = max_level_arg;
+
+  patches.clear ();
+  free_children_blocks.clear ();
+
+  for (unsigned int y = 0; y < base_ny; y++)
+    for (unsigned int x = 0; x < base_nx; x++)
+      patches.push_back ({ 0, x, y, no_patch, no_patch });
+
+  update_leaves ();
+}
+
+unsigned int amr_hierarchy::find_patch (unsigned int level, int x, int y) const
+{
+  const int level_nx = get_level_nx (level);
+  const int level_ny = get_level_ny (level);
+  const unsigned int px = ((x % level_nx) + level_nx) % level_nx;
+  const unsigned int py = ((y % level_ny) + level_ny) % level_ny;
+
+  unsigned int patch_id = (py >> level) * base_nx + (px >> level);
+
+  for (unsigned int patch_level = 1; patch_level <= level && !patches[patch_id].is_leaf (); patch_level++)
+  {
+    const unsigned int shift = level - patch_level;
+    const unsigned int child = ((px >> shift) & 1u) + 2 * ((py >> shift) & 1u);
+    patch_id = patches[patch_id].first_child + child;
+  }
+
+  return patch_id;
+}
+
+unsigned int amr_hierarchy::allocate_children (unsigned int parent_id)
+{
+  unsigned int first_child = patches.size ();
+
+  if (free_children_blocks.empty ())
+    patches.resize (patches.size () + 4);
+  else
+  {
+    first_child = free_children_blocks.back ();
+    free_children_blocks.pop_back ();
+  }
+
+  const patch parent = patches[parent_id];
+  for (unsigned int child = 0; child < 4; child++)
+    patches[first_child + child] = { parent.level + 1, 2 * parent.x + child % 2, 2 * parent.y + child / 2, parent_id, no_patch };
+
+  return first_child;
+}
+
+bool amr_hierarchy::refine (unsigned int patch_id, std::vector<unsigned int> &refined)
+{
+  if (!patches[patch_id].is_leaf () || patches[patch_id].level >= max_level)
+    return true;
+
+  const unsigned int level = patches[patch_id].level;
+
+  /// Children will border patches of the patch level, so coarser neighbours are split first
+  for (auto &offset: sides_offsets)
+  {
+    const unsigned int neighbour_id = find_patch (level, patches[patch_id].x + offset[0], patches[patch_id].y + offset[1]);
+    if (patches[neighbour_id].level < level)
+      refine (neighbour_id, refined);
+  }
+
+  const unsigned int first_child = allocate_children (patch_id);
+  patches[patch_id].first_child = first_child;
+  refined.push_back (patch_id);
+
+  update_leaves ();
+  return false;
+}
+
+bool amr_hierarchy::can_coarsen (unsigned int patch_id) const
+{
+  const patch &parent = patches[patch_id];
+  if (parent.is_leaf ())
+    return false;
+
+  for (unsigned int child = 0; child < 4; child++)
+    if (!patches[parent.first_child + child].is_leaf ())
+      return false;
+
+  /// Neighbours of children positions must be leaves, otherwise they'd be two levels finer than the parent
+  for (unsigned int child = 0; child < 4; child++)
+  {
+    const patch &child_patch = patches[parent.first_child + child];
+
+    for (auto &offset: sides_offsets)
+    {
+      const unsigned int neighbour_id = find_patch (child_patch.level, child_patch.x + offset[0], child_patch.y + offset[1]);
+      if (patches[neighbour_id].level == child_patch.level && !patches[neighbour_id].is_leaf ())
+        return false;
+    }
+  }
+
+  return true;
+}
+
+void amr_hierarchy::coarsen (unsigned int patch_id)
+{
+  free_children_blocks.push_back (patches[patch_id].first_child);
+  patches[patch_id].first_child = no_patch;
+  update_leaves ();
+}
+
+unsigned int amr_hierarchy::get_finest_level () const
+{
+  unsigned int finest_level = 0;
+  for (auto &leaf: leaves)
+    finest_level = std::max (finest_level, patches[leaf].level);
+  return finest_level;
+}
+
+void amr_hierarchy::update_leaves ()
+{
+  leaves.clear ();
+
+  std::vector<unsigned int> stack;
+  for (unsigned int base_patch = base_nx * base_ny; base_patch > 0; base_patch--)
+    stack.push_back (base_patch - 1);
+
+  while (!stack.empty ())
+  {
+    const unsigned int patch_id = stack.back ();
+    stack.pop_back ();
+
+    if (patches[patch_id].is_leaf ())
+    {
+      leaves.push_back (patch_id);
+      continue;
+    }
+
+    for (unsigned int child = 4; child > 0; child--)
+      stack.push_back (patches[patch_id].first_child + child - 1);
+  }
+}
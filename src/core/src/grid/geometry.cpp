@@ -46,6 +46,15 @@ void geometry_representation::append_pixel (const point &left_bottom_corner, con
   append_vertex (left_bottom_corner + sizes_set (sizes.width, sizes.height));
 }
 
+void geometry_representation::append_quad (const point &a, const point &b, const point &c, const point &d)
+{
+  for (auto &v: { &a, &b, &c, &d })
+  {
+    update_boundary (*v);
+    append_vertex (*v);
+  }
+}
+
 void geometry_representation::update_boundary (const point &corner)
 {
   for (unsigned int idx = 0; idx < point::size; idx++)
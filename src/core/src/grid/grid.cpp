@@ -3,8 +3,222 @@
 //
 
 #include "core/grid/grid.h"
+#include "core/grid/unstructured_mesh.h"
+
+#include <iostream>
+#include <numeric>
+
+/// Converts sizes of cells along an axis into single precision sizes and centers
+static void fill_segments (const std::vector<double> &sizes, std::vector<float> &sizes_out, std::vector<float> &centers_out)
+{
+  double offset = 0.0;
+
+  for (auto size: sizes)
+  {
+    sizes_out.push_back (static_cast<float> (size));
+    centers_out.push_back (static_cast<float> (offset + size / 2));
+    offset += size;
+  }
+}
+
+grid::grid (
+    workspace &workspace_arg,
+    const std::vector<double> &columns_widths_arg,
+    const std::vector<double> &rows_heights_arg,
+    cells_layout layout,
+    unsigned int tile_size)
+  : nx (columns_widths_arg.size ())
+  , ny (rows_heights_arg.size ())
+  , size (nx * ny)
+  , width (std::accumulate (columns_widths_arg.begin (), columns_widths_arg.end (), 0.0))
+  , height (std::accumulate (rows_heights_arg.begin (), rows_heights_arg.end (), 0.0))
+  , dx (width / nx)
+  , dy (height / ny)
+  , solver_workspace (workspace_arg)
+{
+  initialize_cells_order (layout, tile_size);
+
+  fill_segments (columns_widths_arg, columns_widths, columns_centers);
+  fill_segments (rows_heights_arg, rows_heights, rows_centers);
+  update_invariants ();
+}
+
+static boundary_box get_mesh_boundary_box (const unstructured_mesh &mesh)
+{
+  boundary_box box;
+
+  for (unsigned int cell_id = 0; cell_id < mesh.get_cells_count (); cell_id++)
+  {
+    for (unsigned int vertex_id = 0; vertex_id < mesh.get_cell_vertices_count (cell_id); vertex_id++)
+    {
+      const unsigned int vertex = mesh.get_cell_vertex (cell_id, vertex_id);
+      const float x = mesh.get_vertex_x (vertex);
+      const float y = mesh.get_vertex_y (vertex);
+      const bool first = cell_id == 0 && vertex_id == 0;
+
+      box.left_bottom_corner.x = first ? x : std::min (box.left_bottom_corner.x, x);
+      box.left_bottom_corner.y = first ? y : std::min (box.left_bottom_corner.y, y);
+      box.right_top_corner.x = first ? x : std::max (box.right_top_corner.x, x);
+      box.right_top_corner.y = first ? y : std::max (box.right_top_corner.y, y);
+    }
+  }
+
+  return box;
+}
+
+grid::grid (workspace &workspace_arg, const unstructured_mesh &mesh_arg)
+  : nx (mesh_arg.get_cells_count ())
+  , ny (1)
+  , size (nx)
+  , width (get_mesh_boundary_box (mesh_arg).width ())
+  , height (get_mesh_boundary_box (mesh_arg).height ())
+  , dx (width / nx)
+  , dy (height)
+  , mesh (&mesh_arg)
+  , solver_workspace (workspace_arg)
+{
+  cells_order.initialize (nx, ny, cells_layout::row_major, 0);
+  update_invariants ();
+}
+
+grid_topology grid::gen_unstructured_topology_wrapper () const
+{
+  return mesh->gen_topology_wrapper ();
+}
+
+grid_geometry grid::gen_unstructured_geometry_wrapper () const
+{
+  return mesh->gen_geometry_wrapper ();
+}
+
+void grid::initialize_cells_order (cells_layout layout, unsigned int tile_size)
+{
+  cells_order.initialize (nx, ny, layout, tile_size);
+
+  if (!cells_order.needs_morton_permutation ())
+    return;
+
+  morton_cell_ids.resize (size);
+  morton_row_major_ids.resize (size);
+  cells_order.fill_morton_permutation (morton_cell_ids.data (), morton_row_major_ids.data ());
+  cells_order.set_morton_permutation (morton_cell_ids.data (), morton_row_major_ids.data ());
+}
+
+/// Replaces periodic side of the pair with condition of the opposite side if only one of them is periodic
+static void pair_periodic_sides (boundary_type &first, boundary_type &second, const char *pair_name)
+{
+  if ((first == boundary_type::periodic) == (second == boundary_type::periodic))
+    return;
+
+  std::cerr << "Periodic boundary on only one of " << pair_name << " sides, the other condition is used on both" << std::endl;
+  first = second = first == boundary_type::periodic ? second : first;
+}
+
+void grid::set_boundary_conditions (boundary_type left, boundary_type bottom, boundary_type right, boundary_type top)
+{
+  pair_periodic_sides (left, right, "left and right");
+  pair_periodic_sides (bottom, top, "bottom and top");
+
+  boundary_conditions[side_to_id (side_type::left)] = left;
+  boundary_conditions[side_to_id (side_type::bottom)] = bottom;
+  boundary_conditions[side_to_id (side_type::right)] = right;
+  boundary_conditions[side_to_id (side_type::top)] = top;
+}
+
+void grid::update_invariants ()
+{
+  boundary_cells.clear ();
+
+  if (mesh)
+  {
+    const grid_topology topology = mesh->gen_topology_wrapper ();
+
+    min_spacing = mesh->get_min_spacing ();
+    total_volume = 0.0;
+
+    for (unsigned int cell_id = 0; cell_id < size; cell_id++)
+    {
+      total_volume += mesh->get_cell_volume (cell_id);
+
+      /// Boundary faces of the mesh reference their own cell
+      for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
+      {
+        if (topology.get_neighbor_id (cell_id, edge_id) == cell_id)
+        {
+          boundary_cells.push_back (cell_id);
+          break;
+        }
+      }
+    }
+
+    return;
+  }
+
+  min_spacing = std::min (static_cast<float> (dx), static_cast<float> (dy));
+  for (auto column_width: columns_widths)
+    min_spacing = std::min (min_spacing, column_width);
+  for (auto row_height: rows_heights)
+    min_spacing = std::min (min_spacing, row_height);
+
+  total_volume = width * height;
+
+  for (unsigned int cell_id = 0; cell_id < size; cell_id++)
+  {
+    unsigned int x {}, y {};
+    cells_order.get_cell_coordinates (cell_id, x, y);
+
+    if (x == 0 || y == 0 || x == nx - 1 || y == ny - 1)
+      boundary_cells.push_back (cell_id);
+  }
+}
+
+void grid::build_gl_representation () const
+{
+  gl_representation = std::make_unique<geometry_representation> (geometry_element_type::quad, size);
+
+  if (mesh)
+  {
+    /// Triangles are drawn as quads with the last vertex repeated
+    for (unsigned int cell_id = 0; cell_id < size; cell_id++)
+    {
+      point vertices[4];
+      const unsigned int vertices_count = mesh->get_cell_vertices_count (cell_id);
+
+      for (unsigned int vertex_id = 0; vertex_id < 4; vertex_id++)
+      {
+        const unsigned int vertex = mesh->get_cell_vertex (cell_id, std::min (vertex_id, vertices_count - 1));
+        vertices[vertex_id].x = mesh->get_vertex_x (vertex);
+        vertices[vertex_id].y = mesh->get_vertex_y (vertex);
+      }
+
+      gl_representation->append_quad (vertices[0], vertices[1], vertices[2], vertices[3]);
+    }
+
+    return;
+  }
+
+  const auto dxf = static_cast<float> (dx);
+  const auto dyf = static_cast<float> (dy);
+
+  /// Elements follow cells order of fields, so extractors map field values to elements directly
+  for (unsigned int cell_id = 0; cell_id < size; cell_id++)
+  {
+    unsigned int i {}, j {};
+    cells_order.get_cell_coordinates (cell_id, i, j);
+
+    if (is_rectilinear ())
+      gl_representation->append_pixel (
+          point (columns_centers[i] - columns_widths[i] / 2, rows_centers[j] - rows_heights[j] / 2),
+          sizes_set (columns_widths[i], rows_heights[j]));
+    else
+      gl_representation->append_pixel (
+          point (dxf * static_cast<float> (i), dyf * static_cast<float> (j)),
+          sizes_set (dxf, dyf));
+  }
+}
 
 const geometry_representation &grid::get_gl_representation () const
 {
-  return gl_representation;
+  std::call_once (gl_representation_flag, [this] { build_gl_representation (); });
+  return *gl_representation;
 }
@@ -0,0 +1,288 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "core/grid/unstructured_mesh.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+bool unstructured_mesh::build (
+    std::vector<float> vertices_x_arg,
+    std::vector<float> vertices_y_arg,
+    std::vector<unsigned int> cells_offsets_arg,
+    std::vector<unsigned int> cells_vertices_arg)
+{
+  if (vertices_x_arg.size () != vertices_y_arg.size ()
+   || cells_offsets_arg.empty ()
+   || cells_offsets_arg.front () != 0
+   || cells_offsets_arg.back () != cells_vertices_arg.size ())
+    return true;
+
+  const unsigned int cells_count = cells_offsets_arg.size () - 1;
+  const unsigned int faces_count = cells_vertices_arg.size ();
+
+  std::vector<float> volumes (cells_count);
+  std::vector<float> centers_x (cells_count);
+  std::vector<float> centers_y (cells_count);
+  std::vector<unsigned int> faces_cells (faces_count);
+
+  for (unsigned int cell_id = 0; cell_id < cells_count; cell_id++)
+  {
+    const unsigned int begin = cells_offsets_arg[cell_id];
+    const unsigned int end = cells_offsets_arg[cell_id + 1];
+
+    if (end < begin || end - begin < 3 || end - begin > 4)
+      return true;
+
+    double signed_area = 0.0;
+    double center_x = 0.0;
+    double center_y = 0.0;
+
+    for (unsigned int face_id = begin; face_id < end; face_id++)
+    {
+      const unsigned int a = cells_vertices_arg[face_id];
+      const unsigned int b = cells_vertices_arg[face_id + 1 == end ? begin : face_id + 1];
+
+      if (a >= vertices_x_arg.size () || b >= vertices_x_arg.size ())
+        return true;
+
+      signed_area += 0.5 * (static_cast<double> (vertices_x_arg[a]) * vertices_y_arg[b]
+                          - static_cast<double> (vertices_x_arg[b]) * vertices_y_arg[a]);
+      center_x += vertices_x_arg[a];
+      center_y += vertices_y_arg[a];
+      faces_cells[face_id] = cell_id;
+    }
+
+    if (signed_area == 0.0)
+      return true;
+
+    /// Outward normals below rely on counterclockwise vertices
+    if (signed_area < 0.0)
+      std::reverse (cells_vertices_arg.begin () + begin, cells_vertices_arg.begin () + end);
+
+    volumes[cell_id] = std::abs (signed_area);
+    centers_x[cell_id] = center_x / (end - begin);
+    centers_y[cell_id] = center_y / (end - begin);
+  }
+
+  std::vector<float> normals_x (faces_count);
+  std::vector<float> normals_y (faces_count);
+  std::vector<float> areas (faces_count);
+
+  /// Faces with the same pair of vertices are neighbours, they become adjacent after sort
+  struct face_key
+  {
+    std::uint64_t vertices;
+    unsigned int face_id;
+  };
+
+  std::vector<face_key> keys (faces_count);
+
+  for (unsigned int cell_id = 0; cell_id < cells_count; cell_id++)
+  {
+    const unsigned int begin = cells_offsets_arg[cell_id];
+    const unsigned int end = cells_offsets_arg[cell_id + 1];
+
+    for (unsigned int face_id = begin; face_id < end; face_id++)
+    {
+      const unsigned int a = cells_vertices_arg[face_id];
+      const unsigned int b = cells_vertices_arg[face_id + 1 == end ? begin : face_id + 1];
+
+      const float dx = vertices_x_arg[b] - vertices_x_arg[a];
+      const float dy = vertices_y_arg[b] - vertices_y_arg[a];
+      const float length = std::hypot (dx, dy);
+
+      if (length == 0.0f)
+        return true;
+
+      normals_x[face_id] = dy / length;
+      normals_y[face_id] = -dx / length;
+      areas[face_id] = length;
+
+      keys[face_id].vertices = (static_cast<std::uint64_t> (std::min (a, b)) << 32) | std::max (a, b);
+      keys[face_id].face_id = face_id;
+    }
+  }
+
+  std::sort (keys.begin (), keys.end (), [] (const face_key &lhs, const face_key &rhs) {
+    return lhs.vertices < rhs.vertices;
+  });
+
+  std::vector<unsigned int> neighbors (faces_count);
+  unsigned int max_distance = 0;
+
+  for (unsigned int key_id = 0; key_id < faces_count;)
+  {
+    const unsigned int face_id = keys[key_id].face_id;
+
+    if (key_id + 1 < faces_count && keys[key_id + 1].vertices == keys[key_id].vertices)
+    {
+      /// Faces shared by more than two cells
+      if (key_id + 2 < faces_count && keys[key_id + 2].vertices == keys[key_id].vertices)
+        return true;
+
+      const unsigned int neighbor_face_id = keys[key_id + 1].face_id;
+      const unsigned int cell_id = faces_cells[face_id];
+      const unsigned int neighbor_id = faces_cells[neighbor_face_id];
+
+      neighbors[face_id] = neighbor_id;
+      neighbors[neighbor_face_id] = cell_id;
+      max_distance = std::max (max_distance, cell_id > neighbor_id ? cell_id - neighbor_id : neighbor_id - cell_id);
+      key_id += 2;
+    }
+    else
+    {
+      neighbors[face_id] = faces_cells[face_id];
+      key_id++;
+    }
+  }
+
+  vertices_x = std::move (vertices_x_arg);
+  vertices_y = std::move (vertices_y_arg);
+  cells_offsets = std::move (cells_offsets_arg);
+  cells_vertices = std::move (cells_vertices_arg);
+
+  faces_neighbors = std::move (neighbors);
+  faces_normals_x = std::move (normals_x);
+  faces_normals_y = std::move (normals_y);
+  faces_areas = std::move (areas);
+
+  cells_volumes = std::move (volumes);
+  cells_centers_x = std::move (centers_x);
+  cells_centers_y = std::move (centers_y);
+
+  bandwidth = max_distance;
+  min_spacing = faces_areas.empty () ? 0.0f : *std::min_element (faces_areas.begin (), faces_areas.end ());
+  return false;
+}
+
+std::vector<unsigned int> unstructured_mesh::get_rcm_order () const
+{
+  const unsigned int cells_count = get_cells_count ();
+
+  auto get_degree = [&] (unsigned int cell_id) {
+    unsigned int degree = 0;
+    for (unsigned int face_id = cells_offsets[cell_id]; face_id < cells_offsets[cell_id + 1]; face_id++)
+      if (faces_neighbors[face_id] != cell_id)
+        degree++;
+    return degree;
+  };
+
+  std::vector<unsigned int> order;
+  order.reserve (cells_count);
+
+  std::vector<bool> ordered (cells_count, false);
+  std::vector<unsigned int> seen_from (cells_count, cells_count);
+  std::vector<unsigned int> queue;
+  std::vector<unsigned int> neighbors;
+
+  for (unsigned int seed = 0; seed < cells_count; seed++)
+  {
+    if (ordered[seed])
+      continue;
+
+    /// Breadth-first levels of the part from seed, root is taken from the last level
+    queue.assign (1, seed);
+    seen_from[seed] = seed;
+
+    std::size_t last_level_begin = 0;
+    for (std::size_t head = 0; head < queue.size ();)
+    {
+      last_level_begin = head;
+      const std::size_t level_end = queue.size ();
+
+      for (; head < level_end; head++)
+      {
+        const unsigned int cell_id = queue[head];
+        for (unsigned int face_id = cells_offsets[cell_id]; face_id < cells_offsets[cell_id + 1]; face_id++)
+        {
+          const unsigned int neighbor_id = faces_neighbors[face_id];
+          if (seen_from[neighbor_id] != seed)
+          {
+            seen_from[neighbor_id] = seed;
+            queue.push_back (neighbor_id);
+          }
+        }
+      }
+    }
+
+    unsigned int root = queue[last_level_begin];
+    for (std::size_t i = last_level_begin; i < queue.size (); i++)
+      if (get_degree (queue[i]) < get_degree (root))
+        root = queue[i];
+
+    /// Cuthill-McKee order of the part: breadth-first, neighbours by increasing degree
+    ordered[root] = true;
+    order.push_back (root);
+
+    for (std::size_t head = order.size () - 1; head < order.size (); head++)
+    {
+      const unsigned int cell_id = order[head];
+
+      neighbors.clear ();
+      for (unsigned int face_id = cells_offsets[cell_id]; face_id < cells_offsets[cell_id + 1]; face_id++)
+      {
+        const unsigned int neighbor_id = faces_neighbors[face_id];
+        if (!ordered[neighbor_id])
+        {
+          ordered[neighbor_id] = true;
+          neighbors.push_back (neighbor_id);
+        }
+      }
+
+      std::stable_sort (neighbors.begin (), neighbors.end (), [&] (unsigned int lhs, unsigned int rhs) {
+        return get_degree (lhs) < get_degree (rhs);
+      });
+      order.insert (order.end (), neighbors.begin (), neighbors.end ());
+    }
+  }
+
+  std::reverse (order.begin (), order.end ());
+  return order;
+}
+
+void unstructured_mesh::reorder (const std::vector<unsigned int> &new_to_old)
+{
+  const unsigned int cells_count = get_cells_count ();
+
+  std::vector<unsigned int> new_offsets (cells_count + 1, 0);
+  std::vector<unsigned int> new_vertices;
+  new_vertices.reserve (cells_vertices.size ());
+
+  for (unsigned int cell_id = 0; cell_id < cells_count; cell_id++)
+  {
+    const unsigned int old_cell_id = new_to_old[cell_id];
+    new_vertices.insert (
+        new_vertices.end (),
+        cells_vertices.begin () + cells_offsets[old_cell_id],
+        cells_vertices.begin () + cells_offsets[old_cell_id + 1]);
+    new_offsets[cell_id + 1] = new_vertices.size ();
+  }
+
+  /// Cells were valid, so only faces and neighbours are rebuilt
+  build (std::move (vertices_x), std::move (vertices_y), std::move (new_offsets), std::move (new_vertices));
+}
+
+grid_topology unstructured_mesh::gen_topology_wrapper () const
+{
+  grid_topology topology;
+  topology.initialize_for_unstructured_mesh (get_cells_count (), cells_offsets.data (), faces_neighbors.data (), bandwidth);
+  return topology;
+}
+
+grid_geometry unstructured_mesh::gen_geometry_wrapper () const
+{
+  grid_geometry geometry;
+  geometry.initialize_for_unstructured_mesh (
+      cells_offsets.data (),
+      faces_normals_x.data (),
+      faces_normals_y.data (),
+      faces_areas.data (),
+      cells_volumes.data (),
+      cells_centers_x.data (),
+      cells_centers_y.data (),
+      min_spacing);
+  return geometry;
+}
@@ -8,10 +8,12 @@
 #include "core/sm/result_extractor.h"
 #include "core/solver/solver.h"
 #include "core/grid/grid.h"
+#include "core/grid/unstructured_mesh.h"
 #include "core/cpu/euler_2d.h"
 #include "core/solver/workspace.h"
 
 #include <iostream>
+#include <vector>
 
 #ifdef PYTHON_BUILD
 #include <pybind11/embed.h>
@@ -28,6 +30,12 @@ project_manager::project_manager (int argc, char *argv[])
 
 project_manager::~project_manager () = default;
 
+void project_manager::set_mesh (std::unique_ptr<unstructured_mesh> mesh_arg)
+{
+  mesh = std::move (mesh_arg);
+  version--;
+}
+
 void project_manager::initialize (
     std::string project_name_arg,
     std::string solver_arg,
@@ -45,6 +53,15 @@ void project_manager::initialize (
       max_simulation_time_arg,
       use_double_precision,
       *solver_workspace);
+  simulation->set_scheduling_policy (threads_scheduling_policy);
+  simulation->set_barrier_type (threads_barrier_type);
+  simulation->set_idle_policy (threads_idle_policy);
+  if (extraction_threads)
+    simulation->set_extraction_threads (extraction_threads);
+  if (pin_threads)
+    simulation->pin_threads ();
+  if (telemetry)
+    simulation->set_telemetry (true);
 
   auto &scheme = *solver_configuration_scheme;
   const auto grid_id = scheme.create_group (scheme.get_root (), "grid");
@@ -52,6 +69,18 @@ void project_manager::initialize (
   scheme.create_node (grid_id, "ny", 10 /* default value */);
   scheme.create_node (grid_id, "width",  1.0 /* default value */);
   scheme.create_node (grid_id, "height", 1.0 /* default value */);
+
+  /// Optional segments of rectilinear grid, each one is a run of equal cells along the axis
+  const auto segment_scheme_id = scheme.create_group ("segment_scheme");
+  scheme.create_node (segment_scheme_id, "length", 1.0 /* default value */);
+  scheme.create_node (segment_scheme_id, "cells", 10 /* default value */);
+  scheme.create_array (grid_id, "x_segments", segment_scheme_id);
+  scheme.create_array (grid_id, "y_segments", segment_scheme_id);
+
+  /// Optional, every side is periodic, mirror or none
+  const auto boundary_conditions_id = scheme.create_group (grid_id, "boundary_conditions");
+  for (auto &side: { "left", "bottom", "right", "top" })
+    scheme.create_node (boundary_conditions_id, side, std::string ("periodic") /* default value */);
   const auto solver_id = scheme.create_group (scheme.get_root (), "solver");
   simulation->fill_configuration_scheme (scheme, solver_id);
 
@@ -101,6 +130,49 @@ py::array_t<data_type> create_py_array (size_t n, void *data_ptr)
 }
 #endif
 
+/// Conditions of left, bottom, right and top sides, unknown names are read as periodic
+static std::vector<boundary_type> read_boundary_conditions (const configuration &config, std::size_t boundary_conditions_id)
+{
+  std::vector<boundary_type> boundary_conditions;
+  for (auto &side_id: config.children_for (boundary_conditions_id))
+  {
+    const std::string name = config.get_node_value (side_id);
+    boundary_type boundary = boundary_type::periodic;
+
+    if (boundary_from_name (name, boundary))
+      std::cerr << "Unknown boundary condition " << name << ", periodic is used" << std::endl;
+
+    boundary_conditions.push_back (boundary);
+  }
+
+  return boundary_conditions;
+}
+
+/**
+ * Sizes of cells along an axis. Segments split the axis into runs of equal cells, without
+ * valid segments the axis has n cells of length / n size.
+ */
+static std::vector<double> read_axis_cells_sizes (const configuration &config, std::size_t segments_id, unsigned int n, double length)
+{
+  std::vector<double> sizes;
+  for (auto &segment_id: config.children_for (segments_id))
+  {
+    const auto segment_params = config.children_for (segment_id);
+    const double segment_length = config.get_node_value (segment_params[0]);
+    const int segment_cells = config.get_node_value (segment_params[1]);
+
+    if (segment_cells <= 0 || segment_length <= 0.0)
+      continue;
+
+    for (int cell = 0; cell < segment_cells; cell++)
+      sizes.push_back (segment_length / segment_cells);
+  }
+
+  if (sizes.empty ())
+    return std::vector<double> (n, length / n);
+  return sizes;
+}
+
 void project_manager::update_project ()
 {
   auto domain = cpp_itt::create_domain ("project_manager");
@@ -120,11 +192,30 @@ void project_manager::update_project ()
     const double width  = config.get_node_value (grid_params[2]);
     const double height = config.get_node_value (grid_params[3]);
 
+    const bool use_segments = !config.children_for (grid_params[4]).empty () || !config.children_for (grid_params[5]).empty ();
+
+    const bool use_mesh = mesh && simulation->is_unstructured_mesh_supported ();
+    if (mesh && !use_mesh)
+      std::cerr << "Solver " << solver_name << " doesn't support unstructured meshes, structured grid is used" << std::endl;
+
+    /// Mesh and rectilinear grid arrays live on host
     if (get_use_gpu ())
-      if (!simulation->is_gpu_supported ())
+      if (!simulation->is_gpu_supported () || use_mesh || use_segments)
         gpu_num = -1;
 
-    solver_grid = std::make_unique<grid> (*solver_workspace, nx, ny, width, height);
+    if (use_mesh)
+      solver_grid = std::make_unique<grid> (*solver_workspace, *mesh);
+    else if (use_segments)
+      solver_grid = std::make_unique<grid> (
+        *solver_workspace,
+        read_axis_cells_sizes (config, grid_params[4], nx, width),
+        read_axis_cells_sizes (config, grid_params[5], ny, height),
+        grid_cells_layout, grid_tile_size);
+    else
+      solver_grid = std::make_unique<grid> (*solver_workspace, nx, ny, width, height, grid_cells_layout, grid_tile_size);
+
+    const auto boundary_conditions = read_boundary_conditions (config, grid_params[6]);
+    solver_grid->set_boundary_conditions (boundary_conditions[0], boundary_conditions[1], boundary_conditions[2], boundary_conditions[3]);
     simulation->apply_configuration (config, config.children_for (config.get_root ()).at (1), solver_grid.get (), gpu_num);
 
 #ifdef PYTHON_BUILD
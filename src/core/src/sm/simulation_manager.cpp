@@ -7,7 +7,9 @@
 #include "core/sm/result_extractor.h"
 #include "core/solver/solver.h"
 #include "core/cpu/euler_2d.h"
+#include "core/cpu/euler_2d_amr.h"
 #include "core/cpu/fdtd_2d.h"
+#include "core/cpu/fdtd_3d.h"
 
 #ifdef VTUNE_BUILD
 #include "cpp_itt.h"
@@ -30,6 +32,17 @@ solver *solver_abstract_method (
       return new euler_2d<float> (threads, workspace_arg);
     }
   }
+  if (solver_arg == "euler_2d_amr")
+  {
+    if (use_double_precision_arg)
+    {
+      return new euler_2d_amr<double> (threads, workspace_arg);
+    }
+    else
+    {
+      return new euler_2d_amr<float> (threads, workspace_arg);
+    }
+  }
   if (solver_arg == "fdtd_2d")
   {
     if (use_double_precision_arg)
@@ -41,6 +54,17 @@ solver *solver_abstract_method (
       return new fdtd_2d<float> (threads, workspace_arg);
     }
   }
+  if (solver_arg == "fdtd_3d")
+  {
+    if (use_double_precision_arg)
+    {
+      return new fdtd_3d<double> (threads, workspace_arg);
+    }
+    else
+    {
+      return new fdtd_3d<float> (threads, workspace_arg);
+    }
+  }
 
   return nullptr;
 }
@@ -89,8 +113,15 @@ void simulation_manager::apply_configuration (
   }
 #endif
 
+  if (gpu_num >= 0 && extraction_threads)
+  {
+    std::cerr << "Extraction threads aren't supported on GPU" << std::endl;
+    set_extraction_threads (0);
+  }
+
   step = 0;
   time = 0.0;
+  snapshot_ready = false;
 
   if (solver_context)
     solver_context->apply_configuration (config, config_id, solver_grid, gpu_num);
@@ -101,12 +132,147 @@ bool simulation_manager::is_gpu_supported () const
   return solver_context->is_gpu_supported ();
 }
 
-void simulation_manager::extract (result_extractor **extractors, unsigned int extractors_count)
+bool simulation_manager::is_unstructured_mesh_supported () const
+{
+  return solver_context->is_unstructured_mesh_supported ();
+}
+
+void simulation_manager::set_scheduling_policy (scheduling_policy policy)
+{
+  threads.set_scheduling_policy (policy);
+}
+
+void simulation_manager::set_barrier_type (barrier_type type)
 {
+  threads.set_barrier_type (type);
+}
+
+void simulation_manager::pin_threads ()
+{
+  if (threads.pin_threads ())
+    std::cerr << "Can't pin threads to CPUs" << std::endl;
+}
+
+void simulation_manager::set_idle_policy (const idle_policy &policy)
+{
+  threads.set_idle_policy (policy);
+}
+
+void simulation_manager::set_extraction_threads (unsigned int threads_count)
+{
+  const unsigned int total_threads = threads.get_threads_count ();
+  const bool use_teams = threads_count > 0 && threads_count < total_threads;
+
+  if (threads_count && !use_teams)
+    std::cerr << "Can't dedicate " << threads_count << " of " << total_threads << " threads to extraction" << std::endl;
+
+  if (use_teams)
+    threads.set_teams ({ { "compute", total_threads - threads_count }, { "extraction", threads_count } });
+  else
+    threads.set_teams ({ { "all", total_threads } });
+
+  extraction_threads = use_teams ? threads_count : 0;
+  snapshot_ready = false;
+
+  if (!extraction_threads)
+    solver_workspace.drop_snapshot ();
+}
+
+void simulation_manager::set_telemetry (bool enable)
+{
+  threads.set_telemetry (enable);
+  threads.reset_telemetry ();
+  steps_telemetry.assign (threads.get_threads_count (), thread_telemetry {});
+}
+
+void simulation_manager::update_imbalance_report (unsigned int steps_count, double tsc_frequency)
+{
+  imbalance_report = threads_imbalance_report {};
+  imbalance_report.steps_count = steps_count;
+
+  if (!steps_count)
+    return;
+
+  /// Extraction team doesn't run steps
+  unsigned int compute_threads = 0;
+  const unsigned int compute_team = threads.get_team_id (get_main_thread ());
+
+  for (unsigned int thread_id = 0; thread_id < threads.get_threads_count (); thread_id++)
+  {
+    if (threads.get_team_id (thread_id) != compute_team)
+      continue;
+
+    const auto &thread_steps_telemetry = steps_telemetry[thread_id];
+    const double compute_time = thread_steps_telemetry.get_compute_ticks () / tsc_frequency / steps_count;
+
+    compute_threads++;
+    imbalance_report.max_compute_time = std::max (imbalance_report.max_compute_time, compute_time);
+    imbalance_report.mean_compute_time += compute_time;
+    imbalance_report.mean_barrier_time += thread_steps_telemetry.barrier_ticks / tsc_frequency / steps_count;
+    imbalance_report.barrier_episodes += static_cast<double> (thread_steps_telemetry.barrier_episodes) / steps_count;
+  }
+
+  imbalance_report.mean_compute_time /= compute_threads;
+  imbalance_report.mean_barrier_time /= compute_threads;
+  imbalance_report.barrier_episodes /= compute_threads;
+}
+
+bool simulation_manager::is_extraction_thread (unsigned int thread_id) const
+{
+  return !extraction_threads || threads.get_team_id (thread_id) == threads.find_team ("extraction");
+}
+
+void simulation_manager::run_extractors (unsigned int thread_id, result_extractor **extractors, unsigned int extractors_count)
+{
+  for (unsigned int eid = 0; eid < extractors_count; eid++)
+    extractors[eid]->extract (thread_id, threads.get_team_threads_count (thread_id), threads);
+}
+
+void simulation_manager::update_results ()
+{
+  if (!solver_context)
+    return;
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int threads_count) {
+    solver_context->update_results (thread_id, threads_count);
+  });
+}
+
+void simulation_manager::update_snapshot ()
+{
+  update_results ();
+
+  if (solver_workspace.prepare_snapshot ())
+  {
+    std::cerr << "Can't allocate results snapshot" << std::endl;
+    return;
+  }
+
   threads.execute ([&] (unsigned int thread_id, unsigned int threads_count) {
-    for (unsigned int eid = 0; eid < extractors_count; eid++)
-      extractors[eid]->extract (thread_id, threads_count, threads);
+    solver_workspace.update_snapshot (thread_id, threads_count);
   });
+
+  snapshot_ready = true;
+}
+
+void simulation_manager::extract_snapshot (result_extractor **extractors, unsigned int extractors_count)
+{
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    if (is_extraction_thread (thread_id))
+      run_extractors (thread_id, extractors, extractors_count);
+  });
+
+  snapshot_ready = false;
+}
+
+void simulation_manager::extract (result_extractor **extractors, unsigned int extractors_count)
+{
+  if (extraction_threads)
+    update_snapshot ();
+  else
+    update_results ();
+
+  extract_snapshot (extractors, extractors_count);
 }
 
 bool simulation_manager::calculate_next_time_step (result_extractor **extractors, unsigned int extractors_count)
@@ -117,36 +283,91 @@ bool simulation_manager::calculate_next_time_step (result_extractor **extractors
   auto domain = cpp_itt::create_domain ("simulation_manager");
 
   const auto calculation_begin = std::chrono::high_resolution_clock::now ();
+  const std::uint64_t calculation_begin_tsc = read_tsc ();
   const unsigned int steps_until_render = 10;
+  unsigned int computed_steps = 0;
 
   solver_workspace.set_active_layer ("rho", 0);
+
+  /// Snapshot of the previous interval is extracted by its team while the steps are computed
+  const bool extract_snapshot_concurrently = extraction_threads && snapshot_ready;
   threads.execute ([&] (unsigned int thread_id, unsigned int threads_count) {
+    if (extraction_threads && is_extraction_thread (thread_id))
+    {
+      auto extract_task = domain.create_task ("extract_snapshot");
+      if (extract_snapshot_concurrently)
+        run_extractors (thread_id, extractors, extractors_count);
+      return;
+    }
+
     double report_time = 0.0;
+    unsigned int local_steps_count = 0;
+
+    const thread_telemetry telemetry_begin = threads.get_telemetry (thread_id);
+    const std::uint64_t steps_begin = threads.is_telemetry_enabled () ? read_tsc () : 0;
 
     {
       auto local_steps = domain.create_task ("local_steps");
       for (unsigned int local_step = 0; local_step < steps_until_render; local_step++)
       {
-        report_time += solver_context->solve (step + local_step, thread_id, threads_count);
+        report_time += solver_context->solve (step + local_step, thread_id, threads.get_team_threads_count (thread_id));
+        local_steps_count++;
         if (time + report_time > max_time)
           break;
       }
     }
 
-    threads.barrier ();
-    time += report_time;
+    threads.barrier (thread_id);
+    if (threads.is_team_leader (thread_id))
+    {
+      time += report_time;
+      computed_steps = local_steps_count;
+    }
 
+    if (threads.is_telemetry_enabled ())
+    {
+      const thread_telemetry &telemetry_end = threads.get_telemetry (thread_id);
+      auto &thread_steps_telemetry = steps_telemetry[thread_id];
+      thread_steps_telemetry.action_ticks = read_tsc () - steps_begin;
+      thread_steps_telemetry.barrier_ticks = telemetry_end.barrier_ticks - telemetry_begin.barrier_ticks;
+      thread_steps_telemetry.barrier_episodes = telemetry_end.barrier_episodes - telemetry_begin.barrier_episodes;
+    }
+
+    if (!extraction_threads)
     {
       auto local_steps = domain.create_task ("extract");
-      for (unsigned int eid = 0; eid < extractors_count; eid++)
-        extractors[eid]->extract (thread_id, threads_count, threads);
+      if (extractors_count)
+      {
+        solver_context->update_results (thread_id, threads_count);
+        threads.barrier (thread_id);
+      }
+      run_extractors (thread_id, extractors, extractors_count);
     }
   });
 
+  if (extraction_threads)
+  {
+    update_snapshot ();
+
+    /// Last interval has nothing to overlap with
+    if (time >= max_time)
+      extract_snapshot (extractors, extractors_count);
+  }
+
   const auto calculation_end = std::chrono::high_resolution_clock::now ();
   const std::chrono::duration<double> duration = calculation_end - calculation_begin;
   std::cout << "Computation of time " << time << " completed in " << duration.count () << "s\n";
 
+  if (threads.is_telemetry_enabled () && duration.count () > 0.0)
+  {
+    update_imbalance_report (computed_steps, (read_tsc () - calculation_begin_tsc) / duration.count ());
+    std::cout << "Threads imbalance " << imbalance_report.get_imbalance ()
+              << " (max/mean compute " << imbalance_report.max_compute_time * 1e6
+              << "/" << imbalance_report.mean_compute_time * 1e6
+              << "us, barriers " << imbalance_report.mean_barrier_time * 1e6
+              << "us, " << imbalance_report.barrier_episodes << " barriers per step)\n";
+  }
+
   step += steps_until_render;
 
   return time < max_time; /// Calculation continuation condition
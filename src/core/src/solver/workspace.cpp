@@ -3,8 +3,16 @@
 //
 
 #include "core/solver/workspace.h"
+#include "core/cpu/thread_pool.h"
 
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #ifdef GPU_BUILD
 #include <cuda_runtime.h>
@@ -30,21 +38,46 @@ protected:
   std::size_t size = 0;
 };
 
+/**
+ * On Linux memory is mapped directly, so pages aren't touched (and placed on
+ * a NUMA node) until solver fills them from its threads. Malloc could return
+ * memory already touched by the main thread.
+ */
 class cpu_memory_object : public memory_object
 {
 public:
   bool allocate (std::size_t bytes) override
   {
-    ptr = malloc (bytes);
     size = bytes;
+
+#ifdef __linux__
+    if (!bytes)
+      return false;
+
+    ptr = mmap (nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+    {
+      ptr = nullptr;
+      return true;
+    }
+#else
+    ptr = malloc (bytes);
+#endif
+
     return false;
   }
 
   bool destroy () override
   {
+#ifdef __linux__
+    if (ptr)
+      munmap (ptr, size);
+#else
     if (ptr)
       free (ptr);
+#endif
 
+    ptr = nullptr;
     return false;
   }
 
@@ -250,3 +283,61 @@ const void *workspace::get_host_copy (const std::string &name) const
 
   return nullptr;
 }
+
+bool workspace::prepare_snapshot ()
+{
+  for (auto it = snapshot.begin (); it != snapshot.end ();)
+    it = storage.count (it->first) ? std::next (it) : snapshot.erase (it);
+
+  for (auto &field: storage)
+  {
+    auto mo = field.second->get_memory_object ();
+    if (mo->get_holder () != memory_holder_type::host)
+      continue;
+
+    auto &copy = snapshot[field.first];
+    if (copy && copy->get_size () == mo->get_size ())
+      continue;
+
+    copy = std::make_unique<cpu_memory_object> ();
+    if (copy->allocate (mo->get_size ()))
+    {
+      snapshot.erase (field.first);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void workspace::update_snapshot (unsigned int thread_id, unsigned int threads_count)
+{
+  for (auto &copy: snapshot)
+  {
+    auto it = storage.find (copy.first);
+    if (it == storage.end ())
+      continue;
+
+    auto source = static_cast<const std::byte *> (it->second->get_active_layer ());
+    auto target = static_cast<std::byte *> (copy.second->get ());
+    const auto range = work_range::split (copy.second->get_size (), thread_id, threads_count);
+
+    if (range.chunk_end > range.chunk_begin)
+      std::memcpy (target + range.chunk_begin, source + range.chunk_begin, range.chunk_end - range.chunk_begin);
+  }
+}
+
+void workspace::drop_snapshot ()
+{
+  snapshot.clear ();
+}
+
+const void *workspace::get_results (const std::string &name) const
+{
+  auto it = snapshot.find (name);
+
+  if (it != snapshot.end ())
+    return it->second->get ();
+
+  return get_host_copy (name);
+}
@@ -0,0 +1,39 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#ifndef ANYSIM_MESH_READER_H
+#define ANYSIM_MESH_READER_H
+
+#include <string>
+#include <memory>
+
+class project_manager;
+class unstructured_mesh;
+
+/**
+ * Reads 2D unstructured mesh from text file:
+ *
+ *   vertices N
+ *   x y                  (N lines)
+ *   cells M
+ *   k v_0 ... v_k-1      (M lines, k is 3 or 4, vertices ids start from 0)
+ *
+ * Cells are renumbered in reverse Cuthill-McKee order, so neighbours stay close in fields.
+ */
+class mesh_reader
+{
+public:
+  mesh_reader () = delete;
+  ~mesh_reader ();
+
+  explicit mesh_reader (const std::string &filename);
+
+  bool initialize_project (project_manager &pm);
+  bool is_valid () { return mesh != nullptr; }
+
+private:
+  std::unique_ptr<unstructured_mesh> mesh;
+};
+
+#endif //ANYSIM_MESH_READER_H
@@ -4,6 +4,7 @@
 
 #include "io/con/con_parser.h"
 #include "io/configuration_reader.h"
+#include "io/mesh_reader.h"
 #include "io/con/argagg/argagg.hpp"
 #include "io/hdf5/hdf5_writer.h"
 #include "core/pm/project_manager.h"
@@ -24,7 +25,19 @@ con_parser::con_parser ()
     { "use_gpu",       {"-g", "--use-gpu" }, "allows simulation manager to use GPU", 0 /* option arguments count */},
     { "gpu_device",    {"-d", "--gpu-dev" }, "specify gpu device number", 1 /* option arguments count */},
     { "configuration", {"-c", "--config"},   "load configuration file for simulation", 1 /* option arguments count */ },
-    { "output",        {"-o", "--output"},   "dump results into file", 1 /* option arguments count */ }
+    { "output",        {"-o", "--output"},   "dump results into file", 1 /* option arguments count */ },
+    { "work_stealing", {"-w", "--work-stealing"}, "balance cells between threads with work stealing", 0 /* option arguments count */ },
+    { "adaptive_split", {"-a", "--adaptive-split"}, "balance cells between threads by measured cost of their slices", 0 /* option arguments count */ },
+    { "tree_barrier",  {"-b", "--tree-barrier"},  "synchronize threads with NUMA-aware combining tree barrier", 0 /* option arguments count */ },
+    { "pin_threads",   {"-p", "--pin-threads"},   "pin threads to CPUs grouped by NUMA node", 0 /* option arguments count */ },
+    { "spin_time",     {"--spin-time"},   "max time in microseconds idle thread spins before yielding", 1 /* option arguments count */ },
+    { "yield_time",    {"--yield-time"},  "time in microseconds idle thread yields before parking", 1 /* option arguments count */ },
+    { "fixed_spin",    {"--fixed-spin"},  "always spin for spin time instead of learning it from previous waits", 0 /* option arguments count */ },
+    { "extraction_threads", {"-e", "--extraction-threads"}, "extract results on own threads while the next steps are computed", 1 /* option arguments count */ },
+    { "telemetry",     {"-t", "--telemetry"},     "report time of threads in computations and barriers", 0 /* option arguments count */ },
+    { "layout",        {"-l", "--layout"},        "cells order in fields: row_major, tiled or morton", 1 /* option arguments count */ },
+    { "tile_size",     {"--tile-size"},           "tile side in cells for tiled layout", 1 /* option arguments count */ },
+    { "mesh",          {"-m", "--mesh"},          "load unstructured mesh instead of structured grid", 1 /* option arguments count */ }
   }};
 }
 
@@ -47,6 +60,51 @@ bool con_parser::parse (int argc, char **argv, bool require_configuration, proje
   if (args["use_gpu"])
     pm.set_gpu_num (0);
 
+  if (args["work_stealing"])
+    pm.set_scheduling_policy (scheduling_policy::work_stealing);
+
+  if (args["adaptive_split"])
+    pm.set_scheduling_policy (scheduling_policy::adaptive_split);
+
+  if (args["tree_barrier"])
+    pm.set_barrier_type (barrier_type::combining_tree);
+
+  if (args["pin_threads"])
+    pm.set_pin_threads (true);
+
+  if (args["telemetry"])
+    pm.set_telemetry (true);
+
+  idle_policy policy;
+  if (args["spin_time"])
+    policy.spin_time = std::chrono::microseconds (args["spin_time"].as<unsigned int> ());
+  if (args["yield_time"])
+    policy.yield_time = std::chrono::microseconds (args["yield_time"].as<unsigned int> ());
+  if (args["fixed_spin"])
+    policy.adaptive = false;
+  pm.set_idle_policy (policy);
+
+  if (args["extraction_threads"])
+    pm.set_extraction_threads (args["extraction_threads"].as<unsigned int> ());
+
+  if (args["layout"] || args["tile_size"])
+  {
+    const auto layout_name = args["layout"].as<std::string> ("row_major");
+    const unsigned int tile_size = args["tile_size"].as<unsigned int> (grid_cells_order::default_tile_size);
+
+    if (layout_name == "row_major")
+      pm.set_cells_layout (cells_layout::row_major, tile_size);
+    else if (layout_name == "tiled")
+      pm.set_cells_layout (cells_layout::tiled, tile_size);
+    else if (layout_name == "morton")
+      pm.set_cells_layout (cells_layout::morton, tile_size);
+    else
+    {
+      std::cerr << "Unknown cells layout: " << layout_name << std::endl;
+      return true;
+    }
+  }
+
   if (args["help"])
   {
     std::cerr << parser_wrapper->parser;
@@ -61,6 +119,13 @@ bool con_parser::parse (int argc, char **argv, bool require_configuration, proje
       pm.append_extractor_to_own (dumper);
   }
 
+  if (args["mesh"])
+  {
+    mesh_reader reader (args["mesh"].as<std::string> ());
+    if (reader.initialize_project (pm))
+      return true;
+  }
+
   if (args["configuration"])
   {
     configuration_reader config (args["configuration"].as<std::string> ());
@@ -87,6 +87,21 @@ static bool read_node (const configuration &scheme, std::size_t scheme_id, confi
 {
   const auto name = scheme.get_node_name (scheme_id);
 
+  /// Arrays are optional, missing array is read as empty one
+  if (data.find (name) == data.end () && scheme.get_node_type (scheme_id) == array_type)
+  {
+    const int scheme_array_element_scheme_id = scheme.get_node_value (scheme_id);
+    config.create_array (config_id, name, config.clone_node (scheme_array_element_scheme_id, &scheme));
+    return false;
+  }
+
+  /// Groups are optional too, missing group takes default values of the scheme
+  if (data.find (name) == data.end () && scheme.get_node_type (scheme_id) == group_type)
+  {
+    config.add_child (config_id, config.clone_node (scheme_id, &scheme));
+    return false;
+  }
+
   if (data.find (name) == data.end ())
   {
     std::cerr << "Error! Configuration file must contain '" << name << "' field." << std::endl;
@@ -49,7 +49,7 @@ public:
     auto task = domain.create_task ("write_results");
 
 #if HDF5_BUILD
-    if (is_main_thread (thread_id))
+    if (threads.is_team_leader (thread_id))
     {
       const auto &gl_representation = pm.get_gl_representation ();
       const auto &solver_workspace = pm.get_solver_workspace ();
@@ -81,12 +81,12 @@ public:
       hid_t time_step_group_id = H5Gcreate2 (file_id, time_step_group_name.c_str (), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
       for (auto &field: pm.get_fields_names())
-        write_field (solver_workspace.get_host_copy (field), time_step_group_name + "/" + field, type, cells_count);
+        write_field (solver_workspace.get_results (field), time_step_group_name + "/" + field, type, cells_count);
 
       H5Gclose (time_step_group_id);
     }
 
-    threads.barrier();
+    threads.barrier (thread_id);
 #endif
   }
 
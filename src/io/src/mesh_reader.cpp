@@ -0,0 +1,104 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "io/mesh_reader.h"
+
+#include "core/grid/unstructured_mesh.h"
+#include "core/pm/project_manager.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+static bool read_section_header (std::ifstream &file, const std::string &expected_name, unsigned int &count)
+{
+  std::string name;
+  if (!(file >> name >> count) || name != expected_name)
+  {
+    std::cerr << "Can't read '" << expected_name << "' section of mesh" << std::endl;
+    return true;
+  }
+
+  return false;
+}
+
+mesh_reader::~mesh_reader () = default;
+
+mesh_reader::mesh_reader (const std::string &filename)
+{
+  std::ifstream file (filename);
+
+  if (!file.is_open ())
+  {
+    std::cerr << "Can't open mesh file: " << filename << std::endl;
+    return;
+  }
+
+  unsigned int vertices_count = 0;
+  if (read_section_header (file, "vertices", vertices_count))
+    return;
+
+  std::vector<float> vertices_x (vertices_count);
+  std::vector<float> vertices_y (vertices_count);
+
+  for (unsigned int vertex_id = 0; vertex_id < vertices_count; vertex_id++)
+  {
+    if (!(file >> vertices_x[vertex_id] >> vertices_y[vertex_id]))
+    {
+      std::cerr << "Can't read vertex " << vertex_id << " of mesh " << filename << std::endl;
+      return;
+    }
+  }
+
+  unsigned int cells_count = 0;
+  if (read_section_header (file, "cells", cells_count))
+    return;
+
+  std::vector<unsigned int> cells_offsets (1, 0);
+  std::vector<unsigned int> cells_vertices;
+  cells_offsets.reserve (cells_count + 1);
+  cells_vertices.reserve (cells_count * 4);
+
+  for (unsigned int cell_id = 0; cell_id < cells_count; cell_id++)
+  {
+    unsigned int cell_vertices_count = 0;
+    if (!(file >> cell_vertices_count) || cell_vertices_count > 4)
+    {
+      std::cerr << "Can't read cell " << cell_id << " of mesh " << filename << std::endl;
+      return;
+    }
+
+    for (unsigned int vertex_id = 0; vertex_id < cell_vertices_count; vertex_id++)
+    {
+      unsigned int vertex = 0;
+      if (!(file >> vertex))
+      {
+        std::cerr << "Can't read cell " << cell_id << " of mesh " << filename << std::endl;
+        return;
+      }
+      cells_vertices.push_back (vertex);
+    }
+
+    cells_offsets.push_back (cells_vertices.size ());
+  }
+
+  auto new_mesh = std::make_unique<unstructured_mesh> ();
+  if (new_mesh->build (std::move (vertices_x), std::move (vertices_y), std::move (cells_offsets), std::move (cells_vertices)))
+  {
+    std::cerr << "Mesh " << filename << " has invalid cells" << std::endl;
+    return;
+  }
+
+  new_mesh->reorder (new_mesh->get_rcm_order ());
+  mesh = std::move (new_mesh);
+}
+
+bool mesh_reader::initialize_project (project_manager &pm)
+{
+  if (!is_valid ())
+    return true;
+
+  pm.set_mesh (std::move (mesh));
+  return false;
+}
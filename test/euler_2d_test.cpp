@@ -0,0 +1,528 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "gtest/gtest.h"
+#include "core/grid/grid.h"
+#include "core/gpu/euler_2d.cuh"
+#include "core/cpu/euler_2d_face_sweep.h"
+#include "core/cpu/euler_2d_muscl.h"
+#include "core/cpu/euler_2d_amr.h"
+#include "core/config/configuration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <random>
+
+/// Structured row-major grid with random rho, u, v and p, rectilinear one has varying spacing
+template <class float_type>
+struct euler_2d_test_grid
+{
+  grid_cells_order order;
+  grid_topology topology;
+  grid_geometry geometry {};
+
+  std::vector<float> columns_widths, columns_centers, rows_heights, rows_centers;
+  std::vector<float_type> fields[4];
+
+  euler_2d_test_grid (unsigned int nx, unsigned int ny, boundary_type bc_x, boundary_type bc_y, bool is_uniform)
+  {
+    order.initialize (nx, ny, cells_layout::row_major, 8);
+    topology.initialize_for_structured_uniform_grid (
+      nx, ny, boundary_to_id (bc_x), boundary_to_id (bc_y), boundary_to_id (bc_x), boundary_to_id (bc_y), order);
+
+    for (unsigned int x = 0; x < nx; x++)
+    {
+      columns_widths.push_back (0.3f + 0.01f * x);
+      columns_centers.push_back (x > 0 ? columns_centers.back () + (columns_widths[x - 1] + columns_widths[x]) / 2 : columns_widths[x] / 2);
+    }
+    for (unsigned int y = 0; y < ny; y++)
+    {
+      rows_heights.push_back (0.7f - 0.02f * y);
+      rows_centers.push_back (y > 0 ? rows_centers.back () + (rows_heights[y - 1] + rows_heights[y]) / 2 : rows_heights[y] / 2);
+    }
+
+    if (is_uniform)
+      geometry.initialize_for_structured_uniform_grid (nx, ny, 0.3f, 0.7f, order);
+    else
+      geometry.initialize_for_structured_rectilinear_grid (
+        nx, ny, columns_widths.data (), columns_centers.data (), rows_heights.data (), rows_centers.data (), 0.3f, order);
+
+    std::mt19937 generator (42);
+    std::uniform_real_distribution<float_type> positive (0.5, 2.0);
+    std::uniform_real_distribution<float_type> velocity (-1.0, 1.0);
+
+    for (unsigned int field = 0; field < 4; field++)
+      for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+        fields[field].push_back (field == 0 || field == 3 ? positive (generator) : velocity (generator));
+  }
+
+  /// Replaces u, v and p with rho * u, rho * v and rho * E
+  void convert_to_conservative (float_type gamma)
+  {
+    for (unsigned int cell_id = 0; cell_id < fields[0].size (); cell_id++)
+    {
+      float_type q[4];
+      fill_state_vector (cell_id, gamma, fields[0].data (), fields[1].data (), fields[2].data (), fields[3].data (), q);
+
+      for (unsigned int field = 1; field < 4; field++)
+        fields[field][cell_id] = q[field];
+    }
+  }
+};
+
+template <class float_type, euler_2d_variables variables>
+static void check_face_sweep (boundary_type bc_x, boundary_type bc_y, bool is_uniform)
+{
+  const unsigned int nx = 37;
+  const unsigned int ny = 5;
+  const float_type dt = 1e-3;
+  const float_type gamma = 1.4;
+
+  euler_2d_test_grid<float_type> grid (nx, ny, bc_x, bc_y, is_uniform);
+  const grid_topology &topology = grid.topology;
+  const grid_geometry &geometry = grid.geometry;
+  auto &fields = grid.fields;
+
+  if constexpr (variables == euler_2d_variables::conservative)
+    grid.convert_to_conservative (gamma);
+
+  /// rho, u, v, p of the next layers of both kernels
+  std::vector<float_type> cells_next[4];
+  std::vector<float_type> faces_next[4];
+
+  for (unsigned int field = 0; field < 4; field++)
+  {
+    cells_next[field].assign (nx * ny, 0);
+    faces_next[field].assign (nx * ny, 0);
+  }
+
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+    euler_2d_calculate_next_cell_values<variables> (
+      cell_id, dt, gamma, topology, geometry,
+      fields[0].data (), cells_next[0].data (), fields[1].data (), cells_next[1].data (),
+      fields[2].data (), cells_next[2].data (), fields[3].data (), cells_next[3].data ());
+
+  ASSERT_TRUE (euler_2d_face_sweep<float_type>::is_supported (topology));
+
+  euler_2d_face_sweep<float_type> face_sweep;
+  face_sweep.initialize (2, topology, is_uniform);
+
+  /// Ranges start and end inside of rows, on rows borders and span single cells
+  const std::vector<unsigned int> ranges_borders = { 0, 7, 37, 38, 39, 100, 111, 184, nx * ny };
+  float_type max_wave_speed = 0.0;
+  for (unsigned int range_id = 0; range_id + 1 < ranges_borders.size (); range_id++)
+    face_sweep.template calculate_next_cells_values<variables> (
+      range_id % 2, ranges_borders[range_id], ranges_borders[range_id + 1], dt, gamma, topology, topology, geometry,
+      fields[0].data (), faces_next[0].data (), fields[1].data (), faces_next[1].data (),
+      fields[2].data (), faces_next[2].data (), fields[3].data (), faces_next[3].data (), &max_wave_speed);
+
+  float_type expected_max_wave_speed = 0.0;
+  for (unsigned int field = 0; field < 4; field++)
+    for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+      ASSERT_EQ (faces_next[field][cell_id], cells_next[field][cell_id]);
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+    expected_max_wave_speed = std::max (expected_max_wave_speed, euler_2d_calculate_max_wave_speed<variables> (
+      cell_id, gamma, cells_next[0].data (), cells_next[1].data (), cells_next[2].data (), cells_next[3].data ()));
+
+  /// Fused time step relies on the sweep giving the wave speed of a separate pass
+  ASSERT_EQ (max_wave_speed, expected_max_wave_speed);
+}
+
+TEST(euler_2d, face_sweep)
+{
+  for (auto bc_x: { boundary_type::periodic, boundary_type::mirror, boundary_type::none })
+  {
+    for (auto bc_y: { boundary_type::periodic, boundary_type::mirror, boundary_type::none })
+    {
+      for (bool is_uniform: { true, false })
+      {
+        check_face_sweep<float, euler_2d_variables::primitive> (bc_x, bc_y, is_uniform);
+        check_face_sweep<double, euler_2d_variables::primitive> (bc_x, bc_y, is_uniform);
+        check_face_sweep<float, euler_2d_variables::conservative> (bc_x, bc_y, is_uniform);
+        check_face_sweep<double, euler_2d_variables::conservative> (bc_x, bc_y, is_uniform);
+      }
+    }
+  }
+}
+
+TEST(euler_2d, conservative_variables)
+{
+  const unsigned int nx = 19;
+  const unsigned int ny = 7;
+  const double dt = 1e-3;
+  const double gamma = 1.4;
+
+  grid_cells_order order;
+  order.initialize (nx, ny, cells_layout::row_major, 8);
+
+  grid_topology topology;
+  topology.initialize_for_structured_uniform_grid (nx, ny, 0, 0, 0, 0, order);
+  grid_geometry geometry {};
+  geometry.initialize_for_structured_uniform_grid (nx, ny, 0.3f, 0.7f, order);
+
+  std::mt19937 generator (7);
+  std::uniform_real_distribution<double> positive (0.5, 2.0);
+  std::uniform_real_distribution<double> velocity (-1.0, 1.0);
+  std::vector<double> primitive[4];
+  std::vector<double> conservative[4];
+  std::vector<double> primitive_next[4];
+  std::vector<double> conservative_next[4];
+
+  for (unsigned int field = 0; field < 4; field++)
+  {
+    for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+      primitive[field].push_back (field == 0 || field == 3 ? positive (generator) : velocity (generator));
+    conservative[field].assign (nx * ny, 0);
+    primitive_next[field].assign (nx * ny, 0);
+    conservative_next[field].assign (nx * ny, 0);
+  }
+
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+  {
+    double q[4];
+    fill_state_vector (cell_id, gamma, primitive[0].data (), primitive[1].data (), primitive[2].data (), primitive[3].data (), q);
+
+    for (unsigned int field = 0; field < 4; field++)
+      conservative[field][cell_id] = q[field];
+  }
+
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+  {
+    euler_2d_calculate_next_cell_values (
+      cell_id, dt, gamma, topology, geometry,
+      primitive[0].data (), primitive_next[0].data (), primitive[1].data (), primitive_next[1].data (),
+      primitive[2].data (), primitive_next[2].data (), primitive[3].data (), primitive_next[3].data ());
+    euler_2d_calculate_next_cell_values<euler_2d_variables::conservative> (
+      cell_id, dt, gamma, topology, geometry,
+      conservative[0].data (), conservative_next[0].data (), conservative[1].data (), conservative_next[1].data (),
+      conservative[2].data (), conservative_next[2].data (), conservative[3].data (), conservative_next[3].data ());
+  }
+
+  /// Both states describe the same gas up to rounding of conversions
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+  {
+    double u, v, p;
+    euler_2d_calculate_primitive_variables (
+      cell_id, gamma, conservative_next[0].data (), conservative_next[1].data (),
+      conservative_next[2].data (), conservative_next[3].data (), u, v, p);
+
+    ASSERT_NEAR (conservative_next[0][cell_id], primitive_next[0][cell_id], 1e-12);
+    ASSERT_NEAR (u, primitive_next[1][cell_id], 1e-12);
+    ASSERT_NEAR (v, primitive_next[2][cell_id], 1e-12);
+    ASSERT_NEAR (p, primitive_next[3][cell_id], 1e-12);
+  }
+}
+
+/// Runs euler_2d_muscl with tiles going to two threads in turns
+template <class float_type, euler_2d_variables variables, euler_2d_slope_limiter limiter>
+static void calculate_muscl_step (
+  euler_2d_test_grid<float_type> &grid,
+  euler_2d_time_integration time_integration,
+  unsigned int tile_nx,
+  unsigned int tile_ny,
+  float_type dt,
+  float_type gamma,
+  std::vector<float_type> *next,
+  float_type *max_wave_speed = nullptr)
+{
+  euler_2d_muscl<float_type> muscl;
+  muscl.initialize (2, grid.topology, limiter, time_integration, tile_nx, tile_ny);
+
+  auto &fields = grid.fields;
+  for (unsigned int tile_id = 0; tile_id < muscl.get_tiles_count (); tile_id++)
+    muscl.template calculate_next_cells_values<variables, limiter> (
+      tile_id % 2, tile_id, tile_id + 1, dt, gamma, grid.topology, grid.geometry,
+      fields[0].data (), next[0].data (), fields[1].data (), next[1].data (),
+      fields[2].data (), next[2].data (), fields[3].data (), next[3].data (), max_wave_speed);
+}
+
+TEST(euler_2d, muscl_tiles)
+{
+  const unsigned int nx = 37;
+  const unsigned int ny = 5;
+  const double dt = 1e-3;
+  const double gamma = 1.4;
+
+  for (auto bc_x: { boundary_type::periodic, boundary_type::mirror, boundary_type::none })
+  {
+    for (auto bc_y: { boundary_type::periodic, boundary_type::mirror, boundary_type::none })
+    {
+      for (bool is_uniform: { true, false })
+      {
+        euler_2d_test_grid<double> grid (nx, ny, bc_x, bc_y, is_uniform);
+
+        std::vector<double> cells_next[4], small_tiles_next[4], large_tiles_next[4];
+        for (unsigned int field = 0; field < 4; field++)
+        {
+          cells_next[field].assign (nx * ny, 0);
+          small_tiles_next[field].assign (nx * ny, 0);
+          large_tiles_next[field].assign (nx * ny, 0);
+        }
+
+        /// Constant reconstruction with forward Euler is the first order scheme
+        auto &fields = grid.fields;
+        for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+          euler_2d_calculate_next_cell_values (
+            cell_id, dt, gamma, grid.topology, grid.geometry,
+            fields[0].data (), cells_next[0].data (), fields[1].data (), cells_next[1].data (),
+            fields[2].data (), cells_next[2].data (), fields[3].data (), cells_next[3].data ());
+
+        double max_wave_speed = 0.0;
+        calculate_muscl_step<double, euler_2d_variables::primitive, euler_2d_slope_limiter::none> (
+          grid, euler_2d_time_integration::euler, 8, 2, dt, gamma, small_tiles_next, &max_wave_speed);
+
+        double expected_max_wave_speed = 0.0;
+        for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+          expected_max_wave_speed = std::max (expected_max_wave_speed, euler_2d_calculate_max_wave_speed<euler_2d_variables::primitive> (
+            cell_id, gamma, cells_next[0].data (), cells_next[1].data (), cells_next[2].data (), cells_next[3].data ()));
+
+        for (unsigned int field = 0; field < 4; field++)
+          for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+            ASSERT_EQ (small_tiles_next[field][cell_id], cells_next[field][cell_id]);
+        ASSERT_EQ (max_wave_speed, expected_max_wave_speed);
+
+        /// Halo cells of small tiles cross several tiles and boundaries
+        calculate_muscl_step<double, euler_2d_variables::primitive, euler_2d_slope_limiter::monotonized_central> (
+          grid, euler_2d_time_integration::ssp_rk3, 5, 2, dt, gamma, small_tiles_next);
+        calculate_muscl_step<double, euler_2d_variables::primitive, euler_2d_slope_limiter::monotonized_central> (
+          grid, euler_2d_time_integration::ssp_rk3, 128, 32, dt, gamma, large_tiles_next);
+
+        for (unsigned int field = 0; field < 4; field++)
+          for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+            ASSERT_EQ (small_tiles_next[field][cell_id], large_tiles_next[field][cell_id]);
+      }
+    }
+  }
+}
+
+TEST(euler_2d, ssp_rk3)
+{
+  const unsigned int nx = 19;
+  const unsigned int ny = 7;
+  const double dt = 1e-3;
+  const double gamma = 1.4;
+
+  for (auto bc_x: { boundary_type::periodic, boundary_type::none })
+  {
+    for (auto bc_y: { boundary_type::periodic, boundary_type::mirror })
+    {
+      euler_2d_test_grid<double> grid (nx, ny, bc_x, bc_y, false);
+      grid.convert_to_conservative (gamma);
+
+      std::vector<double> tiles_next[4], stages[3][4], euler_step[4];
+      for (unsigned int field = 0; field < 4; field++)
+      {
+        tiles_next[field].assign (nx * ny, 0);
+        euler_step[field].assign (nx * ny, 0);
+        for (auto &stage: stages)
+          stage[field].assign (nx * ny, 0);
+      }
+
+      calculate_muscl_step<double, euler_2d_variables::conservative, euler_2d_slope_limiter::none> (
+        grid, euler_2d_time_integration::ssp_rk3, 4, 3, dt, gamma, tiles_next);
+
+      /// Stages of SSP-RK3 as combinations of forward Euler steps
+      const double initial_weights[3] = { 0.0, 0.75, 1.0 / 3.0 };
+      for (unsigned int stage_id = 0; stage_id < 3; stage_id++)
+      {
+        const std::vector<double> *state = stage_id == 0 ? grid.fields : stages[stage_id - 1];
+
+        for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+          euler_2d_calculate_next_cell_values<euler_2d_variables::conservative> (
+            cell_id, dt, gamma, grid.topology, grid.geometry,
+            state[0].data (), euler_step[0].data (), state[1].data (), euler_step[1].data (),
+            state[2].data (), euler_step[2].data (), state[3].data (), euler_step[3].data ());
+
+        for (unsigned int field = 0; field < 4; field++)
+          for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+            stages[stage_id][field][cell_id] = initial_weights[stage_id] * grid.fields[field][cell_id]
+                                             + (1.0 - initial_weights[stage_id]) * euler_step[field][cell_id];
+      }
+
+      for (unsigned int field = 0; field < 4; field++)
+        for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+          ASSERT_NEAR (tiles_next[field][cell_id], stages[2][field][cell_id], 1e-12);
+    }
+  }
+}
+
+/// L1 norm of density error of the advected sine wave with the limiter and time integration
+TEST(euler_2d, slope_limiters)
+{
+  /// Extrema are reconstructed as constants
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::minmod> (1.0, -2.0), 0.0);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::van_leer> (0.0, 2.0), 0.0);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::monotonized_central> (-1.0, 2.0), 0.0);
+
+  /// Linear data keeps its slope
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::minmod> (-0.5, -0.5), -0.5);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::van_leer> (0.5, 0.5), 0.5);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::monotonized_central> (0.5, 0.5), 0.5);
+
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::minmod> (1.0, 4.0), 1.0);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::van_leer> (1.0, 4.0), 1.6);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::monotonized_central> (1.0, 4.0), 2.0);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::monotonized_central> (-2.0, -3.0), -2.5);
+  EXPECT_EQ (euler_2d_limit_slope<euler_2d_slope_limiter::none> (1.0, 1.0), 0.0);
+}
+
+/// L1 error of density of a smooth wave advected with constant velocity and pressure through periodic sides
+template <euler_2d_slope_limiter limiter>
+static double calculate_advection_error (euler_2d_time_integration time_integration, unsigned int nx)
+{
+  const unsigned int ny = 4;
+  const double pi = std::acos (-1.0);
+  const double dx = 1.0 / nx;
+  const double dt = 0.2 * dx;
+  const unsigned int steps = static_cast<unsigned int> (std::lround (0.5 / dt));
+  const double gamma = 1.4;
+
+  euler_2d_test_grid<double> grid (nx, ny, boundary_type::periodic, boundary_type::periodic, true);
+  grid.geometry.initialize_for_structured_uniform_grid (nx, ny, static_cast<float> (dx), static_cast<float> (dx), grid.order);
+
+  auto get_density = [&] (unsigned int cell_id, double t) {
+    return 1.0 + 0.2 * std::sin (2.0 * pi * ((grid.topology.get_cell_x (cell_id) + 0.5) * dx - t));
+  };
+
+  std::vector<double> next[4];
+  for (unsigned int field = 0; field < 4; field++)
+  {
+    next[field].assign (nx * ny, 0);
+    for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+      grid.fields[field][cell_id] = field == 0 ? get_density (cell_id, 0.0) : field == 2 ? 0.0 : 1.0;
+  }
+
+  for (unsigned int step = 0; step < steps; step++)
+  {
+    calculate_muscl_step<double, euler_2d_variables::primitive, limiter> (
+      grid, time_integration, euler_2d_muscl<double>::default_tile_nx, euler_2d_muscl<double>::default_tile_ny, dt, gamma, next);
+
+    for (unsigned int field = 0; field < 4; field++)
+      std::swap (grid.fields[field], next[field]);
+  }
+
+  double error = 0.0;
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+    error += std::fabs (grid.fields[0][cell_id] - get_density (cell_id, steps * dt)) / (nx * ny);
+  return error;
+}
+
+TEST(euler_2d, muscl_convergence)
+{
+  const double first_order_coarse = calculate_advection_error<euler_2d_slope_limiter::none> (euler_2d_time_integration::euler, 32);
+  const double first_order_fine = calculate_advection_error<euler_2d_slope_limiter::none> (euler_2d_time_integration::euler, 64);
+  const double rk2_coarse = calculate_advection_error<euler_2d_slope_limiter::van_leer> (euler_2d_time_integration::ssp_rk2, 32);
+  const double rk2_fine = calculate_advection_error<euler_2d_slope_limiter::van_leer> (euler_2d_time_integration::ssp_rk2, 64);
+  const double rk3_coarse = calculate_advection_error<euler_2d_slope_limiter::monotonized_central> (euler_2d_time_integration::ssp_rk3, 32);
+  const double rk3_fine = calculate_advection_error<euler_2d_slope_limiter::monotonized_central> (euler_2d_time_integration::ssp_rk3, 64);
+
+  EXPECT_GT (std::log2 (rk2_coarse / rk2_fine), 1.5);
+  EXPECT_GT (std::log2 (rk3_coarse / rk3_fine), 1.5);
+
+  /// High order scheme on a twice coarser grid is more accurate than the first order one
+  EXPECT_LT (rk2_coarse, first_order_fine);
+  EXPECT_LT (rk3_coarse, first_order_fine);
+  EXPECT_LT (first_order_fine, first_order_coarse);
+}
+
+/// Total mass and energy of output fields, cells of the grid have equal volumes
+static void calculate_totals (const grid &solver_grid, workspace &solver_workspace, double gamma, double &mass, double &energy)
+{
+  const auto rho = reinterpret_cast<const double *> (solver_workspace.get ("rho"));
+  const auto u = reinterpret_cast<const double *> (solver_workspace.get ("u"));
+  const auto v = reinterpret_cast<const double *> (solver_workspace.get ("v"));
+  const auto p = reinterpret_cast<const double *> (solver_workspace.get ("p"));
+
+  mass = 0.0;
+  energy = 0.0;
+
+  for (unsigned int cell_id = 0; cell_id < solver_grid.get_cells_number (); cell_id++)
+  {
+    double q[4];
+    fill_state_vector (cell_id, gamma, rho, u, v, p, q);
+    mass += q[0];
+    energy += q[3];
+  }
+}
+
+TEST(euler_2d, amr_conservation)
+{
+  const unsigned int n = 64;
+  const double gamma = 1.4;
+
+  workspace solver_workspace;
+  thread_pool threads (2);
+  grid solver_grid (solver_workspace, n, n, 1.0, 1.0);
+
+  configuration config;
+  const auto solver_id = config.create_group ("solver");
+
+  euler_2d_amr<double> solver (threads, solver_workspace);
+  solver.fill_configuration_scheme (config, solver_id);
+
+  /// Odd patch size is rejected, and the solver stops the calculation instead of keeping fields unchanged
+  const auto solver_children = config.children_for (solver_id);
+  config.update_value (solver_children[2], 7);
+  solver.apply_configuration (config, solver_id, &solver_grid, -1);
+  threads.execute ([&] (unsigned int thread_id, unsigned int threads_count) {
+    ASSERT_TRUE (std::isinf (solver.solve (0, thread_id, threads_count)));
+  });
+
+  /// Patches of 8 cells give 2 x 2 base patches, regrids every second step refine and coarsen during the test
+  config.update_value (solver_children[2], 8);
+  config.update_value (solver_children[5], 2);
+  solver.apply_configuration (config, solver_id, &solver_grid, -1);
+
+  /// Moving dense disk, its edge is refined while the rest of the domain stays on coarser levels
+  const auto topology = solver_grid.gen_topology_wrapper ();
+  const auto rho = reinterpret_cast<double *> (solver_workspace.get ("rho"));
+  const auto u = reinterpret_cast<double *> (solver_workspace.get ("u"));
+  const auto v = reinterpret_cast<double *> (solver_workspace.get ("v"));
+  const auto p = reinterpret_cast<double *> (solver_workspace.get ("p"));
+
+  for (unsigned int y = 0; y < n; y++)
+  {
+    for (unsigned int x = 0; x < n; x++)
+    {
+      const unsigned int cell_id = topology.get_cell_id (x, y);
+      const double dx = (x + 0.5) / n - 0.5;
+      const double dy = (y + 0.5) / n - 0.5;
+
+      rho[cell_id] = dx * dx + dy * dy < 0.04 ? 2.0 : 1.0;
+      u[cell_id] = 0.5;
+      v[cell_id] = 0.3;
+      p[cell_id] = 1.0;
+    }
+  }
+
+  double mass_before {}, energy_before {};
+  calculate_totals (solver_grid, solver_workspace, gamma, mass_before, energy_before);
+
+  const unsigned int steps = 20;
+  threads.execute ([&] (unsigned int thread_id, unsigned int threads_count) {
+    for (unsigned int step = 0; step < steps; step++)
+      solver.solve (step, thread_id, threads_count);
+    threads.barrier (thread_id);
+    solver.update_results (thread_id, threads_count);
+  });
+
+  /// Leaves of all levels, so coarse-fine interfaces take flux corrections
+  const unsigned int leaves_cells = solver.get_leaves_cells_count ();
+  ASSERT_GT (leaves_cells, 4u * 8 * 8);
+  ASSERT_LT (leaves_cells, n * n);
+
+  double mass_after {}, energy_after {};
+  calculate_totals (solver_grid, solver_workspace, gamma, mass_after, energy_after);
+
+  EXPECT_NEAR (mass_after, mass_before, 1e-10 * mass_before);
+  EXPECT_NEAR (energy_after, energy_before, 1e-10 * energy_before);
+
+  /// Steps don't touch output fields until results are requested
+  const double disk_rho = rho[topology.get_cell_id (n / 2, n / 2)];
+  threads.execute ([&] (unsigned int thread_id, unsigned int threads_count) {
+    solver.solve (steps, thread_id, threads_count);
+  });
+  ASSERT_EQ (rho[topology.get_cell_id (n / 2, n / 2)], disk_rho);
+}
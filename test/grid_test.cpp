@@ -0,0 +1,489 @@
+//
+// Created by egi on 10/17/26.
+//
+
+#include "gtest/gtest.h"
+#include "core/grid/grid.h"
+#include "core/grid/unstructured_mesh.h"
+#include "core/grid/amr_hierarchy.h"
+#include "core/cpu/halo.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+static grid_topology create_topology (unsigned int nx, unsigned int ny, boundary_type bc, cells_layout layout = cells_layout::row_major)
+{
+  grid_cells_order order;
+  order.initialize (nx, ny, layout, 8);
+
+  grid_topology topology;
+  topology.initialize_for_structured_uniform_grid (
+    nx, ny, boundary_to_id (bc), boundary_to_id (bc), boundary_to_id (bc), boundary_to_id (bc), order);
+  return topology;
+}
+
+TEST(grid, cells_order)
+{
+  for (auto layout: { cells_layout::row_major, cells_layout::tiled, cells_layout::morton })
+  {
+    for (auto size: { std::make_pair (1u, 1u), std::make_pair (16u, 16u), std::make_pair (37u, 21u), std::make_pair (5u, 40u) })
+    {
+      const unsigned int nx = size.first;
+      const unsigned int ny = size.second;
+      const grid_topology topology = create_topology (nx, ny, boundary_type::periodic, layout);
+      const unsigned int halo = topology.get_halo_size ();
+
+      std::vector<unsigned int> visits (nx * ny, 0);
+
+      for (unsigned int y = 0; y < ny; y++)
+      {
+        for (unsigned int x = 0; x < nx; x++)
+        {
+          const unsigned int cell_id = topology.get_cell_id (x, y);
+          ASSERT_LT (cell_id, nx * ny);
+          ASSERT_EQ (topology.get_cell_x (cell_id), x);
+          ASSERT_EQ (topology.get_cell_y (cell_id), y);
+          visits[cell_id]++;
+
+          for (unsigned int edge_id = 0; edge_id < 4; edge_id++)
+          {
+            const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, edge_id);
+            const unsigned int distance = neighbor_id > cell_id ? neighbor_id - cell_id : cell_id - neighbor_id;
+            ASSERT_LE (std::min (distance, nx * ny - distance), halo);
+          }
+        }
+      }
+
+      for (auto cell_visits: visits)
+        ASSERT_EQ (cell_visits, 1u);
+    }
+  }
+
+  /// Power of two squares keep plain Z-order
+  const grid_topology morton = create_topology (4, 4, boundary_type::periodic, cells_layout::morton);
+  ASSERT_EQ (morton.get_cell_id (1, 0), 1u);
+  ASSERT_EQ (morton.get_cell_id (0, 1), 2u);
+  ASSERT_EQ (morton.get_cell_id (2, 0), 4u);
+  ASSERT_EQ (morton.get_cell_id (3, 3), 15u);
+
+  /// Grid caches Morton permutation of other sizes, which matches the walk over quadrants
+  workspace solver_workspace;
+  const grid cached (solver_workspace, 37, 21, 1.0, 1.0, cells_layout::morton);
+  const grid_topology cached_topology = cached.gen_topology_wrapper ();
+  const grid_topology walked_topology = create_topology (37, 21, boundary_type::periodic, cells_layout::morton);
+
+  for (unsigned int y = 0; y < 21; y++)
+  {
+    for (unsigned int x = 0; x < 37; x++)
+    {
+      const unsigned int cell_id = walked_topology.get_cell_id (x, y);
+      ASSERT_EQ (cached_topology.get_cell_id (x, y), cell_id);
+      ASSERT_EQ (cached_topology.get_cell_x (cell_id), x);
+      ASSERT_EQ (cached_topology.get_cell_y (cell_id), y);
+
+      for (unsigned int edge_id = 0; edge_id < 4; edge_id++)
+        ASSERT_EQ (cached_topology.get_neighbor_id (cell_id, edge_id), walked_topology.get_neighbor_id (cell_id, edge_id));
+    }
+  }
+}
+
+TEST(grid, cells_strips)
+{
+  const unsigned int nx = 5;
+  const unsigned int ny = 4;
+  const grid_topology topology = create_topology (nx, ny, boundary_type::periodic);
+
+  for (unsigned int begin = 0; begin < nx * ny; begin++)
+  {
+    for (unsigned int end = begin; end <= nx * ny; end++)
+    {
+      std::vector<unsigned int> visits (nx * ny, 0);
+      unsigned int next_cell = begin;
+
+      auto check_strip = [&] (unsigned int strip_begin, unsigned int strip_end, const auto &strip_topology, bool is_interior)
+      {
+        ASSERT_EQ (strip_begin, next_cell);
+        ASSERT_LT (strip_begin, strip_end);
+        next_cell = strip_end;
+
+        for (unsigned int cell_id = strip_begin; cell_id < strip_end; cell_id++)
+        {
+          const unsigned int x = topology.get_cell_x (cell_id);
+          const unsigned int y = topology.get_cell_y (cell_id);
+          ASSERT_EQ (is_interior, x > 0 && x < nx - 1 && y > 0 && y < ny - 1);
+
+          for (unsigned int edge_id = 0; edge_id < 4; edge_id++)
+            ASSERT_EQ (strip_topology.get_neighbor_id (cell_id, edge_id), topology.get_neighbor_id (cell_id, edge_id));
+
+          visits[cell_id]++;
+        }
+      };
+
+      topology.for_each_cells_strip (begin, end, [&] (unsigned int strip_begin, unsigned int strip_end, const auto &strip_topology) {
+        using strip_topology_type = std::decay_t<decltype (strip_topology)>;
+        check_strip (strip_begin, strip_end, strip_topology, std::is_same_v<strip_topology_type, grid_interior_topology>);
+      });
+
+      ASSERT_EQ (next_cell, end);
+      for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+        ASSERT_EQ (visits[cell_id], cell_id >= begin && cell_id < end ? 1u : 0u);
+    }
+  }
+}
+
+TEST(grid, boundary_topology)
+{
+  const unsigned int nx = 5;
+  const unsigned int ny = 4;
+  const std::vector<boundary_type> bcs = { boundary_type::periodic, boundary_type::mirror, boundary_type::none };
+
+  for (auto left: bcs)
+  for (auto bottom: bcs)
+  for (auto right: bcs)
+  for (auto top: bcs)
+  {
+    grid_cells_order order;
+    order.initialize (nx, ny, cells_layout::row_major, 8);
+
+    grid_topology topology;
+    topology.initialize_for_structured_uniform_grid (
+      nx, ny, boundary_to_id (left), boundary_to_id (bottom), boundary_to_id (right), boundary_to_id (top), order);
+
+    unsigned int dispatches = 0;
+    dispatch_boundary_conditions (topology, [&] (const auto &boundary_topology) {
+      using boundary_topology_type = std::decay_t<decltype (boundary_topology)>;
+      const bool is_periodic = left == boundary_type::periodic && bottom == boundary_type::periodic
+                            && right == boundary_type::periodic && top == boundary_type::periodic;
+      ASSERT_EQ (boundary_topology_type::has_boundary_neighbors, !is_periodic);
+
+      /// Boundary strips of specialized topology see the same neighbours as the runtime one
+      topology.for_each_cells_strip (0, nx * ny, boundary_topology, [&] (unsigned int begin, unsigned int end, const auto &strip_topology) {
+        for (unsigned int cell_id = begin; cell_id < end; cell_id++)
+          for (unsigned int edge_id = 0; edge_id < 4; edge_id++)
+            ASSERT_EQ (strip_topology.get_neighbor_id (cell_id, edge_id), topology.get_neighbor_id (cell_id, edge_id));
+      });
+
+      dispatches++;
+    });
+
+    ASSERT_EQ (dispatches, 1u);
+  }
+
+  /// Periodic side without periodic opposite side takes the condition of the opposite side
+  workspace solver_workspace;
+  grid solver_grid (solver_workspace, nx, ny, 1.0, 1.0);
+  solver_grid.set_boundary_conditions (boundary_type::periodic, boundary_type::none, boundary_type::mirror, boundary_type::periodic);
+  ASSERT_EQ (solver_grid.get_boundary_condition (side_type::left), boundary_type::mirror);
+  ASSERT_EQ (solver_grid.get_boundary_condition (side_type::right), boundary_type::mirror);
+  ASSERT_EQ (solver_grid.get_boundary_condition (side_type::bottom), boundary_type::none);
+  ASSERT_EQ (solver_grid.get_boundary_condition (side_type::top), boundary_type::none);
+
+  solver_grid.set_boundary_conditions (boundary_type::periodic, boundary_type::mirror, boundary_type::periodic, boundary_type::none);
+  ASSERT_EQ (solver_grid.get_boundary_condition (side_type::left), boundary_type::periodic);
+  ASSERT_EQ (solver_grid.get_boundary_condition (side_type::right), boundary_type::periodic);
+}
+
+TEST(grid, fill_halo)
+{
+  const unsigned int nx = 5;
+  const unsigned int ny = 4;
+  const int h = 2;
+
+  grid_halo_layout layout;
+  layout.initialize_for_structured_uniform_grid (nx, ny, h);
+  thread_pool threads (2);
+
+  for (auto bc: { boundary_type::periodic, boundary_type::mirror })
+  {
+    const grid_topology topology = create_topology (nx, ny, bc);
+    std::vector<unsigned int> field (layout.get_padded_cells_count (), 0);
+
+    for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+      field[layout.get_padded_cell_id (cell_id)] = cell_id;
+
+    threads.execute ([&] (unsigned int thread_id, unsigned int) {
+      fill_halo (threads, thread_id, topology, layout, field.data ());
+    });
+
+    /// Neighbours of real cells read through halo match grid_topology neighbours
+    for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+      for (unsigned int edge_id = 0; edge_id < 4; edge_id++)
+        ASSERT_EQ (field[layout.get_neighbor_id (layout.get_padded_cell_id (cell_id), edge_id)], topology.get_neighbor_id (cell_id, edge_id));
+
+    for (int y = -h; y < static_cast<int> (ny) + h; y++)
+    {
+      for (int x = -h; x < static_cast<int> (nx) + h; x++)
+      {
+        int source_x = 0;
+        int source_y = 0;
+        const unsigned int bc_id = boundary_to_id (bc);
+        get_halo_source (x, nx, bc_id, bc_id, source_x);
+        get_halo_source (y, ny, bc_id, bc_id, source_y);
+        ASSERT_EQ (field[layout.get_cell_id (x, y)], field[layout.get_cell_id (source_x, source_y)]);
+      }
+    }
+  }
+}
+
+/// Quads of nx x ny structured grid with vertices of cells listed in the given permutation of cells
+static unstructured_mesh create_quads_mesh (unsigned int nx, unsigned int ny, const std::vector<unsigned int> &cells)
+{
+  std::vector<float> vertices_x;
+  std::vector<float> vertices_y;
+
+  for (unsigned int y = 0; y <= ny; y++)
+  {
+    for (unsigned int x = 0; x <= nx; x++)
+    {
+      vertices_x.push_back (x);
+      vertices_y.push_back (y);
+    }
+  }
+
+  std::vector<unsigned int> offsets (1, 0);
+  std::vector<unsigned int> vertices;
+
+  for (auto cell_id: cells)
+  {
+    const unsigned int x = cell_id % nx;
+    const unsigned int y = cell_id / nx;
+    const unsigned int left_bottom = y * (nx + 1) + x;
+
+    for (auto vertex: { left_bottom, left_bottom + 1, left_bottom + nx + 2, left_bottom + nx + 1 })
+      vertices.push_back (vertex);
+    offsets.push_back (vertices.size ());
+  }
+
+  unstructured_mesh mesh;
+  EXPECT_FALSE (mesh.build (std::move (vertices_x), std::move (vertices_y), std::move (offsets), std::move (vertices)));
+  return mesh;
+}
+
+TEST(grid, unstructured_mesh)
+{
+  const unsigned int nx = 7;
+  const unsigned int ny = 5;
+
+  std::vector<unsigned int> cells (nx * ny);
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+    cells[cell_id] = (cell_id * 11) % (nx * ny);
+
+  unstructured_mesh mesh = create_quads_mesh (nx, ny, cells);
+  const unsigned int shuffled_bandwidth = mesh.get_bandwidth ();
+
+  auto order = mesh.get_rcm_order ();
+  std::vector<unsigned int> sorted_order = order;
+  std::sort (sorted_order.begin (), sorted_order.end ());
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+    ASSERT_EQ (sorted_order[cell_id], cell_id);
+
+  mesh.reorder (order);
+  ASSERT_LT (mesh.get_bandwidth (), shuffled_bandwidth);
+  ASSERT_LE (mesh.get_bandwidth (), 2 * std::min (nx, ny));
+
+  const grid_topology topology = mesh.gen_topology_wrapper ();
+  const grid_geometry geometry = mesh.gen_geometry_wrapper ();
+  ASSERT_EQ (topology.get_cells_count (), nx * ny);
+
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+  {
+    const unsigned int x = static_cast<unsigned int> (geometry.get_cell_center_x (cell_id));
+    const unsigned int y = static_cast<unsigned int> (geometry.get_cell_center_y (cell_id));
+    ASSERT_FLOAT_EQ (geometry.get_cell_volume (cell_id), 1.0f);
+    ASSERT_EQ (topology.get_edges_count (cell_id), 4u);
+
+    unsigned int boundary_faces = 0;
+    for (unsigned int edge_id = 0; edge_id < topology.get_edges_count (cell_id); edge_id++)
+    {
+      const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, edge_id);
+      const float normal_x = geometry.get_normal_x (cell_id, edge_id);
+      const float normal_y = geometry.get_normal_y (cell_id, edge_id);
+      ASSERT_FLOAT_EQ (geometry.get_edge_area (cell_id, edge_id), 1.0f);
+
+      if (neighbor_id == cell_id)
+      {
+        boundary_faces++;
+        continue;
+      }
+
+      /// Normals point outward, to the neighbour
+      ASSERT_FLOAT_EQ (geometry.get_cell_center_x (neighbor_id) - geometry.get_cell_center_x (cell_id), normal_x);
+      ASSERT_FLOAT_EQ (geometry.get_cell_center_y (neighbor_id) - geometry.get_cell_center_y (cell_id), normal_y);
+    }
+
+    const unsigned int expected_boundary_faces = (x == 0) + (x == nx - 1) + (y == 0) + (y == ny - 1);
+    ASSERT_EQ (boundary_faces, expected_boundary_faces);
+  }
+}
+
+TEST(grid, rectilinear_geometry)
+{
+  const std::vector<float> widths { 1.0f, 0.25f, 0.25f, 2.0f };
+  const std::vector<float> heights { 0.5f, 3.0f, 0.125f };
+  std::vector<float> columns_centers { 0.5f, 1.125f, 1.375f, 2.5f };
+  std::vector<float> rows_centers { 0.25f, 2.0f, 3.5625f };
+
+  grid_cells_order order;
+  order.initialize (widths.size (), heights.size (), cells_layout::morton, 8);
+
+  grid_geometry geometry;
+  geometry.initialize_for_structured_rectilinear_grid (
+    widths.size (), heights.size (), widths.data (), columns_centers.data (), heights.data (), rows_centers.data (),
+    std::min (*std::min_element (widths.begin (), widths.end ()), *std::min_element (heights.begin (), heights.end ())), order);
+
+  ASSERT_TRUE (geometry.is_rectilinear ());
+  ASSERT_FLOAT_EQ (geometry.get_min_spacing (), 0.125f);
+
+  for (unsigned int y = 0; y < heights.size (); y++)
+  {
+    for (unsigned int x = 0; x < widths.size (); x++)
+    {
+      const unsigned int cell_id = order.get_cell_id (x, y);
+      ASSERT_FLOAT_EQ (geometry.get_cell_volume (cell_id), widths[x] * heights[y]);
+      ASSERT_FLOAT_EQ (geometry.get_cell_center_x (cell_id), columns_centers[x]);
+      ASSERT_FLOAT_EQ (geometry.get_cell_center_y (cell_id), rows_centers[y]);
+      ASSERT_FLOAT_EQ (geometry.get_edge_area (cell_id, side_to_id (side_type::left)), heights[y]);
+      ASSERT_FLOAT_EQ (geometry.get_edge_area (cell_id, side_to_id (side_type::top)), widths[x]);
+      ASSERT_EQ (geometry.get_cell_id_by_coordinates (columns_centers[x], rows_centers[y]), cell_id);
+    }
+  }
+
+  ASSERT_EQ (geometry.get_cell_id_by_coordinates (1.01f, 3.6f), order.get_cell_id (1, 2));
+  ASSERT_EQ (geometry.get_cell_id_by_coordinates (-1.0f, 10.0f), order.get_cell_id (0, 2));
+}
+
+TEST(grid, gl_representation)
+{
+  workspace solver_workspace;
+  const grid solver_grid (solver_workspace, { 1.0, 0.25, 2.0 }, { 0.5, 3.0 }, cells_layout::tiled, 2);
+
+  const auto &representation = solver_grid.get_gl_representation ();
+  ASSERT_EQ (&representation, &solver_grid.get_gl_representation ());
+  ASSERT_EQ (representation.get_elements_count (), solver_grid.get_cells_number ());
+  ASSERT_FLOAT_EQ (representation.get_boundary_box ().width (), 3.25f);
+  ASSERT_FLOAT_EQ (representation.get_boundary_box ().height (), 3.5f);
+
+  /// Second vertex of a pixel is its left bottom corner, elements follow cells order
+  const grid_geometry geometry = solver_grid.gen_geometry_wrapper ();
+  for (unsigned int cell_id = 0; cell_id < solver_grid.get_cells_number (); cell_id++)
+  {
+    const float *left_bottom = representation.data () + (4 * cell_id + 1) * 3;
+    const float width = geometry.get_edge_area (cell_id, side_to_id (side_type::top));
+    const float height = geometry.get_edge_area (cell_id, side_to_id (side_type::left));
+    ASSERT_FLOAT_EQ (left_bottom[0], geometry.get_cell_center_x (cell_id) - width / 2);
+    ASSERT_FLOAT_EQ (left_bottom[1], geometry.get_cell_center_y (cell_id) - height / 2);
+  }
+}
+
+TEST(grid, invariants)
+{
+  workspace solver_workspace;
+
+  const grid rectilinear (solver_workspace, { 1.0, 0.25, 2.0 }, { 0.5, 3.0, 0.125, 1.0 }, cells_layout::morton, 2);
+  ASSERT_FLOAT_EQ (rectilinear.get_min_spacing (), 0.125f);
+  ASSERT_FLOAT_EQ (rectilinear.gen_geometry_wrapper ().get_min_spacing (), 0.125f);
+  ASSERT_DOUBLE_EQ (rectilinear.get_total_volume (), 3.25 * 4.625);
+
+  /// Only the middle column of two inner rows is away from the boundary
+  const grid_topology topology = rectilinear.gen_topology_wrapper ();
+  const auto &boundary_cells = rectilinear.get_boundary_cells ();
+  ASSERT_EQ (boundary_cells.size (), 10u);
+  ASSERT_TRUE (std::is_sorted (boundary_cells.begin (), boundary_cells.end ()));
+  for (auto cell_id: boundary_cells)
+    ASSERT_FALSE (topology.get_cell_x (cell_id) == 1 && topology.get_cell_y (cell_id) > 0 && topology.get_cell_y (cell_id) < 3);
+
+  const unsigned int nx = 4;
+  const unsigned int ny = 3;
+  std::vector<unsigned int> cells (nx * ny);
+  for (unsigned int cell_id = 0; cell_id < nx * ny; cell_id++)
+    cells[cell_id] = cell_id;
+
+  const unstructured_mesh mesh = create_quads_mesh (nx, ny, cells);
+  const grid mesh_grid (solver_workspace, mesh);
+  ASSERT_FLOAT_EQ (mesh_grid.get_min_spacing (), 1.0f);
+  ASSERT_DOUBLE_EQ (mesh_grid.get_total_volume (), nx * ny);
+  ASSERT_EQ (mesh_grid.get_boundary_cells ().size (), 2 * (nx + ny) - 4);
+}
+
+TEST(grid, topology_3d)
+{
+  const unsigned int nx = 4;
+  const unsigned int ny = 3;
+  const unsigned int nz = 5;
+
+  grid_3d_topology topology;
+  topology.initialize_for_structured_uniform_grid (nx, ny, nz);
+
+  grid_3d_geometry geometry;
+  geometry.initialize_for_structured_uniform_grid (nx, ny, nz, 1.0f, 2.0f, 0.5f);
+  ASSERT_FLOAT_EQ (geometry.get_min_spacing (), 0.5f);
+  ASSERT_FLOAT_EQ (geometry.get_face_area (0, face_to_id (face_type::front)), 2.0f);
+
+  for (unsigned int cell_id = 0; cell_id < topology.get_cells_count (); cell_id++)
+  {
+    const unsigned int x = topology.get_cell_x (cell_id);
+    const unsigned int y = topology.get_cell_y (cell_id);
+    const unsigned int z = topology.get_cell_z (cell_id);
+    ASSERT_EQ (topology.get_cell_id (x, y, z), cell_id);
+    ASSERT_EQ (geometry.get_cell_id_by_coordinates (x + 0.5f, 2.0f * y + 1.0f, 0.5f * z + 0.25f), cell_id);
+
+    /// Opposite faces lead back to the cell
+    for (unsigned int face_id = 0; face_id < 3; face_id++)
+    {
+      const unsigned int neighbor_id = topology.get_neighbor_id (cell_id, face_id);
+      ASSERT_EQ (topology.get_neighbor_id (neighbor_id, face_id + 3), cell_id);
+    }
+  }
+
+  ASSERT_EQ (topology.get_neighbor_id (topology.get_cell_id (0, 0, 0), face_to_id (face_type::back)), topology.get_cell_id (0, 0, nz - 1));
+  ASSERT_EQ (topology.get_neighbor_id (topology.get_cell_id (nx - 1, 1, 2), face_to_id (face_type::right)), topology.get_cell_id (0, 1, 2));
+}
+
+TEST(grid, amr_hierarchy)
+{
+  amr_hierarchy hierarchy;
+  hierarchy.initialize (2, 2, 3);
+  ASSERT_EQ (hierarchy.get_leaves ().size (), 4u);
+
+  /// Refinement of a child forces refinement of coarser neighbours, periodic ones included
+  std::vector<unsigned int> refined;
+  ASSERT_FALSE (hierarchy.refine (hierarchy.find_patch (0, 0, 0), refined));
+  const unsigned int child_id = hierarchy.find_patch (1, 0, 0);
+  ASSERT_EQ (hierarchy.get_patch (child_id).level, 1u);
+
+  refined.clear ();
+  ASSERT_FALSE (hierarchy.refine (child_id, refined));
+  ASSERT_EQ (refined.size (), 3u);
+  ASSERT_EQ (refined.back (), child_id);
+  ASSERT_EQ (hierarchy.get_finest_level (), 2u);
+  ASSERT_TRUE (hierarchy.refine (child_id, refined));
+
+  for (auto &leaf: hierarchy.get_leaves ())
+  {
+    const auto &patch = hierarchy.get_patch (leaf);
+    const int offsets[4][2] = { { -1, 0 }, { 0, -1 }, { 1, 0 }, { 0, 1 } };
+
+    for (auto &offset: offsets)
+    {
+      const auto &neighbour = hierarchy.get_patch (hierarchy.find_patch (patch.level, patch.x + offset[0], patch.y + offset[1]));
+      ASSERT_LE (patch.level, neighbour.level + 1);
+    }
+  }
+
+  /// Coarsening of the level 0 patch would leave level 2 leaves next to level 0 leaf
+  ASSERT_FALSE (hierarchy.can_coarsen (hierarchy.get_patch (child_id).parent));
+  ASSERT_TRUE (hierarchy.can_coarsen (child_id));
+
+  const std::size_t leaves_count = hierarchy.get_leaves ().size ();
+  hierarchy.coarsen (child_id);
+  ASSERT_EQ (hierarchy.get_leaves ().size (), leaves_count - 3);
+  ASSERT_EQ (hierarchy.find_patch (3, 1, 1), child_id);
+
+  /// Children ids are reused
+  const std::size_t patches_count = hierarchy.get_patches_count ();
+  refined.clear ();
+  ASSERT_FALSE (hierarchy.refine (child_id, refined));
+  ASSERT_EQ (hierarchy.get_patches_count (), patches_count);
+}
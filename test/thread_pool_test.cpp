@@ -0,0 +1,428 @@
+#include "gtest/gtest.h"
+#include "core/cpu/thread_pool.h"
+#include "core/cpu/adaptive_partition.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static void check_chunks_coverage (thread_pool &threads, unsigned int work_size)
+{
+  std::unique_ptr<std::atomic<unsigned int>[]> visits (new std::atomic<unsigned int>[work_size]);
+  for (unsigned int i = 0; i < work_size; i++)
+    visits[i] = 0;
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    /// Two calls without barrier in between mustn't mix their tiles
+    for (unsigned int pass = 0; pass < 2; pass++)
+      threads.for_each_chunk (thread_id, work_size, [&] (const work_range &range) {
+        for (unsigned int i = range.chunk_begin; i < range.chunk_end; i++)
+          visits[i]++;
+      });
+  });
+
+  for (unsigned int i = 0; i < work_size; i++)
+    ASSERT_EQ (visits[i].load (), 2u);
+}
+
+TEST(thread_pool, static_split_chunks)
+{
+  thread_pool threads (4);
+
+  for (unsigned int work_size: { 0u, 1u, 3u, 4u, 1000u, 65537u })
+    check_chunks_coverage (threads, work_size);
+}
+
+TEST(thread_pool, work_stealing_chunks)
+{
+  thread_pool threads (4);
+  threads.set_scheduling_policy (scheduling_policy::work_stealing, 16);
+
+  ASSERT_EQ (threads.get_scheduling_policy (), scheduling_policy::work_stealing);
+
+  for (unsigned int work_size: { 0u, 1u, 3u, 4u, 1000u, 65537u })
+    check_chunks_coverage (threads, work_size);
+
+  /// Ends of tiles close to the limit of unsigned int don't overflow
+  threads.set_scheduling_policy (scheduling_policy::work_stealing, 1u << 31u);
+  const unsigned int large_work_size = std::numeric_limits<unsigned int>::max () - 1;
+  std::atomic<std::uint64_t> covered (0);
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    threads.for_each_chunk (thread_id, large_work_size, [&] (const work_range &range) {
+      if (range.chunk_begin < range.chunk_end)
+        covered += range.chunk_end - range.chunk_begin;
+    });
+  });
+
+  ASSERT_EQ (covered.load (), large_work_size);
+
+  /// Loops smaller than a tile are still cut into tiles for every thread, explicit grain sets tiles size
+  threads.set_scheduling_policy (scheduling_policy::work_stealing);
+  for (unsigned int grain: { 0u, 1u, 3u })
+  {
+    const unsigned int small_work_size = 10;
+    std::atomic<unsigned int> small_covered (0);
+    std::atomic<unsigned int> max_tile (0);
+
+    threads.execute ([&] (unsigned int thread_id, unsigned int) {
+      threads.for_each_chunk (thread_id, small_work_size, [&] (const work_range &range) {
+        const unsigned int tile = range.chunk_end - range.chunk_begin;
+        small_covered += tile;
+
+        unsigned int current = max_tile.load ();
+        while (current < tile && !max_tile.compare_exchange_weak (current, tile)) { }
+      }, grain);
+    });
+
+    ASSERT_EQ (small_covered.load (), small_work_size);
+    ASSERT_EQ (max_tile.load (), std::max (1u, grain));
+  }
+}
+
+static void check_barrier (thread_pool &threads, unsigned int threads_count)
+{
+  const unsigned int phases_count = 16;
+  std::atomic<unsigned int> arrived (0);
+  std::atomic<unsigned int> errors (0);
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    for (unsigned int phase = 0; phase < phases_count; phase++)
+    {
+      arrived++;
+      threads.barrier (thread_id);
+      if (arrived.load () != (phase + 1) * threads_count)
+        errors++;
+      threads.barrier (thread_id);
+    }
+  });
+
+  ASSERT_EQ (errors.load (), 0u);
+}
+
+TEST(thread_pool, barriers)
+{
+  for (unsigned int threads_count: { 1u, 2u, 5u })
+  {
+    thread_pool threads (threads_count);
+    check_barrier (threads, threads_count);
+
+    for (unsigned int fan_in: { 2u, 4u })
+    {
+      threads.set_barrier_type (barrier_type::combining_tree, fan_in);
+      ASSERT_EQ (threads.get_barrier_type (), barrier_type::combining_tree);
+      check_barrier (threads, threads_count);
+    }
+  }
+}
+
+TEST(thread_pool, parked_threads)
+{
+  /// Waiters go straight to futex, so every execute and barrier wakes parked threads
+  idle_policy policy;
+  policy.spin_time = std::chrono::microseconds (0);
+  policy.yield_time = std::chrono::microseconds (0);
+  policy.adaptive = false;
+
+  thread_pool threads (3);
+  threads.set_idle_policy (policy);
+
+  for (unsigned int iteration = 0; iteration < 4; iteration++)
+    check_barrier (threads, 3);
+
+  threads.set_barrier_type (barrier_type::combining_tree, 2);
+  check_barrier (threads, 3);
+}
+
+TEST(thread_pool, neighbours_sync)
+{
+  const unsigned int threads_count = 4;
+  const unsigned int halo_size = 3;
+  const unsigned int phases_count = 16;
+
+  for (unsigned int work_size: { threads_count * halo_size * 2, 5u })
+  {
+    thread_pool threads (threads_count);
+    std::vector<std::atomic<unsigned int>> phases (work_size);
+    std::atomic<unsigned int> errors (0);
+
+    threads.execute ([&] (unsigned int thread_id, unsigned int) {
+      const auto range = work_range::split (work_size, thread_id, threads_count);
+
+      for (unsigned int phase = 1; phase <= phases_count; phase++)
+      {
+        for (unsigned int i = range.chunk_begin; i < range.chunk_end; i++)
+          phases[i] = phase;
+
+        threads.neighbours_sync (thread_id, work_size, halo_size);
+
+        /// Halo of the slice is already written in this phase and not yet overwritten by the next one
+        for (unsigned int offset = 1; offset <= halo_size; offset++)
+        {
+          if (phases[(range.chunk_begin + work_size - offset) % work_size] != phase)
+            errors++;
+          if (phases[(range.chunk_end - 1 + offset) % work_size] != phase)
+            errors++;
+        }
+
+        threads.neighbours_sync (thread_id, work_size, halo_size);
+      }
+    });
+
+    ASSERT_EQ (errors.load (), 0u);
+  }
+}
+
+struct mean_value
+{
+  double sum;
+  unsigned int count;
+};
+
+/// Hexadecimal digits of threads ids in the order of the fold
+struct digits_value
+{
+  unsigned int digits;
+  unsigned int count;
+};
+
+static void check_reductions (thread_pool &threads, unsigned int threads_count)
+{
+  std::atomic<unsigned int> errors (0);
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    /// Back to back calls reuse reduction slots
+    for (unsigned int iteration = 0; iteration < 3; iteration++)
+    {
+      unsigned int sum = thread_id + iteration;
+      threads.reduce_sum (thread_id, sum);
+      if (sum != threads_count * (threads_count - 1) / 2 + iteration * threads_count)
+        errors++;
+
+      std::tuple<int, int, double> min_max_sum (thread_id, thread_id, 0.5);
+      threads.reduce (thread_id, min_max_sum, tuple_operation (min_operation {}, max_operation {}, sum_operation {}));
+      if (min_max_sum != std::make_tuple (0, static_cast<int> (threads_count - 1), 0.5 * threads_count))
+        errors++;
+
+      mean_value mean { static_cast<double> (thread_id), 1 };
+      threads.reduce (thread_id, mean, [] (const mean_value &l, const mean_value &r) {
+        return mean_value { l.sum + r.sum, l.count + r.count };
+      });
+      if (mean.count != threads_count || mean.sum / mean.count != (threads_count - 1) / 2.0)
+        errors++;
+
+      /// Digits of threads ids are concatenated, so the result depends on the order of the fold
+      digits_value digits { thread_id, 1 };
+      threads.reduce (thread_id, digits, [] (const digits_value &l, const digits_value &r) {
+        return digits_value { l.digits * (1u << (4 * r.count)) + r.digits, l.count + r.count };
+      });
+      unsigned int expected_digits = 0;
+      for (unsigned int id = 0; id < threads_count; id++)
+        expected_digits = expected_digits * 16 + id;
+      if (digits.count != threads_count || digits.digits != expected_digits)
+        errors++;
+    }
+  });
+
+  ASSERT_EQ (errors.load (), 0u);
+}
+
+TEST(thread_pool, reductions)
+{
+  for (unsigned int threads_count: { 1u, 2u, 5u })
+  {
+    thread_pool threads (threads_count);
+    check_reductions (threads, threads_count);
+
+    for (unsigned int fan_in: { 2u, 4u })
+    {
+      threads.set_barrier_type (barrier_type::combining_tree, fan_in);
+      check_reductions (threads, threads_count);
+    }
+  }
+}
+
+TEST(thread_pool, teams)
+{
+  thread_pool threads (5);
+
+  ASSERT_TRUE (threads.set_teams ({ { "compute", 3 }, { "io", 1 } }));
+  ASSERT_FALSE (threads.set_teams ({ { "compute", 3 }, { "io", 2 } }));
+  ASSERT_EQ (threads.find_team ("io"), 1u);
+  ASSERT_EQ (threads.find_team ("gui"), 2u);
+
+  for (auto type: { barrier_type::centralized, barrier_type::combining_tree })
+  {
+    threads.set_barrier_type (type, 2);
+
+    std::atomic<unsigned int> errors (0);
+    std::atomic<unsigned int> io_visits (0);
+
+    threads.execute ([&] (unsigned int thread_id, unsigned int) {
+      const bool is_io = threads.get_team_id (thread_id) == threads.find_team ("io");
+      const unsigned int team_threads_count = is_io ? 2 : 3;
+
+      if (threads.get_team_threads_count (thread_id) != team_threads_count)
+        errors++;
+
+      /// Teams make different number of calls
+      for (unsigned int iteration = 0; iteration < (is_io ? 5u : 2u); iteration++)
+      {
+        unsigned int team_thread_id = threads.get_team_thread_id (thread_id);
+        threads.reduce_sum (thread_id, team_thread_id);
+        if (team_thread_id != team_threads_count * (team_threads_count - 1) / 2)
+          errors++;
+
+        if (is_io)
+        {
+          threads.for_each_chunk (thread_id, 100, [&] (const work_range &range) {
+            io_visits += range.chunk_end - range.chunk_begin;
+          });
+          threads.barrier (thread_id);
+        }
+      }
+    });
+
+    ASSERT_EQ (errors.load (), 0u);
+    ASSERT_EQ (io_visits.load (), 500u);
+  }
+}
+
+TEST(thread_pool, adaptive_partition)
+{
+  const unsigned int threads_count = 3;
+  const unsigned int work_size = 3000;
+  const unsigned int min_chunk_size = 100;
+  const unsigned int calls_count = 40;
+
+  thread_pool threads (threads_count);
+  threads.set_scheduling_policy (scheduling_policy::adaptive_split);
+
+  adaptive_partition partition (threads_count, 4);
+  partition.reset (min_chunk_size);
+
+  std::vector<std::atomic<unsigned int>> visits (work_size);
+  std::atomic<unsigned int> errors (0);
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    for (unsigned int call = 0; call < calls_count; call++)
+    {
+      partition.for_each_chunk (threads, thread_id, work_size, [&] (const work_range &range) {
+        if (range.chunk_end - range.chunk_begin < min_chunk_size)
+          errors++;
+
+        /// Skewed cost makes the first thread slower
+        for (unsigned int i = range.chunk_begin; i < range.chunk_end; i++)
+        {
+          visits[i]++;
+          for (volatile unsigned int spin = 0; spin < (i < work_size / 3 ? 200u : 1u); spin++) { }
+        }
+      });
+    }
+  });
+
+  ASSERT_EQ (errors.load (), 0u);
+  for (unsigned int i = 0; i < work_size; i++)
+    ASSERT_EQ (visits[i].load (), calls_count);
+
+  unsigned int covered = 0;
+  for (unsigned int thread_id = 0; thread_id < threads_count; thread_id++)
+  {
+    const auto chunk = partition.get_chunk (thread_id, threads_count, work_size);
+    ASSERT_EQ (chunk.chunk_begin, covered);
+    covered = chunk.chunk_end;
+  }
+  ASSERT_EQ (covered, work_size);
+}
+
+TEST(thread_pool, telemetry)
+{
+  thread_pool threads (3);
+  threads.set_telemetry (true);
+  threads.reset_telemetry ();
+
+  threads.execute ([&] (unsigned int thread_id, unsigned int) {
+    for (unsigned int phase = 0; phase < 3; phase++)
+      threads.barrier (thread_id);
+  });
+
+  for (unsigned int thread_id = 0; thread_id < 3; thread_id++)
+  {
+    const auto &telemetry = threads.get_telemetry (thread_id);
+    ASSERT_EQ (telemetry.barrier_episodes, 3u);
+    ASSERT_GE (telemetry.action_ticks, telemetry.barrier_ticks);
+  }
+
+  threads.reset_telemetry ();
+  ASSERT_EQ (threads.get_telemetry (0).barrier_episodes, 0u);
+}
+
+TEST(thread_pool, combining_tree_barrier_numa_groups)
+{
+  const std::vector<unsigned int> threads_numa_nodes { 1, 0, 1, 0, 0, 2, 1 };
+  const unsigned int threads_count = threads_numa_nodes.size ();
+
+  combining_tree_barrier tree (threads_numa_nodes, 2);
+  std::vector<unsigned int> values (threads_count);
+  std::atomic<unsigned int> errors (0);
+
+  auto run = [&] (unsigned int thread_id) {
+    for (unsigned int phase = 0; phase < 8; phase++)
+    {
+      values[thread_id] = thread_id + phase;
+      tree.wait (thread_id, [&] (unsigned int target, const unsigned int *sources_begin, const unsigned int *sources_end) {
+        for (const unsigned int *source = sources_begin; source != sources_end; source++)
+          if (*source != target)
+            values[target] += values[*source];
+      });
+      if (values[tree.get_root_thread ()] != threads_count * (threads_count - 1) / 2 + phase * threads_count)
+        errors++;
+      tree.wait (thread_id);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int thread_id = 1; thread_id < threads_count; thread_id++)
+    threads.emplace_back (run, thread_id);
+  run (0);
+
+  for (auto &thread: threads)
+    thread.join ();
+
+  ASSERT_EQ (errors.load (), 0u);
+}
+
+TEST(thread_pool, fill)
+{
+  thread_pool threads (3);
+
+  const unsigned int count = 1001;
+  std::vector<double> data (count, 0.0);
+  threads.fill (data.data (), count, 42.0);
+
+  for (auto &value: data)
+    ASSERT_EQ (value, 42.0);
+
+  /// Only compute team touches data, in chunks of its team-local split of items
+  threads.set_teams ({ { "compute", 2 }, { "extraction", 1 } });
+
+  const unsigned int item_size = 7;
+  std::mutex ranges_lock;
+  std::vector<std::pair<unsigned int, unsigned int>> ranges;
+  threads.execute_first_touch (count / item_size, [&] (const work_range &range) {
+    std::lock_guard guard (ranges_lock);
+    ranges.emplace_back (range.chunk_begin, range.chunk_end);
+  }, adaptive_partition (threads.get_threads_count ()), item_size);
+
+  std::sort (ranges.begin (), ranges.end ());
+  const unsigned int second_chunk_begin = work_range::split (count / item_size, 1, 2).chunk_begin * item_size;
+  ASSERT_EQ (ranges.size (), 2u);
+  ASSERT_EQ (ranges[0], std::make_pair (0u, second_chunk_begin));
+  ASSERT_EQ (ranges[1], std::make_pair (second_chunk_begin, count));
+
+  threads.fill (data.data (), count, 7.0, thread_pool::team_split {}, item_size);
+  for (auto &value: data)
+    ASSERT_EQ (value, 7.0);
+}